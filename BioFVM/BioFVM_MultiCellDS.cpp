@@ -1372,9 +1372,11 @@ void read_microenvironment_from_MultiCellDS_xml( Microenvironment& M_destination
 		{
 			// attempt to read it in as XML data, voxel by voxel 
 			node = node.child( "density_vector" ); 
+			std::vector<double> temp_density; 
 			for( unsigned int j=0 ; j < M_destination.mesh.voxels.size() ; j++ )
 			{
-				csv_to_vector( node.first_child().value() , M_destination.density_vector(j)  ); 
+				csv_to_vector( node.first_child().value() , temp_density ); 
+				M_destination.density_vector(j) = temp_density; 
 				if( node.next_sibling( "density_vector" ) ) 
 				{ node = node.next_sibling( "density_vector" ); }		
 			}
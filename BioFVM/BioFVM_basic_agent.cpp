@@ -56,18 +56,6 @@ std::vector<Basic_Agent*> all_basic_agents(0);
 
 Basic_Agent::Basic_Agent()
 {
-	//give the agent a unique ID  
-	static int max_basic_agent_ID = 0; 
-	ID = max_basic_agent_ID; // 
-	max_basic_agent_ID++; 
-	// initialize position and velocity
-	is_active=true;
-	
-	volume = 1.0; 
-	
-	position.assign( 3 , 0.0 ); 
-	velocity.assign( 3 , 0.0 );
-	previous_velocity.assign( 3 , 0.0 ); 
 	// link into the microenvironment, if one is defined 
 	secretion_rates= new std::vector<double>(0);
 	uptake_rates= new std::vector<double>(0);
@@ -79,12 +67,49 @@ Basic_Agent::Basic_Agent()
 	internalized_substrates = new std::vector<double>(0); // 
 	fraction_released_at_death = new std::vector<double>(0); 
 	fraction_transferred_when_ingested = new std::vector<double>(0); 
+	
+	reset(); 
+	
+	return;	
+}
+
+void Basic_Agent::reset( void )
+{
+	//give the agent a unique ID  
+	static int max_basic_agent_ID = 0; 
+	// (agents can be created in parallel, e.g. in batched divisions) 
+	#pragma omp atomic capture 
+	ID = max_basic_agent_ID++; 
+	// initialize position and velocity
+	is_active=true;
+	
+	volume = 1.0; 
+	
+	position.assign( 3 , 0.0 ); 
+	velocity.assign( 3 , 0.0 );
+	previous_velocity.assign( 3 , 0.0 ); 
+	
+	// empty the rate and solver vectors (keeping their memory), so that 
+	// register_microenvironment sizes and fills them as for a new agent 
+	secretion_rates->clear(); 
+	uptake_rates->clear(); 
+	saturation_densities->clear(); 
+	net_export_rates->clear(); 
+	internalized_substrates->clear(); 
+	fraction_released_at_death->clear(); 
+	fraction_transferred_when_ingested->clear(); 
+	cell_source_sink_solver_temp1.clear(); 
+	cell_source_sink_solver_temp2.clear(); 
+	cell_source_sink_solver_temp_export1.clear(); 
+	cell_source_sink_solver_temp_export2.clear(); 
+	total_extracellular_substrate_change.clear(); 
+	
 	register_microenvironment( get_default_microenvironment() );
 	
 	// these are done in register_microenvironment
 	// internalized_substrates.assign( get_default_microenvironment()->number_of_densities() , 0.0 ); 
 	
-	return;	
+	return; 
 }
 
 void Basic_Agent::update_position(double dt){ 
@@ -271,7 +296,7 @@ int Basic_Agent::get_current_voxel_index( void )
 	return current_voxel_index;
 }
 
-std::vector<double>& Basic_Agent::nearest_density_vector( void ) 
+Density_Vector_View Basic_Agent::nearest_density_vector( void ) 
 {  
 	return microenvironment->nearest_density_vector( current_voxel_index ); 
 }
@@ -280,13 +305,20 @@ std::vector<double>& Basic_Agent::nearest_density_vector( void )
 // directly access the gradient of substrate n nearest to the cell 
 std::vector<double>& Basic_Agent::nearest_gradient( int substrate_index )
 {
-	return microenvironment->gradient_vector(current_voxel_index)[substrate_index]; 
+	if( nearest_gradients.size() != microenvironment->number_of_densities() )
+	{ nearest_gradients.assign( microenvironment->number_of_densities() , std::vector<double>(3,0.0) ); }
+	
+	const double* pGradient = microenvironment->substrate_gradient( current_voxel_index , substrate_index ); 
+	nearest_gradients[substrate_index].assign( pGradient , pGradient+3 ); 
+	return nearest_gradients[substrate_index]; 
 }
 
 	// directly access a vector of gradients, one gradient per substrate 
 std::vector<gradient>& Basic_Agent::nearest_gradient_vector( void )
 {
-	return microenvironment->gradient_vector(current_voxel_index); 
+	for( unsigned int q=0; q < microenvironment->number_of_densities() ; q++ )
+	{ nearest_gradient( q ); }
+	return nearest_gradients; 
 }
 
 void Basic_Agent::set_total_volume(double volume)
@@ -311,12 +343,34 @@ void Basic_Agent::simulate_secretion_and_uptake( Microenvironment* pS, double dt
 		volume_is_changed = false;
 	}
 	
+	// new in 1.7.2: the steady-state solver already includes the sources and sinks, 
+	// so only track what the cell took up (or released) during dt 
+	if( pS->steady_state_diffusion() )
+	{
+		if( default_microenvironment_options.track_internalized_substrates_in_each_agent == true )
+		{
+			Density_Vector_View rho = (*pS)(current_voxel_index); 
+			for( unsigned int i=0; i < rho.size() ; i++ ) // c1 - (c2-1)*rho 
+			{
+				total_extracellular_substrate_change[i] = cell_source_sink_solver_temp1[i] 
+					- ( cell_source_sink_solver_temp2[i] - 1.0 ) * rho[i]; 
+			}
+			total_extracellular_substrate_change *= pS->voxels(current_voxel_index).volume; 
+			
+			*internalized_substrates -= total_extracellular_substrate_change; 
+			*internalized_substrates -= cell_source_sink_solver_temp_export1; 
+		}
+		return; 
+	}
+	
 	if( default_microenvironment_options.track_internalized_substrates_in_each_agent == true )
 	{
 		total_extracellular_substrate_change.assign( total_extracellular_substrate_change.size() , 1.0 ); // 1
 
 		total_extracellular_substrate_change -= cell_source_sink_solver_temp2; // 1-c2
-		total_extracellular_substrate_change *= (*pS)(current_voxel_index); // (1-c2)*rho 
+		Density_Vector_View rho = (*pS)(current_voxel_index); 
+		for( unsigned int i=0; i < rho.size() ; i++ ) // (1-c2)*rho 
+		{ total_extracellular_substrate_change[i] *= rho[i]; }
 		total_extracellular_substrate_change += cell_source_sink_solver_temp1; // (1-c2)*rho+c1 
 		total_extracellular_substrate_change /= cell_source_sink_solver_temp2; // ((1-c2)*rho+c1)/c2
 		total_extracellular_substrate_change *= pS->voxels(current_voxel_index).volume; // W*((1-c2)*rho+c1)/c2 
@@ -77,6 +77,9 @@ class Basic_Agent
 	
 	std::vector<double> total_extracellular_substrate_change; 
 	
+	// the gradients returned by nearest_gradient(), copied from the microenvironment -- 1.7.2 
+	std::vector<gradient> nearest_gradients; 
+	
  public:
 	bool is_active;
 
@@ -111,6 +114,9 @@ class Basic_Agent
 	void update_position( double dt );
 	
 	Basic_Agent(); 
+	// return the agent to the state of a newly constructed one (with a new ID), 
+	// keeping the memory of its vectors, so that it can be reused -- 1.7.2 
+	void reset( void ); 
 
 	// simulate secretion and uptake at the nearest voxel at the indicated microenvironment.
 	// if no microenvironment indicated, use the currently selected microenvironment. 
@@ -118,8 +124,8 @@ class Basic_Agent
 
 	int get_current_voxel_index( void ); 
 	// directly access the substrate vector at the nearest voxel at the indicated microenvironment 
-	std::vector<double>& nearest_density_vector( int microenvironment_index ); // not implemented!
-	std::vector<double>& nearest_density_vector( void );
+	Density_Vector_View nearest_density_vector( int microenvironment_index ); // not implemented!
+	Density_Vector_View nearest_density_vector( void );
 	
 	// directly access the gradient of substrate n nearest to the cell 
 	std::vector<double>& nearest_gradient( int substrate_index );
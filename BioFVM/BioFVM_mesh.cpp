@@ -46,6 +46,8 @@
 #############################################################################
 */
 
+#include <algorithm> 
+
 #include "BioFVM_vector.h" 
 #include "BioFVM_mesh.h" 
 
@@ -379,6 +381,7 @@ Cartesian_Mesh::Cartesian_Mesh()
 	uniform_mesh = true; 
 	regular_mesh = true; 
 	use_voxel_faces = false; 
+	implicit_voxels = false; 
 	
 	x_coordinates.assign( 1 , 0.0 ); 
 	y_coordinates.assign( 1 , 0.0 ); 
@@ -480,6 +483,7 @@ Cartesian_Mesh::Cartesian_Mesh( int xnodes, int ynodes, int znodes )
 	uniform_mesh = true; 
 	regular_mesh = true; 
 	use_voxel_faces = false; 
+	implicit_voxels = false; 
  
 	for( unsigned int i=0; i < x_coordinates.size() ; i++ )
 	{ x_coordinates[i] = i*dx; }
@@ -665,6 +669,13 @@ void Cartesian_Mesh::resize( double x_start, double x_end, double y_start, doubl
 	dS_xy = dx*dy; 
 	dS_yz = dy*dz; 
 	dS_xz = dx*dz; 
+	
+	// everything else is derived from the coordinates as needed 
+	if( implicit_voxels )
+	{
+		release_voxel_storage(); 
+		return; 
+	}
 
 	Voxel template_voxel;
 	template_voxel.volume = dV; 
@@ -788,6 +799,13 @@ void Cartesian_Mesh::resize( double x_start, double x_end, double y_start, doubl
 	dS_yz = dy*dz; 
 	dS_xz = dx*dz; 
 	
+	// everything else is derived from the coordinates as needed 
+	if( implicit_voxels )
+	{
+		release_voxel_storage(); 
+		return; 
+	}
+
 	Voxel template_voxel;
 	template_voxel.volume = dV; 
 
@@ -922,6 +940,136 @@ std::vector<unsigned int> Cartesian_Mesh::nearest_cartesian_indices( std::vector
 Voxel& Cartesian_Mesh::nearest_voxel( std::vector<double>& position )
 { return voxels[ nearest_voxel_index( position ) ]; }
 
+void Cartesian_Mesh::release_voxel_storage( void )
+{
+	// swap with empty containers, so that the memory is returned 
+	std::vector<Voxel>().swap( voxels ); 
+	std::vector<Voxel_Face>().swap( voxel_faces ); 
+	std::vector< std::vector<int> >().swap( connected_voxel_indices ); 
+	std::vector< std::vector<int> >().swap( moore_connected_voxel_indices ); 
+	return; 
+}
+
+unsigned int Cartesian_Mesh::number_of_voxels( void )
+{ return x_coordinates.size() * y_coordinates.size() * z_coordinates.size(); }
+
+void Cartesian_Mesh::voxel_center( int n , double* center )
+{
+	if( !implicit_voxels )
+	{
+		std::vector<double>& stored = voxels[n].center; 
+		center[0] = stored[0]; 
+		center[1] = stored[1]; 
+		center[2] = stored[2]; 
+		return; 
+	}
+	unsigned int nx = x_coordinates.size(); 
+	unsigned int ny = y_coordinates.size(); 
+	center[0] = x_coordinates[ n % nx ]; 
+	center[1] = y_coordinates[ ( n / nx ) % ny ]; 
+	center[2] = z_coordinates[ n / ( nx * ny ) ]; 
+	return; 
+}
+
+std::vector<double> Cartesian_Mesh::voxel_center( int n )
+{
+	std::vector<double> center( 3 , 0.0 ); 
+	voxel_center( n , center.data() ); 
+	return center; 
+}
+
+double Cartesian_Mesh::voxel_volume( int n )
+{
+	if( !implicit_voxels )
+	{ return voxels[n].volume; }
+	return dV; 
+}
+
+int Cartesian_Mesh::face_neighbors( int n , int* neighbors )
+{
+	if( !implicit_voxels )
+	{
+		std::vector<int>& connected = connected_voxel_indices[n]; 
+		std::copy( connected.begin() , connected.end() , neighbors ); 
+		return connected.size(); 
+	}
+	
+	// as the x-, y-, and z-aligned connections are made in resize() 
+	int nx = x_coordinates.size(); 
+	int ny = y_coordinates.size(); 
+	int nz = z_coordinates.size(); 
+	int i = n % nx; 
+	int j = ( n / nx ) % ny; 
+	int k = n / ( nx * ny ); 
+	int count = 0; 
+	if( i > 0 ){ neighbors[count++] = n - 1; }
+	if( i < nx-1 ){ neighbors[count++] = n + 1; }
+	if( j > 0 ){ neighbors[count++] = n - nx; }
+	if( j < ny-1 ){ neighbors[count++] = n + nx; }
+	if( k > 0 ){ neighbors[count++] = n - nx*ny; }
+	if( k < nz-1 ){ neighbors[count++] = n + nx*ny; }
+	return count; 
+}
+
+int Cartesian_Mesh::moore_neighbors( int n , int* neighbors )
+{
+	if( !implicit_voxels && moore_connected_voxel_indices.size() > 0 )
+	{
+		std::vector<int>& moore = moore_connected_voxel_indices[n]; 
+		std::copy( moore.begin() , moore.end() , neighbors ); 
+		return moore.size(); 
+	}
+	
+	// as in create_moore_neighborhood, in the same order 
+	int nx = x_coordinates.size(); 
+	int ny = y_coordinates.size(); 
+	int nz = z_coordinates.size(); 
+	int i = n % nx; 
+	int j = ( n / nx ) % ny; 
+	int k = n / ( nx * ny ); 
+	int count = 0; 
+	for( int ii=-1; ii <= 1 ; ii++ )
+	{
+		if( i+ii < 0 || i+ii >= nx )
+		{ continue; }
+		for( int jj=-1; jj <= 1 ; jj++ )
+		{
+			if( j+jj < 0 || j+jj >= ny )
+			{ continue; }
+			for( int kk=-1; kk <= 1 ; kk++ )
+			{
+				if( k+kk < 0 || k+kk >= nz || ( ii == 0 && jj == 0 && kk == 0 ) )
+				{ continue; }
+				neighbors[count++] = n + ii + nx*( jj + ny*kk ); 
+			}
+		}
+	}
+	return count; 
+}
+
+double Cartesian_Mesh::memory_footprint_megabytes( void )
+{
+	double bytes = ( x_coordinates.capacity() + y_coordinates.capacity() + z_coordinates.capacity() ) * sizeof(double); 
+	
+	bytes += voxels.capacity() * sizeof(Voxel); 
+	for( unsigned int n=0; n < voxels.size() ; n++ )
+	{ bytes += voxels[n].center.capacity() * sizeof(double); }
+	bytes += voxel_faces.capacity() * sizeof(Voxel_Face); 
+	for( unsigned int n=0; n < voxel_faces.size() ; n++ )
+	{
+		bytes += ( voxel_faces[n].center.capacity() + voxel_faces[n].outward_normal.capacity() 
+			+ voxel_faces[n].inward_normal.capacity() ) * sizeof(double); 
+	}
+	bytes += connected_voxel_indices.capacity() * sizeof( std::vector<int> ); 
+	for( unsigned int n=0; n < connected_voxel_indices.size() ; n++ )
+	{ bytes += connected_voxel_indices[n].capacity() * sizeof(int); }
+	bytes += moore_connected_voxel_indices.capacity() * sizeof( std::vector<int> ); 
+	for( unsigned int n=0; n < moore_connected_voxel_indices.size() ; n++ )
+	{ bytes += moore_connected_voxel_indices[n].capacity() * sizeof(int); }
+	
+	return bytes / ( 1024.0 * 1024.0 ); 
+}
+
 void Cartesian_Mesh::display_information( std::ostream& os )
 {
 	os << std::endl << "Mesh information: " << std::endl;
@@ -945,7 +1093,7 @@ void Cartesian_Mesh::display_information( std::ostream& os )
 			<< ", dz = " << dz << " " << units ; 
 	}
 	os << std::endl 
-	<< "   voxels: " << voxels.size() << std::endl
+	<< "   voxels: " << number_of_voxels() << ( implicit_voxels ? " (implicit)" : "" ) << std::endl
 	<< "   voxel faces: " << voxel_faces.size() << std::endl
 	<< "   volume: " << ( bounding_box[3]-bounding_box[0] )*( bounding_box[4]-bounding_box[1] )*( bounding_box[5]-bounding_box[2] ) 
 		<< " cubic " << units << std::endl; 	
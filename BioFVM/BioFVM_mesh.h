@@ -166,6 +166,7 @@ class General_Mesh
 class Cartesian_Mesh : public General_Mesh
 {
  private:
+	void release_voxel_storage( void ); 
  
  public:
 	std::vector<double> x_coordinates; 
@@ -206,6 +207,25 @@ class Cartesian_Mesh : public General_Mesh
 	void display_information( std::ostream& os ); 
 	
 	void read_from_matlab( std::string filename ); 
+	
+	/* (new in 1.7.2) With implicit_voxels set before resize(), the mesh only keeps 
+	   its coordinates: voxels, voxel_faces, connected_voxel_indices, and 
+	   moore_connected_voxel_indices stay empty (and nearest_voxel is unavailable). 
+	   The accessors below derive each voxel's center, volume, and neighbors from 
+	   its (i,j,k) indices instead, and work the same on either kind of mesh. */ 
+	bool implicit_voxels; 
+	
+	unsigned int number_of_voxels( void ); 
+	void voxel_center( int n , double* center ); 
+	std::vector<double> voxel_center( int n ); 
+	double voxel_volume( int n ); 
+	// the face neighbors (up to 6) and Moore neighbors (up to 26) of voxel n, in 
+	// the order of connected_voxel_indices and moore_connected_voxel_indices. 
+	// neighbors must have room for them; returns how many there are. 
+	int face_neighbors( int n , int* neighbors ); 
+	int moore_neighbors( int n , int* neighbors ); 
+	
+	double memory_footprint_megabytes( void ); 
 };
 
 class Voronoi_Mesh : public General_Mesh
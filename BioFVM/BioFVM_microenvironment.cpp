@@ -114,6 +114,21 @@ Microenvironment::Microenvironment()
 	bulk_source_sink_solver_setup_done = false; 
 	thomas_setup_done = false; 
 	diffusion_solver_setup_done = false; 
+	blocked_diffusion_sweeps = true; 
+	dirichlet_node_list_stale = true; 
+	dirichlet_nodes_changed = true; 
+	variable_coefficients_changed = true; 
+	variable_thomas_dt = 0.0; 
+	diffusion_step_count = 0; 
+	steady_state_tolerance = 1e-6; 
+	steady_state_max_cycles = 50; 
+	steady_state_cycles = 0; 
+	active_region_tolerance = 0.0; 
+	active_region_stale = true; 
+	last_skipped_voxel_fraction = 0.0; 
+	total_skipped_voxel_fraction = 0.0; 
+	active_region_steps = 0; 
+	dct_factors_dt = 0.0; 
 
 	diffusion_decay_solver = empty_diffusion_solver;
 	diffusion_decay_solver = diffusion_decay_solver__constant_coefficients_LOD_3D; 
@@ -123,17 +138,12 @@ Microenvironment::Microenvironment()
 	one.resize( 1 , 1.0 ); 
 	zero.resize( 1 , 0.0 );
 	
-	temporary_density_vectors1.resize( mesh.voxels.size() , zero ); 
-	temporary_density_vectors2.resize( mesh.voxels.size() , zero ); 
+	temporary_density_vectors1.resize( mesh.voxels.size() , zero.size() ); 
+	temporary_density_vectors2.resize( mesh.voxels.size() , zero.size() ); 
 	p_density_vectors = &temporary_density_vectors1;
 
-	gradient_vectors.resize( mesh.voxels.size() ); 
-	for( unsigned int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( 1 ); 
-		(gradient_vectors[k])[0].resize( 3, 0.0 );
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 
+	gradient_generation = 1; 
+	resize_gradient_storage(); 
 
 	bulk_supply_rate_function = zero_function; 
 	bulk_supply_target_densities_function = zero_function; 
@@ -144,6 +154,7 @@ Microenvironment::Microenvironment()
 
 	diffusion_coefficients.assign( number_of_densities() , 0.0 ); 
 	decay_rates.assign( number_of_densities() , 0.0 ); 
+	diffusion_step_multiples.assign( number_of_densities() , 1 ); 
 	
 	one_half = one; 
 	one_half *= 0.5; 
@@ -155,6 +166,7 @@ Microenvironment::Microenvironment()
 	dirichlet_activation_vector.assign( 1 , true ); 
 	
 	dirichlet_activation_vectors.assign( 1 , dirichlet_activation_vector ); 
+	dirichlet_node_list_stale = true; 
 	
 	default_microenvironment_options.Dirichlet_all.assign( 1 , true ); 
 	default_microenvironment_options.Dirichlet_xmin.assign( 1 , false ); 
@@ -185,15 +197,75 @@ Microenvironment::Microenvironment(std::string name)
 	return; 
 }
 
+void Microenvironment::register_dirichlet_node( int voxel_index )
+{
+	dirichlet_nodes_changed = true; 
+	if( dirichlet_node_list_stale || dirichlet_node_map[voxel_index] >= 0 )
+	{ return; }
+	
+	dirichlet_node_map[voxel_index] = dirichlet_indices.size(); 
+	dirichlet_indices.push_back( voxel_index ); 
+	return; 
+}
+
+void Microenvironment::unregister_dirichlet_node( int voxel_index )
+{
+	dirichlet_nodes_changed = true; 
+	if( dirichlet_node_list_stale || dirichlet_node_map[voxel_index] < 0 )
+	{ return; }
+	
+	// swap with the last node, then pop 
+	int position = dirichlet_node_map[voxel_index]; 
+	int last = dirichlet_indices.back(); 
+	dirichlet_indices[position] = last; 
+	dirichlet_node_map[last] = position; 
+	dirichlet_indices.pop_back(); 
+	dirichlet_node_map[voxel_index] = -1; 
+	return; 
+}
+
+void Microenvironment::update_dirichlet_node_list( void )
+{
+	if( dirichlet_node_list_stale )
+	{
+		dirichlet_indices.clear(); 
+		dirichlet_node_map.assign( mesh.voxels.size() , -1 ); 
+		for( unsigned int i=0 ; i < mesh.voxels.size() ; i++ )
+		{
+			if( mesh.voxels[i].is_Dirichlet == true )
+			{
+				dirichlet_node_map[i] = dirichlet_indices.size(); 
+				dirichlet_indices.push_back( i ); 
+			}
+		}
+		dirichlet_node_list_stale = false; 
+		dirichlet_nodes_changed = true; 
+	}
+	
+	if( dirichlet_nodes_changed == false )
+	{ return; }
+	
+	unsigned int nd = number_of_densities(); 
+	dirichlet_packed_values.assign( dirichlet_indices.size()*nd , 0.0 ); 
+	dirichlet_packed_activation.assign( dirichlet_indices.size()*nd , 0 ); 
+	for( unsigned int t=0 ; t < dirichlet_indices.size() ; t++ )
+	{
+		int n = dirichlet_indices[t]; 
+		for( unsigned int j=0; j < dirichlet_value_vectors[n].size() && j < nd ; j++ )
+		{
+			dirichlet_packed_values[t*nd+j] = dirichlet_value_vectors[n][j]; 
+			dirichlet_packed_activation[t*nd+j] = dirichlet_activation_vectors[n][j]; 
+		}
+	}
+	dirichlet_nodes_changed = false; 
+	return; 
+}
+
 void Microenvironment::add_dirichlet_node( int voxel_index, std::vector<double>& value )
 {
 	mesh.voxels[voxel_index].is_Dirichlet=true;
-	/*
-	dirichlet_indices.push_back( voxel_index );
-	dirichlet_value_vectors.push_back( value ); 
-	*/
-	
 	dirichlet_value_vectors[voxel_index] = value; // .assign( mesh.voxels.size(), one ); 
+	register_dirichlet_node( voxel_index ); 
 	
 	return; 
 }
@@ -202,6 +274,7 @@ void Microenvironment::update_dirichlet_node( int voxel_index , std::vector<doub
 {
 	mesh.voxels[voxel_index].is_Dirichlet = true; 
 	dirichlet_value_vectors[voxel_index] = new_value; 
+	register_dirichlet_node( voxel_index ); 
 	
 	return; 
 }
@@ -212,6 +285,7 @@ void Microenvironment::update_dirichlet_node( int voxel_index , int substrate_in
 	dirichlet_value_vectors[voxel_index][substrate_index] = new_value; 
 	
 	dirichlet_activation_vectors[voxel_index][substrate_index] = true; 
+	register_dirichlet_node( voxel_index ); 
 	
 	return; 
 }
@@ -219,21 +293,31 @@ void Microenvironment::update_dirichlet_node( int voxel_index , int substrate_in
 void Microenvironment::remove_dirichlet_node( int voxel_index )
 {
 	mesh.voxels[voxel_index].is_Dirichlet = false; 
+	unregister_dirichlet_node( voxel_index ); 
 	
 	return; 
 }
 
 bool& Microenvironment::is_dirichlet_node( int voxel_index )
 {
+	// the caller may change the flag through this reference, so rescan the mesh next time 
+	dirichlet_node_list_stale = true; 
 	return mesh.voxels[voxel_index].is_Dirichlet; 
 }
 
+unsigned int Microenvironment::number_of_dirichlet_nodes( void )
+{
+	update_dirichlet_node_list(); 
+	return dirichlet_indices.size(); 
+}
+
 void Microenvironment::set_substrate_dirichlet_activation( int substrate_index , bool new_value )
 {
 	dirichlet_activation_vector[substrate_index] = new_value; 
 	
 	for( int n = 0 ; n < mesh.voxels.size() ; n++ )
 	{ dirichlet_activation_vectors[n][substrate_index] = new_value; }
+	dirichlet_nodes_changed = true; 
 	
 	return; 
 }
@@ -241,6 +325,7 @@ void Microenvironment::set_substrate_dirichlet_activation( int substrate_index ,
 void Microenvironment::set_substrate_dirichlet_activation( int index, std::vector<bool>& new_value )
 {
 	dirichlet_activation_vectors[index] = new_value; 
+	dirichlet_nodes_changed = true; 
 	return; 
 }
 
@@ -255,6 +340,7 @@ bool Microenvironment::get_substrate_dirichlet_activation( int substrate_index )
 void Microenvironment::set_substrate_dirichlet_activation( int substrate_index , int index, bool new_value )
 {
 	dirichlet_activation_vectors[index][substrate_index] = new_value; 
+	dirichlet_nodes_changed = true; 
 	return; 
 }
 
@@ -263,30 +349,20 @@ bool Microenvironment::get_substrate_dirichlet_activation( int substrate_index,
 
 void Microenvironment::apply_dirichlet_conditions( void )
 {
-	/*
-	#pragma omp parallel for 
-	for( unsigned int i=0 ; i < dirichlet_indices.size() ; i++ )
-	{ density_vector( dirichlet_indices[i] ) = dirichlet_value_vectors[i]; }
-	*/
-
+	// only visit the Dirichlet nodes (1.7.2) 
+	update_dirichlet_node_list(); 
+	
+	Density_Store& D = *p_density_vectors; 
+	unsigned int nd = D.number_of_densities(); 
+	
 	#pragma omp parallel for 
-	for( unsigned int i=0 ; i < mesh.voxels.size() ;i++ )
+	for( unsigned int t=0 ; t < dirichlet_indices.size() ; t++ )
 	{
-		/*
-		if( mesh.voxels[i].is_Dirichlet == true )
-		{ density_vector(i) = dirichlet_value_vectors[i]; }
-		*/
-		if( mesh.voxels[i].is_Dirichlet == true )
+		int n = dirichlet_indices[t]; 
+		for( unsigned int j=0; j < nd ; j++ )
 		{
-			for( unsigned int j=0; j < dirichlet_value_vectors[i].size(); j++ )
-			{
-				// if( dirichlet_activation_vector[j] == true )
-				if( dirichlet_activation_vectors[i][j] == true )
-				{
-					density_vector(i)[j] = dirichlet_value_vectors[i][j]; 
-				}
-			}
-	
+			if( dirichlet_packed_activation[t*nd+j] )
+			{ D(n,j) = dirichlet_packed_values[t*nd+j]; }
 		}
 	}
 	return; 
@@ -303,23 +379,15 @@ void Microenvironment::resize_voxels( int new_number_of_voxes )
 	
 	mesh.voxels.resize( new_number_of_voxes ); 
 	
-	temporary_density_vectors1.resize( mesh.voxels.size() , zero ); 
-	temporary_density_vectors2.resize( mesh.voxels.size() , zero ); 
+	temporary_density_vectors1.resize_voxels( mesh.voxels.size() ); 
+	temporary_density_vectors2.resize_voxels( mesh.voxels.size() ); 
 		
-	gradient_vectors.resize( mesh.voxels.size() ); 
-	for( unsigned int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( unsigned int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	resize_gradient_storage(); 
 	
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
 
 	dirichlet_activation_vectors.assign( mesh.voxels.size() , dirichlet_activation_vector ); 
+	dirichlet_node_list_stale = true; 
 	
 	return; 
 }
@@ -329,23 +397,15 @@ void Microenvironment::resize_space( int x_nodes, int y_nodes, int z_nodes )
 {
 	mesh.resize( x_nodes, y_nodes , z_nodes ); 
 
-	temporary_density_vectors1.assign( mesh.voxels.size() , zero ); 
-	temporary_density_vectors2.assign( mesh.voxels.size() , zero ); 
+	temporary_density_vectors1.resize( mesh.voxels.size() , zero.size() ); 
+	temporary_density_vectors2.resize( mesh.voxels.size() , zero.size() ); 
 		
-	gradient_vectors.resize( mesh.voxels.size() ); 
-	for( unsigned int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( unsigned int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	resize_gradient_storage(); 
 	
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
 	
 	dirichlet_activation_vectors.assign( mesh.voxels.size() , dirichlet_activation_vector ); 
+	dirichlet_node_list_stale = true; 
 	
 	return;  
 }
@@ -354,23 +414,15 @@ void Microenvironment::resize_space( double x_start, double x_end, double y_star
 {
 	mesh.resize( x_start, x_end, y_start, y_end, z_start, z_end, x_nodes, y_nodes , z_nodes  ); 
 
-	temporary_density_vectors1.assign( mesh.voxels.size() , zero ); 
-	temporary_density_vectors2.assign( mesh.voxels.size() , zero ); 
+	temporary_density_vectors1.resize( mesh.voxels.size() , zero.size() ); 
+	temporary_density_vectors2.resize( mesh.voxels.size() , zero.size() ); 
 	
-	gradient_vectors.resize( mesh.voxels.size() ); 
-	for( unsigned int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( unsigned int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	resize_gradient_storage(); 
 
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
 	
 	dirichlet_activation_vectors.assign( mesh.voxels.size() , dirichlet_activation_vector ); 	
+	dirichlet_node_list_stale = true; 
 	
 	return;  
 }
@@ -379,23 +431,15 @@ void Microenvironment::resize_space( double x_start, double x_end, double y_star
 {
 	mesh.resize( x_start, x_end, y_start, y_end, z_start, z_end,  dx_new , dy_new , dz_new ); 
 
-	temporary_density_vectors1.assign( mesh.voxels.size() , zero ); 
-	temporary_density_vectors2.assign( mesh.voxels.size() , zero ); 
+	temporary_density_vectors1.resize( mesh.voxels.size() , zero.size() ); 
+	temporary_density_vectors2.resize( mesh.voxels.size() , zero.size() ); 
 	
-	gradient_vectors.resize( mesh.voxels.size() ); 
-	for( unsigned int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( unsigned int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	resize_gradient_storage(); 
 	
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
 
 	dirichlet_activation_vectors.assign( mesh.voxels.size() , dirichlet_activation_vector ); 
+	dirichlet_node_list_stale = true; 
 	
 	return;  
 }
@@ -410,21 +454,14 @@ void Microenvironment::resize_densities( int new_size )
 	zero.assign( new_size, 0.0 ); 
 	one.assign( new_size , 1.0 );
 
-	temporary_density_vectors1.assign( mesh.voxels.size() , zero );
-	temporary_density_vectors2.assign( mesh.voxels.size() , zero );
+	temporary_density_vectors1.resize( mesh.voxels.size() , zero.size() );
+	temporary_density_vectors2.resize( mesh.voxels.size() , zero.size() );
 
-	for( unsigned int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( unsigned int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	resize_gradient_storage(); 
 	
 	diffusion_coefficients.assign( new_size , 0.0 ); 
 	decay_rates.assign( new_size , 0.0 ); 
+	diffusion_step_multiples.assign( new_size , 1 ); 
 
 	density_names.assign( new_size, "unnamed" ); 
 	density_units.assign( new_size , "none" ); 
@@ -439,6 +476,7 @@ void Microenvironment::resize_densities( int new_size )
 	dirichlet_activation_vector.assign( new_size, true ); 
 
 	dirichlet_activation_vectors.assign( mesh.voxels.size(), dirichlet_activation_vector ); 
+	dirichlet_node_list_stale = true; 
 
 	default_microenvironment_options.Dirichlet_condition_vector.assign( new_size , 1.0 );  
 	default_microenvironment_options.Dirichlet_activation_vector.assign( new_size, true ); 
@@ -464,6 +502,81 @@ void Microenvironment::resize_densities( int new_size )
 	return; 
 }
 
+void Microenvironment::set_density_layout( int layout )
+{
+	if( layout != density_layout_voxel_major && layout != density_layout_substrate_major )
+	{
+		std::cout << "Warning: unknown density layout " << layout << " in Microenvironment::" << __FUNCTION__ 
+			<< ". Ignoring directive." << std::endl; 
+		return; 
+	}
+	
+	if( layout != get_density_layout() )
+	{
+		temporary_density_vectors1.set_layout( layout ); 
+		temporary_density_vectors2.set_layout( layout ); 
+		variable_diffusion_coefficients.set_layout( layout ); 
+		variable_decay_rates.set_layout( layout ); 
+		variable_coefficients_changed = true; 
+		// the solvers keep coefficient tables that follow the layout 
+		diffusion_solver_setup_done = false; 
+	}
+	return; 
+}
+
+int Microenvironment::get_density_layout( void )
+{ return p_density_vectors->layout(); }
+
+void Microenvironment::initialize_variable_coefficients( void )
+{
+	variable_diffusion_coefficients.set_layout( get_density_layout() ); 
+	variable_decay_rates.set_layout( get_density_layout() ); 
+	variable_diffusion_coefficients.resize( number_of_voxels() , number_of_densities() ); 
+	variable_decay_rates.resize( number_of_voxels() , number_of_densities() ); 
+	variable_diffusion_coefficients.fill( diffusion_coefficients ); 
+	variable_decay_rates.fill( decay_rates ); 
+	variable_coefficients_changed = true; 
+	return; 
+}
+
+void Microenvironment::set_variable_diffusion_coefficient( int voxel_index , int substrate_index , double value )
+{
+	if( variable_diffusion_coefficients.number_of_voxels() != number_of_voxels() || 
+		variable_diffusion_coefficients.number_of_densities() != number_of_densities() )
+	{ initialize_variable_coefficients(); }
+	
+	variable_diffusion_coefficients(voxel_index,substrate_index) = value; 
+	variable_coefficients_changed = true; 
+	return; 
+}
+
+void Microenvironment::set_variable_decay_rate( int voxel_index , int substrate_index , double value )
+{
+	if( variable_decay_rates.number_of_voxels() != number_of_voxels() || 
+		variable_decay_rates.number_of_densities() != number_of_densities() )
+	{ initialize_variable_coefficients(); }
+	
+	variable_decay_rates(voxel_index,substrate_index) = value; 
+	variable_coefficients_changed = true; 
+	return; 
+}
+
+double Microenvironment::get_variable_diffusion_coefficient( int voxel_index , int substrate_index )
+{
+	if( variable_diffusion_coefficients.number_of_voxels() != number_of_voxels() || 
+		variable_diffusion_coefficients.number_of_densities() != number_of_densities() )
+	{ return diffusion_coefficients[substrate_index]; }
+	return variable_diffusion_coefficients(voxel_index,substrate_index); 
+}
+
+double Microenvironment::get_variable_decay_rate( int voxel_index , int substrate_index )
+{
+	if( variable_decay_rates.number_of_voxels() != number_of_voxels() || 
+		variable_decay_rates.number_of_densities() != number_of_densities() )
+	{ return decay_rates[substrate_index]; }
+	return variable_decay_rates(voxel_index,substrate_index); 
+}
+
 void Microenvironment::add_density( void )
 {
 	// fix in PhysiCell preview November 2017 
@@ -480,25 +593,14 @@ void Microenvironment::add_density( void )
 	// update coefficients 
 	diffusion_coefficients.push_back( 0.0 ); 
 	decay_rates.push_back( 0.0 ); 
+	diffusion_step_multiples.push_back( 1 ); 
 	
 	// update sources and such 
-	for( unsigned int i=0; i < temporary_density_vectors1.size() ; i++ )
-	{
-		temporary_density_vectors1[i].push_back( 0.0 ); 
-		temporary_density_vectors2[i].push_back( 0.0 ); 
-	}
+	temporary_density_vectors1.resize_densities( zero.size() ); 
+	temporary_density_vectors2.resize_densities( zero.size() ); 
 
 	// resize the gradient data structures 
-	for( unsigned int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( unsigned int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	resize_gradient_storage(); 
 	
 	one_half = one; 
 	one_half *= 0.5; 
@@ -509,6 +611,7 @@ void Microenvironment::add_density( void )
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
 	dirichlet_activation_vector.push_back( true ); 
 	dirichlet_activation_vectors.assign( mesh.voxels.size(), dirichlet_activation_vector ); 
+	dirichlet_node_list_stale = true; 
 	
 	// Fixes in PhysiCell preview November 2017
 	default_microenvironment_options.Dirichlet_condition_vector.push_back( 1.0 ); //  = one; 
@@ -551,24 +654,14 @@ void Microenvironment::add_density( std::string name , std::string units )
 	// update coefficients 
 	diffusion_coefficients.push_back( 0.0 ); 
 	decay_rates.push_back( 0.0 ); 
+	diffusion_step_multiples.push_back( 1 ); 
 	
 	// update sources and such 
-	for( unsigned int i=0; i < temporary_density_vectors1.size() ; i++ )
-	{
-		temporary_density_vectors1[i].push_back( 0.0 ); 
-		temporary_density_vectors2[i].push_back( 0.0 ); 
-	}
+	temporary_density_vectors1.resize_densities( zero.size() ); 
+	temporary_density_vectors2.resize_densities( zero.size() ); 
 
 	// resize the gradient data structures, 
-	for( unsigned int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( unsigned int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	resize_gradient_storage(); 
 
 	one_half = one; 
 	one_half *= 0.5; 
@@ -579,6 +672,7 @@ void Microenvironment::add_density( std::string name , std::string units )
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
 	dirichlet_activation_vector.push_back( true ); 
 	dirichlet_activation_vectors.assign( mesh.voxels.size(), dirichlet_activation_vector ); 
+	dirichlet_node_list_stale = true; 
 	
 	// fix in PhysiCell preview November 2017 
 	default_microenvironment_options.Dirichlet_condition_vector.push_back( 1.0 ); //  = one; 
@@ -621,24 +715,14 @@ void Microenvironment::add_density( std::string name , std::string units, double
 	// update coefficients 
 	diffusion_coefficients.push_back( diffusion_constant ); 
 	decay_rates.push_back( decay_rate ); 
+	diffusion_step_multiples.push_back( 1 ); 
 	
 	// update sources and such 
-	for( unsigned int i=0; i < temporary_density_vectors1.size() ; i++ )
-	{
-		temporary_density_vectors1[i].push_back( 0.0 ); 
-		temporary_density_vectors2[i].push_back( 0.0 ); 
-	}
+	temporary_density_vectors1.resize_densities( zero.size() ); 
+	temporary_density_vectors2.resize_densities( zero.size() ); 
 
 	// resize the gradient data structures 
-	for( unsigned int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( unsigned int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	resize_gradient_storage(); 
 
 	one_half = one; 
 	one_half *= 0.5; 
@@ -649,6 +733,7 @@ void Microenvironment::add_density( std::string name , std::string units, double
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
 	dirichlet_activation_vector.push_back( true ); 
 	dirichlet_activation_vectors.assign( mesh.voxels.size(), dirichlet_activation_vector ); 
+	dirichlet_node_list_stale = true; 
 	
 	// fix in PhysiCell preview November 2017 
 	default_microenvironment_options.Dirichlet_condition_vector.push_back( 1.0 ); // = one; 
@@ -728,34 +813,124 @@ std::vector<unsigned int> Microenvironment::nearest_cartesian_indices( std::vect
 Voxel& Microenvironment::nearest_voxel( std::vector<double>& position )
 { return mesh.nearest_voxel( position ); }
 
-std::vector<double>& Microenvironment::nearest_density_vector( std::vector<double>& position )
+Density_Vector_View Microenvironment::nearest_density_vector( std::vector<double>& position )
 { return (*p_density_vectors)[ mesh.nearest_voxel_index( position ) ]; }
 
-std::vector<double>& Microenvironment::nearest_density_vector( int voxel_index )
+Density_Vector_View Microenvironment::nearest_density_vector( int voxel_index )
 { return (*p_density_vectors)[ voxel_index ]; }
 
-std::vector<double>& Microenvironment::operator()( int i, int j, int k )
+Density_Vector_View Microenvironment::operator()( int i, int j, int k )
 { return (*p_density_vectors)[ voxel_index(i,j,k) ]; }
 
-std::vector<double>& Microenvironment::operator()( int i, int j )
+Density_Vector_View Microenvironment::operator()( int i, int j )
 { return (*p_density_vectors)[ voxel_index(i,j,0) ]; }
 
-std::vector<double>& Microenvironment::operator()( int n )
+Density_Vector_View Microenvironment::operator()( int n )
 { return (*p_density_vectors)[ n ]; }
 
-std::vector<double>& Microenvironment::density_vector( int i, int j, int k )
+Density_Vector_View Microenvironment::density_vector( int i, int j, int k )
 { return (*p_density_vectors)[ voxel_index(i,j,k) ]; }
 
-std::vector<double>& Microenvironment::density_vector( int i, int j )
+Density_Vector_View Microenvironment::density_vector( int i, int j )
 { return (*p_density_vectors)[ voxel_index(i,j,0) ]; }
 
-std::vector<double>& Microenvironment::density_vector( int n )
+Density_Vector_View Microenvironment::density_vector( int n )
 { return (*p_density_vectors)[ n ]; }
 
+void Microenvironment::set_diffusion_step_multiple( int substrate_index , int multiple )
+{
+	if( multiple < 1 )
+	{
+		std::cout << "Warning: diffusion step multiple " << multiple << " for " << density_names[substrate_index] 
+			<< " is invalid. Using 1 instead." << std::endl; 
+		multiple = 1; 
+	}
+	diffusion_step_multiples[substrate_index] = multiple; 
+	
+	// the solver coefficients depend on the step sizes 
+	diffusion_solver_setup_done = false; 
+	return; 
+}
+
+int Microenvironment::get_diffusion_step_multiple( int substrate_index )
+{ return diffusion_step_multiples[substrate_index]; }
+
+bool Microenvironment::steady_state_diffusion( void )
+{ return diffusion_decay_solver == diffusion_decay_solver__steady_state_multigrid; }
+
+void Microenvironment::reset_active_region( void )
+{
+	active_region_stale = true; 
+	return; 
+}
+
+double Microenvironment::skipped_voxel_fraction( void )
+{ return last_skipped_voxel_fraction; }
+
+double Microenvironment::mean_skipped_voxel_fraction( void )
+{
+	if( active_region_steps == 0 )
+	{ return 0.0; }
+	return total_skipped_voxel_fraction / (double) active_region_steps; 
+}
+
+bool Microenvironment::multirate_diffusion( void )
+{
+	for( unsigned int q=0; q < diffusion_step_multiples.size() ; q++ )
+	{
+		if( diffusion_step_multiples[q] > 1 )
+		{ return true; }
+	}
+	return false; 
+}
+
 void Microenvironment::simulate_diffusion_decay( double dt )
 {
-	if( diffusion_decay_solver )
-	{ diffusion_decay_solver( *this, dt ); }
+	reset_all_gradient_vectors(); 
+	
+	if( diffusion_decay_solver && multirate_diffusion() == false )
+	{
+		if( active_diffusion_substrates.size() != number_of_densities() )
+		{
+			active_diffusion_substrates.resize( number_of_densities() ); 
+			for( unsigned int q=0; q < number_of_densities() ; q++ )
+			{ active_diffusion_substrates[q] = q; }
+		}
+		diffusion_decay_solver( *this, dt ); 
+	}
+	else if( diffusion_decay_solver )
+	{
+		// multirate: only the substrates that are due this step 
+		
+		if( diffusion_decay_solver != diffusion_decay_solver__constant_coefficients_LOD_3D && 
+			diffusion_decay_solver != diffusion_decay_solver__constant_coefficients_LOD_2D )
+		{
+			std::cout << "Warning: the diffusion solver does not support multirate stepping. Resetting all diffusion step multiples to 1." << std::endl; 
+			diffusion_step_multiples.assign( number_of_densities() , 1 ); 
+			diffusion_solver_setup_done = false; 
+			simulate_diffusion_decay( dt ); 
+			return; 
+		}
+		
+		// each substrate is swept separately, so skipping one only saves memory 
+		// traffic if its values are contiguous 
+		if( get_density_layout() != density_layout_substrate_major )
+		{
+			std::cout << "Multirate diffusion: switching to the substrate-major density layout." << std::endl; 
+			set_density_layout( density_layout_substrate_major ); 
+		}
+		
+		diffusion_step_count++; 
+		active_diffusion_substrates.clear(); 
+		for( unsigned int q=0; q < number_of_densities() ; q++ )
+		{
+			if( diffusion_step_count % diffusion_step_multiples[q] == 0 )
+			{ active_diffusion_substrates.push_back( q ); }
+		}
+		
+		if( active_diffusion_substrates.size() > 0 )
+		{ diffusion_decay_solver( *this, dt ); }
+	}
 	else
 	{
 		std::cout << "Warning: diffusion-reaction-source/sink solver not set for Microenvironment object at " << this << ". Nothing happened!" << std::endl; 
@@ -793,6 +968,7 @@ void Microenvironment::display_information( std::ostream& os )
 			<< " " << time_units << "^-1" << std::endl 
 		<< "     diffusion length scale: " << sqrt( diffusion_coefficients[i] / ( 1e-12 + decay_rates[i] ) ) 
 			<< " " << spatial_units << std::endl 
+		<< "     diffusion time step multiple: " << diffusion_step_multiples[i] << std::endl 
 		<< "     initial condition: " << default_microenvironment_options.initial_condition_vector[i] 
 			<< " " << density_units[i] << std::endl 
 		<< "     boundary condition: " << default_microenvironment_options.Dirichlet_condition_vector[i] 
@@ -809,7 +985,7 @@ void Microenvironment::display_information( std::ostream& os )
 }
 	
 unsigned int Microenvironment::number_of_densities( void )
-{ return (*p_density_vectors)[0].size(); }
+{ return p_density_vectors->number_of_densities(); }
 
 unsigned int Microenvironment::number_of_voxels( void )
 { return mesh.voxels.size(); }
@@ -820,7 +996,7 @@ unsigned int Microenvironment::number_of_voxel_faces( void )
 void Microenvironment::write_to_matlab( std::string filename )
 {
 	int number_of_data_entries = mesh.voxels.size();
-	int size_of_each_datum = 3 + 1 + (*p_density_vectors)[0].size(); 
+	int size_of_each_datum = 3 + 1 + number_of_densities(); 
 
 	FILE* fp = write_matlab_header( size_of_each_datum, number_of_data_entries,  filename, "multiscale_microenvironment" );  
 
@@ -834,8 +1010,8 @@ void Microenvironment::write_to_matlab( std::string filename )
 
 		// densities  
 
-		for( unsigned int j=0 ; j < (*p_density_vectors)[i].size() ; j++)
-		{ fwrite( (char*) &( ((*p_density_vectors)[i])[j] ) , sizeof(double) , 1 , fp ); }
+		for( unsigned int j=0 ; j < number_of_densities() ; j++)
+		{ fwrite( (char*) &( (*p_density_vectors)(i,j) ) , sizeof(double) , 1 , fp ); }
 	}
 
 	fclose( fp ); 
@@ -863,13 +1039,16 @@ void Microenvironment::simulate_bulk_sources_and_sinks( double dt )
 		bulk_uptake_rate_function( this,i, &bulk_source_sink_solver_temp3[i] ); // temp3 = U
 
 		
+		Density_Vector_View density = (*p_density_vectors)[i]; 
+		
 		bulk_source_sink_solver_temp2[i] *= bulk_source_sink_solver_temp1[i]; // temp2 = S*T
-		axpy( &(*p_density_vectors)[i] , dt , bulk_source_sink_solver_temp2[i] ); // out = out + dt*temp2 = out + dt*S*T
+		for( unsigned int j=0; j < density.size() ; j++ ) // out = out + dt*temp2 = out + dt*S*T
+		{ density[j] += dt*bulk_source_sink_solver_temp2[i][j]; }
 		bulk_source_sink_solver_temp3[i] += bulk_source_sink_solver_temp1[i]; // temp3 = U+S
 		bulk_source_sink_solver_temp3[i] *= dt; // temp3 = dt*(U+S)
 		bulk_source_sink_solver_temp3[i] += one; // temp3 = 1 + dt*(U+S)
 		
-		(*p_density_vectors)[i] /= bulk_source_sink_solver_temp3[i];
+		density /= bulk_source_sink_solver_temp3[i];
 	}
 	
 	return; 
@@ -914,283 +1093,115 @@ void Microenvironment::update_rates( void )
 	return; 
 }
 
-std::vector<gradient>& Microenvironment::gradient_vector(int i, int j, int k)
+void Microenvironment::resize_gradient_storage( void )
 {
-	int n = voxel_index(i,j,k);
-	if( gradient_vector_computed[n] == false )
-	{
-		compute_gradient_vector( n );
-	}
-	
-	return gradient_vectors[n];
+	gradient_values.assign( number_of_voxels()*number_of_densities()*3 , 0.0 ); 
+	gradient_stamps.assign( number_of_voxels()*number_of_densities() , 0 ); 
+	return; 
 }
 
-std::vector<gradient>& Microenvironment::gradient_vector(int i, int j )
+// computes the gradient of substrate q at voxel n: centered differences in the 
+// interior, one-sided differences at the outer boundary, and 0 along an axis 
+// that has a single voxel 
+
+void Microenvironment::compute_gradient( int n , int q )
 {
-	int n = voxel_index(i,j,0);
-	if( gradient_vector_computed[n] == false )
+	unsigned int nd = number_of_densities(); 
+	unsigned int size[3] = { (unsigned int) mesh.x_coordinates.size() , 
+		(unsigned int) mesh.y_coordinates.size() , (unsigned int) mesh.z_coordinates.size() }; 
+	unsigned int jump[3] = { 1 , size[0] , size[0]*size[1] }; 
+	double spacing[3] = { mesh.dx , mesh.dy , mesh.dz }; 
+	unsigned int index[3] = { n % size[0] , (n / size[0]) % size[1] , n / (size[0]*size[1]) }; 
+	
+	Density_Store& D = *p_density_vectors; 
+	double* pGradient = gradient_values.data() + (n*nd+q)*3; 
+	for( unsigned int d=0; d < 3 ; d++ )
 	{
-		compute_gradient_vector( n );
+		if( size[d] == 1 )
+		{
+			pGradient[d] = 0.0; 
+			continue; 
+		}
+		unsigned int lower = n; 
+		unsigned int upper = n; 
+		if( index[d] > 0 )
+		{ lower -= jump[d]; }
+		if( index[d] < size[d]-1 )
+		{ upper += jump[d]; }
+		pGradient[d] = ( D(upper,q) - D(lower,q) ) / ( spacing[d] * ( (upper-lower) / jump[d] ) ); 
 	}
 	
-	return gradient_vectors[n];
+	// publish the values before the stamp (agents read gradients from parallel loops) 
+	unsigned int generation = gradient_generation; 
+	#pragma omp atomic write seq_cst 
+	gradient_stamps[n*nd+q] = generation; 
+	return; 
 }
 
-std::vector<gradient>& Microenvironment::gradient_vector(int n )
+const double* Microenvironment::substrate_gradient( int n , int substrate_index )
 {
-	// if the gradient has not yet been computed, then do it!
-	if( gradient_vector_computed[n] == false )
-	{
-		compute_gradient_vector( n );
-	}
-	
-	
-	return gradient_vectors[n];
+	unsigned int entry = n*number_of_densities() + substrate_index; 
+	unsigned int stamp; 
+	#pragma omp atomic read seq_cst 
+	stamp = gradient_stamps[entry]; 
+	if( stamp != gradient_generation )
+	{ compute_gradient( n , substrate_index ); }
+	return gradient_values.data() + 3*entry; 
 }
-	
-std::vector<gradient>& Microenvironment::nearest_gradient_vector( std::vector<double>& position )
+
+std::vector<gradient> Microenvironment::gradient_vector(int i, int j, int k)
+{ return gradient_vector( voxel_index(i,j,k) ); }
+
+std::vector<gradient> Microenvironment::gradient_vector(int i, int j )
+{ return gradient_vector( voxel_index(i,j,0) ); }
+
+std::vector<gradient> Microenvironment::gradient_vector(int n )
 {
-	int n = nearest_voxel_index( position );
-	if( gradient_vector_computed[n] == false )
+	std::vector<gradient> out( number_of_densities() ); 
+	for( unsigned int q=0; q < number_of_densities() ; q++ )
 	{
-		compute_gradient_vector( n );
+		const double* pGradient = substrate_gradient( n , q ); 
+		out[q].assign( pGradient , pGradient+3 ); 
 	}
-	
-	return gradient_vectors[n];
+	return out; 
 }
+	
+std::vector<gradient> Microenvironment::nearest_gradient_vector( std::vector<double>& position )
+{ return gradient_vector( nearest_voxel_index( position ) ); }
 
 void Microenvironment::compute_all_gradient_vectors( void )
 {
-	static double two_dx = mesh.dx; 
-	static double two_dy = mesh.dy; 
-	static double two_dz = mesh.dz; 
-	static bool gradient_constants_defined = false; 
-	if( gradient_constants_defined == false )
-	{
-		two_dx *= 2.0; 
-		two_dy *= 2.0; 
-		two_dz *= 2.0;
-		gradient_constants_defined = true; 
-	}
-	
-	#pragma omp parallel for 
-	for( unsigned int k=0; k < mesh.z_coordinates.size() ; k++ )
-	{
-		for( unsigned int j=0; j < mesh.y_coordinates.size() ; j++ )
-		{
-			// endcaps 
-			for( unsigned int q=0; q < number_of_densities() ; q++ )
-			{
-				int i = 0; 
-				int n = voxel_index(i,j,k);
-				// x-derivative of qth substrate at voxel n
-				gradient_vectors[n][q][0] = (*p_density_vectors)[n+thomas_i_jump][q]; 
-				gradient_vectors[n][q][0] -= (*p_density_vectors)[n][q]; 
-				gradient_vectors[n][q][0] /= mesh.dx; 
-				
-				gradient_vector_computed[n] = true; 
-			}
-			for( unsigned int q=0; q < number_of_densities() ; q++ )
-			{
-				int i = mesh.x_coordinates.size()-1; 
-				int n = voxel_index(i,j,k);
-				// x-derivative of qth substrate at voxel n
-				gradient_vectors[n][q][0] = (*p_density_vectors)[n][q]; 
-				gradient_vectors[n][q][0] -= (*p_density_vectors)[n-thomas_i_jump][q]; 
-				gradient_vectors[n][q][0] /= mesh.dx; 
-				
-				gradient_vector_computed[n] = true; 
-			}
-			
-			for( unsigned int i=1; i < mesh.x_coordinates.size()-1 ; i++ )
-			{
-				for( unsigned int q=0; q < number_of_densities() ; q++ )
-				{
-					int n = voxel_index(i,j,k);
-					// x-derivative of qth substrate at voxel n
-					gradient_vectors[n][q][0] = (*p_density_vectors)[n+thomas_i_jump][q]; 
-					gradient_vectors[n][q][0] -= (*p_density_vectors)[n-thomas_i_jump][q]; 
-					gradient_vectors[n][q][0] /= two_dx; 
-					
-					gradient_vector_computed[n] = true; 
- 				}
-			}
-			
-		}
-	}
-	
-	#pragma omp parallel for 
-	for( unsigned int k=0; k < mesh.z_coordinates.size() ; k++ )
-	{
-		for( unsigned int i=0; i < mesh.x_coordinates.size() ; i++ )
-		{
-			// endcaps 
-			for( unsigned int q=0; q < number_of_densities() ; q++ )
-			{
-				int j = 0; 
-				int n = voxel_index(i,j,k);
-				// x-derivative of qth substrate at voxel n
-				gradient_vectors[n][q][1] = (*p_density_vectors)[n+thomas_j_jump][q]; 
-				gradient_vectors[n][q][1] -= (*p_density_vectors)[n][q]; 
-				gradient_vectors[n][q][1] /= mesh.dy; 
-				
-				gradient_vector_computed[n] = true; 
-			}
-			for( unsigned int q=0; q < number_of_densities() ; q++ )
-			{
-				int j = mesh.y_coordinates.size()-1; 
-				int n = voxel_index(i,j,k);
-				// x-derivative of qth substrate at voxel n
-				gradient_vectors[n][q][1] = (*p_density_vectors)[n][q]; 
-				gradient_vectors[n][q][1] -= (*p_density_vectors)[n-thomas_j_jump][q]; 
-				gradient_vectors[n][q][1] /= mesh.dy; 
-				
-				gradient_vector_computed[n] = true; 
-			}		
-			
-			for( unsigned int j=1; j < mesh.y_coordinates.size()-1 ; j++ )
-			{
-				for( unsigned int q=0; q < number_of_densities() ; q++ )
-				{
-					int n = voxel_index(i,j,k);
-					// y-derivative of qth substrate at voxel n
-					gradient_vectors[n][q][1] = (*p_density_vectors)[n+thomas_j_jump][q]; 
-					gradient_vectors[n][q][1] -= (*p_density_vectors)[n-thomas_j_jump][q]; 
-					gradient_vectors[n][q][1] /= two_dy; 
-					gradient_vector_computed[n] = true; 
-				}
-			}
-			
-		}
-	}
+	unsigned int nd = number_of_densities(); 
 	
-	// don't bother computing z component if there is no z-directoin 
-	if( mesh.z_coordinates.size() == 1 )
-	{ return; }
-
 	#pragma omp parallel for 
-	for( unsigned int j=0; j < mesh.y_coordinates.size() ; j++ )
+	for( unsigned int n=0; n < number_of_voxels() ; n++ )
 	{
-		for( unsigned int i=0; i < mesh.x_coordinates.size() ; i++ )
-		{
-			// endcaps 
-			for( unsigned int q=0; q < number_of_densities() ; q++ )
-			{
-				int k = 0; 
-				int n = voxel_index(i,j,k);
-				// x-derivative of qth substrate at voxel n
-				gradient_vectors[n][q][2] = (*p_density_vectors)[n+thomas_k_jump][q]; 
-				gradient_vectors[n][q][2] -= (*p_density_vectors)[n][q]; 
-				gradient_vectors[n][q][2] /= mesh.dz; 
-				
-				gradient_vector_computed[n] = true; 
-			}
-			for( unsigned int q=0; q < number_of_densities() ; q++ )
-			{
-				int k = mesh.z_coordinates.size()-1; 
-				int n = voxel_index(i,j,k);
-				// x-derivative of qth substrate at voxel n
-				gradient_vectors[n][q][2] = (*p_density_vectors)[n][q]; 
-				gradient_vectors[n][q][2] -= (*p_density_vectors)[n-thomas_k_jump][q]; 
-				gradient_vectors[n][q][2] /= mesh.dz; 
-				
-				gradient_vector_computed[n] = true; 
-			}			
-			
-			for( unsigned int k=1; k < mesh.z_coordinates.size()-1 ; k++ )
-			{
-				for( unsigned int q=0; q < number_of_densities() ; q++ )
-				{
-					int n = voxel_index(i,j,k);
-					// y-derivative of qth substrate at voxel n
-					gradient_vectors[n][q][2] = (*p_density_vectors)[n+thomas_k_jump][q]; 
-					gradient_vectors[n][q][2] -= (*p_density_vectors)[n-thomas_k_jump][q]; 
-					gradient_vectors[n][q][2] /= two_dz; 
-					gradient_vector_computed[n] = true; 
-				}
-			}
-			
-		}
+		for( unsigned int q=0; q < nd ; q++ )
+		{ compute_gradient( n , q ); }
 	}
-
 	return; 
 }
 
 void Microenvironment::compute_gradient_vector( int n )
 {
-	static double two_dx = mesh.dx; 
-	static double two_dy = mesh.dy; 
-	static double two_dz = mesh.dz; 
-	static bool gradient_constants_defined = false; 
-	std::vector<unsigned int> indices(3,0);
-	
-	if( gradient_constants_defined == false )
-	{
-		two_dx *= 2.0; 
-		two_dy *= 2.0; 
-		two_dz *= 2.0;
-		gradient_constants_defined = true; 
-	}	
-	
-	indices = cartesian_indices( n );
-	
-	// d/dx 
-	if( indices[0] > 0 && indices[0] < mesh.x_coordinates.size()-1 )
-	{
-		for( unsigned int q=0; q < number_of_densities() ; q++ )
-		{
-			gradient_vectors[n][q][0] = (*p_density_vectors)[n+thomas_i_jump][q]; 
-			gradient_vectors[n][q][0] -= (*p_density_vectors)[n-thomas_i_jump][q]; 
-			gradient_vectors[n][q][0] /= two_dx; 
-			gradient_vector_computed[n] = true; 
-		}
-	}
-	
-	// don't bother computing y and z component if there is no y-direction. (1D)
-	if( mesh.y_coordinates.size() == 1 )
-	{ return; }	
-	
-	// d/dy 
-	if( indices[1] > 0 && indices[1] < mesh.y_coordinates.size()-1 )
-	{
-		for( unsigned int q=0; q < number_of_densities() ; q++ )
-		{
-			gradient_vectors[n][q][1] = (*p_density_vectors)[n+thomas_j_jump][q]; 
-			gradient_vectors[n][q][1] -= (*p_density_vectors)[n-thomas_j_jump][q]; 
-			gradient_vectors[n][q][1] /= two_dy; 
-			gradient_vector_computed[n] = true; 
-		}
-	}
-	
-	// don't bother computing z component if there is no z-direction (2D) 
-	if( mesh.z_coordinates.size() == 1 )
-	{ return; }
-	
-	// d/dz 
-	if( indices[2] > 0 && indices[2] < mesh.z_coordinates.size()-1 )
-	{
-		for( unsigned int q=0; q < number_of_densities() ; q++ )
-		{
-			gradient_vectors[n][q][2] = (*p_density_vectors)[n+thomas_k_jump][q]; 
-			gradient_vectors[n][q][2] -= (*p_density_vectors)[n-thomas_k_jump][q]; 
-			gradient_vectors[n][q][2] /= two_dz; 
-			gradient_vector_computed[n] = true; 
-		}
-	}
-	
+	for( unsigned int q=0; q < number_of_densities() ; q++ )
+	{ compute_gradient( n , q ); }
 	return; 
 }
 
 void Microenvironment::reset_all_gradient_vectors( void )
 {
-	for( unsigned int k=0 ; k < mesh.voxels.size() ; k++ )
+	if( gradient_stamps.size() != number_of_voxels()*number_of_densities() )
+	{ resize_gradient_storage(); }
+	
+	// every gradient computed so far is now out of date 
+	gradient_generation++; 
+	if( gradient_generation == 0 )
 	{
-		for( unsigned int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
+		gradient_stamps.assign( gradient_stamps.size() , 0 ); 
+		gradient_generation = 1; 
 	}
-	gradient_vector_computed.assign( mesh.voxels.size() , false ); 	
+	return; 
 }
 
 
@@ -1240,6 +1251,13 @@ Microenvironment_Options::Microenvironment_Options()
 	calculate_gradients = false; 
 	
 	track_internalized_substrates_in_each_agent = false; 
+	
+	density_layout = density_layout_voxel_major; 
+	blocked_diffusion_sweeps = true; 
+	steady_state_diffusion = false; 
+	steady_state_tolerance = 1e-6; 
+	steady_state_max_cycles = 50; 
+	active_region_tolerance = 0.0; 
 
 	Dirichlet_all.push_back( true ); 
 //	Dirichlet_interior.push_back( true ); 
@@ -1294,6 +1312,14 @@ void initialize_microenvironment( void )
 		default_microenvironment_options.Y_range[0], default_microenvironment_options.Y_range[1], 
 		default_microenvironment_options.Z_range[0], default_microenvironment_options.Z_range[1], 
 		default_microenvironment_options.dx,default_microenvironment_options.dy,default_microenvironment_options.dz );
+	microenvironment.set_density_layout( default_microenvironment_options.density_layout ); 
+	microenvironment.blocked_diffusion_sweeps = default_microenvironment_options.blocked_diffusion_sweeps; 
+	
+	microenvironment.steady_state_tolerance = default_microenvironment_options.steady_state_tolerance; 
+	microenvironment.steady_state_max_cycles = default_microenvironment_options.steady_state_max_cycles; 
+	microenvironment.active_region_tolerance = default_microenvironment_options.active_region_tolerance; 
+	if( default_microenvironment_options.steady_state_diffusion == true )
+	{ microenvironment.diffusion_decay_solver = diffusion_decay_solver__steady_state_multigrid; }
 		
 	// set units
 	microenvironment.spatial_units = default_microenvironment_options.spatial_units;
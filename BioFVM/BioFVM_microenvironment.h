@@ -52,6 +52,7 @@
 #include "BioFVM_mesh.h"
 #include "BioFVM_agent_container.h"
 #include "BioFVM_MultiCellDS.h"
+#include "BioFVM_vector.h"
 
 namespace BioFVM{
 
@@ -62,15 +63,77 @@ typedef std::vector<double> gradient;
 
 class Basic_Agent; 
 
+/*! one level of the grid hierarchy of the steady-state multigrid solver 
+    (new in 1.7.2). Level 0 is the mesh itself; each coarser level halves 
+    the resolution in every direction that has at least 4 voxels. */ 
+
+class Multigrid_Level
+{
+ public:
+	unsigned int nx, ny, nz; 
+	double hx, hy, hz; 
+	
+	std::vector<double> u; // the densities on level 0, a correction on coarser levels 
+	std::vector<double> f; // right-hand side 
+	std::vector<double> r; // residual 
+	std::vector<double> sigma; // linear reaction rate: decay plus cell uptake and secretion 
+	std::vector<char> fixed; // Dirichlet nodes (level 0 only) 
+};
+
+/*! the orthonormal cosine transform (DCT-II, and its inverse DCT-III) along 
+    one axis of n voxels, for the DCT solvers (new in 1.7.2). The transform 
+    is computed from a complex FFT of length n (Makhoul's method): a 
+    mixed-radix (2, 3, 4, 5) Stockham FFT if n has no other prime factors, 
+    and otherwise Bluestein's algorithm on such an FFT of at least 2n-1 
+    entries. Either way it takes O(n log n) work per line. 
+    
+    Lines are transformed in blocks of 2*lanes, stored interleaved (entry p 
+    of line l at [p*2*lanes+l]), so that every step of the FFT is a 
+    vectorizable loop over the lanes. Each lane carries two real lines, as 
+    the real and imaginary parts of one complex line. */ 
+
+class Cosine_Transform
+{
+ private:
+	unsigned int fft_size; // n, or the padded length for Bluestein's algorithm 
+	// the radix of each stage of the FFT, and the twiddle factors of all 
+	// the stages, exp(-2 pi i p u / length) for stage length, at [offset + p*radix + u] 
+	std::vector<unsigned int> radices; 
+	std::vector<double> twiddles_re, twiddles_im; 
+	std::vector<unsigned int> even_odd_order; // the entries of a line, evens then odds backwards 
+	std::vector<double> shift_re, shift_im; // exp(-pi i k / (2n)) 
+	std::vector<double> scale; // the orthonormal scale of each mode 
+	std::vector<double> chirp_re, chirp_im; // exp(-pi i k^2 / n) (Bluestein) 
+	std::vector<double> kernel_re, kernel_im; // the FFT of its convolution kernel, over fft_size 
+	
+	void fft( double* re , double* im , double* temp_re , double* temp_im ) const; 
+	void dft( double* z_re , double* z_im , double* work ) const; 
+	
+ public:
+	static const unsigned int lanes = 8; 
+	unsigned int n; 
+	// the eigenvalues of the 1-D no-flux Laplacian (per unit diffusion coefficient) 
+	std::vector<double> eigenvalues; 
+	
+	Cosine_Transform(); 
+	void setup( unsigned int n , double h ); 
+	
+	// the number of doubles of workspace that transform needs 
+	unsigned int work_size( void ) const; 
+	// transform a block of 2*lanes interleaved lines in place 
+	void transform( double* block , bool inverse , double* work ) const; 
+};
+
 class Microenvironment
 {
  private:
 	friend std::ostream& operator<<(std::ostream& os, const Microenvironment& S);  
 
+	/*! For internal use and accelerations in solvers. As of 1.7.2, all 
+	    densities live in a single flat, aligned block (see Density_Store). */ 
+	Density_Store temporary_density_vectors1; 
 	/*! For internal use and accelerations in solvers */ 
-	std::vector< std::vector<double> > temporary_density_vectors1; 
-	/*! For internal use and accelerations in solvers */ 
-	std::vector< std::vector<double> > temporary_density_vectors2; 
+	Density_Store temporary_density_vectors2; 
 	
 	/*! for internal use in bulk source/sink solvers */
 	std::vector< std::vector<double> > bulk_source_sink_solver_temp1; 
@@ -80,10 +143,17 @@ class Microenvironment
 
 	
 	/*! stores pointer to current density solutions. Access via operator() functions. */ 
-	std::vector< std::vector<double> >* p_density_vectors; 
+	Density_Store* p_density_vectors; 
 	
-	std::vector< std::vector<gradient> > gradient_vectors; 
-	std::vector<bool> gradient_vector_computed; 
+	/* gradients (flat as of 1.7.2): entry (n,q,d) is at [(n*number_of_densities()+q)*3+d]. 
+	   They are computed on demand, one substrate at a time; the gradient of 
+	   substrate q at voxel n is current if gradient_stamps[n*number_of_densities()+q] 
+	   equals gradient_generation. */ 
+	std::vector<double> gradient_values; 
+	std::vector<unsigned int> gradient_stamps; 
+	unsigned int gradient_generation; 
+	void resize_gradient_storage( void ); 
+	void compute_gradient( int n , int substrate_index ); 
 
 	
 	/*! helpful for solvers -- resize these whenever adding/removing substrates */ 
@@ -106,25 +176,94 @@ class Microenvironment
 	int thomas_j_jump; 
 	int thomas_k_jump; 
 	std::vector<double> thomas_constant1; 
-	std::vector<double> thomas_constant1a; 
 	std::vector<double> thomas_constant2;
-	std::vector<double> thomas_constant3;
-	std::vector<double> thomas_constant3a;
-	std::vector< std::vector<double> > thomas_denomx;
-	std::vector< std::vector<double> > thomas_cx;
-	std::vector< std::vector<double> > thomas_denomy;
-	std::vector< std::vector<double> > thomas_cy;
-	std::vector< std::vector<double> > thomas_denomz;
-	std::vector< std::vector<double> > thomas_cz;
+	// flat: entry (i,q) is at [i*number_of_densities()+q] 
+	std::vector<double> thomas_denomx;
+	std::vector<double> thomas_cx;
+	std::vector<double> thomas_denomy;
+	std::vector<double> thomas_cy;
+	std::vector<double> thomas_denomz;
+	std::vector<double> thomas_cz;
+	// replicated across a batch of lines for the batched x-sweeps -- 1.7.2 
+	std::vector<double> thomas_constant1_batch; 
+	std::vector<double> thomas_denomx_batch; 
+	std::vector<double> thomas_cx_batch; 
+	// replicated across a tile of i-columns for the blocked y- and z-sweeps -- 1.7.2 
+	std::vector<double> thomas_constant1_tile; 
+	std::vector<double> thomas_denomy_tile; 
+	std::vector<double> thomas_cy_tile; 
+	std::vector<double> thomas_denomz_tile; 
+	std::vector<double> thomas_cz_tile; 
+	// factorization for line segments that start inside the domain (active-region diffusion), 
+	// over the longest mesh direction -- 1.7.2 
+	std::vector<double> thomas_denom_interior; 
+	std::vector<double> thomas_c_interior; 
+	std::vector<double> thomas_denom_interior_batch; 
+	std::vector<double> thomas_c_interior_batch; 
+	std::vector<double> thomas_denom_interior_tile; 
+	std::vector<double> thomas_c_interior_tile; 
 	bool diffusion_solver_setup_done; 
 	
+	/* for the variable-coefficient LOD solvers (new in 1.7.2). All of these 
+	   use the same layout as the densities. The factorizations are stored per 
+	   direction (x,y,z): face holds dt*D/dx^2 on the face below each voxel, 
+	   denom and c are the Thomas coefficients of each line. They are reused 
+	   until the coefficients or dt change. */ 
+	Density_Store variable_diffusion_coefficients; 
+	Density_Store variable_decay_rates; 
+	bool variable_coefficients_changed; 
+	double variable_thomas_dt; 
+	std::vector<Density_Store> variable_thomas_face; 
+	std::vector<Density_Store> variable_thomas_denom; 
+	std::vector<Density_Store> variable_thomas_c; 
+	
+	// counts calls to simulate_diffusion_decay, for the multirate schedule -- 1.7.2 
+	unsigned int diffusion_step_count; 
+	
+	/* for the steady-state multigrid solver (new in 1.7.2). The cell sources 
+	   and sinks are gathered on each solve into a reaction rate and a source 
+	   per voxel, entry (n,q) at [n*number_of_densities()+q]. */ 
+	std::vector<Multigrid_Level> multigrid_levels; 
+	std::vector<double> steady_state_reaction; 
+	std::vector<double> steady_state_source; 
+	
+	/* for the DCT solver (new in 1.7.2): the cosine transform along each 
+	   axis, and for the _exponential variant, the decay factor of each mode 
+	   along each axis, exp(-dt*D*eigenvalue), for each density (entry (q,i) 
+	   at [q*n+i]), kept for the last dt and coefficients. dct_line_factors 
+	   holds the part of each mode's step from all but the last axis, and 
+	   dct_work one density while it is transformed. */ 
+	Cosine_Transform dct_x, dct_y, dct_z; 
+	std::vector<double> dct_factors_x, dct_factors_y, dct_factors_z; 
+	double dct_factors_dt; 
+	std::vector<double> dct_factors_diffusion_coefficients; 
+	std::vector<double> dct_factors_decay_rates; 
+	std::vector<double> dct_line_factors; 
+	aligned_vector dct_work; 
+	
+	// one step of the DCT solvers, implicit or exact (new in 1.7.2) 
+	void constant_coefficients_DCT_step( double dt , bool exponential ); 
+	
+	/* for active-region diffusion (new in 1.7.2): the mesh is divided into 
+	   tiles of 8x8x8 voxels, and active_tiles flags the tiles to solve on 
+	   the current step (empty: solve them all). tile_changes holds the largest change in each tile 
+	   over the last step, measured against active_region_reference (entry 
+	   (n,q) at [n*number_of_densities()+q], only kept for active tiles). */ 
+	std::vector<bool> active_tiles; 
+	std::vector<double> tile_changes; 
+	std::vector<double> active_region_reference; 
+	bool active_region_stale; // solve every tile on the next step 
+	double last_skipped_voxel_fraction; 
+	double total_skipped_voxel_fraction; 
+	unsigned int active_region_steps; 
+	
+	// around each step of the blocked LOD solvers (new in 1.7.2): choose the 
+	// tiles to solve, and then record how much each of them changed 
+	void begin_active_region_step( void ); 
+	void end_active_region_step( void ); 
+	
 	// on "resize density" type operations, need to extend all of these 
 	
-	/*
-	std::vector<int> dirichlet_indices; 
-	std::vector< std::vector<double> > dirichlet_value_vectors; 
-	std::vector<bool> dirichlet_node_map; 
-	*/
 	std::vector< std::vector<double> > dirichlet_value_vectors; 
 	std::vector<bool> dirichlet_activation_vector; 
 	
@@ -133,6 +272,23 @@ class Microenvironment
 	   
 	std::vector< std::vector<bool> > dirichlet_activation_vectors; 
 	
+	/* new in 1.7.2 -- a compact list of the Dirichlet nodes, so that 
+	   apply_dirichlet_conditions() only touches those voxels. The 
+	   per-voxel vectors above remain the reference; the packed values and 
+	   activations (entry (t,q) at [t*number_of_densities()+q] for the t-th 
+	   node in dirichlet_indices) are refreshed from them when changed. */ 
+	
+	std::vector<int> dirichlet_indices; 
+	std::vector<int> dirichlet_node_map; // voxel index -> position in dirichlet_indices, or -1 
+	std::vector<double> dirichlet_packed_values; 
+	std::vector<char> dirichlet_packed_activation; 
+	bool dirichlet_node_list_stale; // rebuild dirichlet_indices from the mesh 
+	bool dirichlet_nodes_changed; // refresh the packed values and activations 
+	
+	void register_dirichlet_node( int voxel_index ); 
+	void unregister_dirichlet_node( int voxel_index ); 
+	void update_dirichlet_node_list( void ); 
+	
  public:
 	
 	/*! The mesh for the diffusing quantities */ 
@@ -155,6 +311,52 @@ class Microenvironment
 	std::vector< std::vector<double> > uptake_rates; 
 	void update_rates( void ); 
 	
+	/*! per-voxel diffusion coefficients and decay rates, used by the 
+	    variable-coefficient solvers. They start out equal to 
+	    diffusion_coefficients and decay_rates. -- 1.7.2 */ 
+	void initialize_variable_coefficients( void ); 
+	void set_variable_diffusion_coefficient( int voxel_index , int substrate_index , double value ); 
+	void set_variable_decay_rate( int voxel_index , int substrate_index , double value ); 
+	double get_variable_diffusion_coefficient( int voxel_index , int substrate_index ); 
+	double get_variable_decay_rate( int voxel_index , int substrate_index ); 
+	
+	/*! solve the y- and z-sweeps of the LOD solvers on tiles of adjacent 
+	    columns (cache-friendly) rather than one line at a time -- 1.7.2 */ 
+	bool blocked_diffusion_sweeps; 
+	
+	/*! multirate diffusion (new in 1.7.2): substrate q is advanced once every 
+	    diffusion_step_multiples[q] calls to simulate_diffusion_decay, by that 
+	    many time steps at once. Cell sources and sinks still act every step. 
+	    Supported by the constant-coefficient LOD solvers. All 1 by default. */ 
+	std::vector<int> diffusion_step_multiples; 
+	void set_diffusion_step_multiple( int substrate_index , int multiple ); 
+	int get_diffusion_step_multiple( int substrate_index ); 
+	bool multirate_diffusion( void ); 
+	// substrates advanced by the current call to simulate_diffusion_decay 
+	std::vector<unsigned int> active_diffusion_substrates; 
+	
+	/*! steady-state solver (new in 1.7.2): each solve runs V-cycles until the 
+	    largest residual is below steady_state_tolerance (relative to the size 
+	    of the terms in the equation), or steady_state_max_cycles is reached. */ 
+	double steady_state_tolerance; 
+	int steady_state_max_cycles; 
+	int steady_state_cycles; // V-cycles used by the last solve (most over all substrates) 
+	// true if diffusion_decay_solver is the steady-state solver. Agents then 
+	// leave their sources and sinks to the solver. 
+	bool steady_state_diffusion( void ); 
+	
+	/*! active-region diffusion (new in 1.7.2): when positive, the constant- 
+	    coefficient LOD solvers skip tiles of the mesh whose densities changed 
+	    by less than active_region_tolerance*(1+|density|) on the last step, 
+	    unless they hold (or border a tile that holds) cell sources and sinks 
+	    or such changes. 0 (the default) solves every voxel. */ 
+	double active_region_tolerance; 
+	// solve every tile on the next step. Call this after changing densities directly. 
+	void reset_active_region( void ); 
+	// fraction of voxel updates skipped by the last diffusion step, and on average so far 
+	double skipped_voxel_fraction( void ); 
+	double mean_skipped_voxel_fraction( void ); 
+	
 	Microenvironment(); 
 	Microenvironment(std::string name);
 	
@@ -181,6 +383,11 @@ class Microenvironment
 	void resize_space_uniform( double x_start, double x_end, double y_start, double y_end, double z_start, double z_end , double dx_new ); 
 
 	void resize_densities( int new_size );  
+	
+	/*! choose the memory layout of the density data (new in 1.7.2): 
+	    density_layout_voxel_major (default) or density_layout_substrate_major */ 
+	void set_density_layout( int layout ); 
+	int get_density_layout( void ); 
 	void add_density( void ); 
 	void add_density( std::string name , std::string units );
 	void add_density( std::string name , std::string units, double diffusion_constant, double decay_rate ); 
@@ -197,32 +404,39 @@ class Microenvironment
 	std::vector<unsigned int> nearest_cartesian_indices( std::vector<double>& position ); 
 	Voxel& nearest_voxel( std::vector<double>& position ); 
 	Voxel& voxels( int voxel_index );
-	std::vector<double>& nearest_density_vector( std::vector<double>& position );  
-	std::vector<double>& nearest_density_vector( int voxel_index );  
+	Density_Vector_View nearest_density_vector( std::vector<double>& position );  
+	Density_Vector_View nearest_density_vector( int voxel_index );  
 
 	/*! access the density vector at  [ X(i),Y(j),Z(k) ] */
-	std::vector<double>& operator()( int i, int j, int k ); 
+	Density_Vector_View operator()( int i, int j, int k ); 
 	/*! access the density vector at  [ X(i),Y(j),0 ]  -- helpful for 2-D problems */
-	std::vector<double>& operator()( int i, int j );  
+	Density_Vector_View operator()( int i, int j );  
 	/*! access the density vector at [x,y,z](n) */
-	std::vector<double>& operator()( int n );  
+	Density_Vector_View operator()( int n );  
+	
+	/*! the gradient of one substrate at voxel n (3 values), computed on first 
+	    use after the densities change -- 1.7.2 */ 
+	const double* substrate_gradient( int n , int substrate_index ); 
 	
-	std::vector<gradient>& gradient_vector(int i, int j, int k); 
-	std::vector<gradient>& gradient_vector(int i, int j ); 
-	std::vector<gradient>& gradient_vector(int n );  
+	// copies of the gradients of all substrates at a voxel (as of 1.7.2) 
+	std::vector<gradient> gradient_vector(int i, int j, int k); 
+	std::vector<gradient> gradient_vector(int i, int j ); 
+	std::vector<gradient> gradient_vector(int n );  
 	
-	std::vector<gradient>& nearest_gradient_vector( std::vector<double>& position ); 
+	std::vector<gradient> nearest_gradient_vector( std::vector<double>& position ); 
 
 	void compute_all_gradient_vectors( void ); 
 	void compute_gradient_vector( int n );  
+	// marks every gradient out of date, so it is recomputed when next read. This is 
+	// cheap, and done on each call to simulate_diffusion_decay. -- 1.7.2 
 	void reset_all_gradient_vectors( void ); 
 	
 	/*! access the density vector at  [ X(i),Y(j),Z(k) ] */
-	std::vector<double>& density_vector( int i, int j, int k ); 
+	Density_Vector_View density_vector( int i, int j, int k ); 
 	/*! access the density vector at  [ X(i),Y(j),0 ]  -- helpful for 2-D problems */
-	std::vector<double>& density_vector( int i, int j ); 
+	Density_Vector_View density_vector( int i, int j ); 
 	/*! access the density vector at [x,y,z](n) */
-	std::vector<double>& density_vector( int n ); 
+	Density_Vector_View density_vector( int n ); 
 
 	/*! advance the diffusion-decay solver by dt time */
 	void simulate_diffusion_decay( double dt ); 
@@ -254,14 +468,24 @@ class Microenvironment
 	bool get_substrate_dirichlet_activation( int substrate_index, int index );  
 	
 	bool& is_dirichlet_node( int voxel_index ); 
+	// number of voxels currently holding a Dirichlet condition -- 1.7.2 
+	unsigned int number_of_dirichlet_nodes( void ); 
 
 	friend void diffusion_decay_solver__constant_coefficients_explicit( Microenvironment& S, double dt ); 
 	friend void diffusion_decay_solver__constant_coefficients_explicit_uniform_mesh( Microenvironment& S, double dt ); 
 
 	friend void diffusion_decay_solver__constant_coefficients_LOD_3D( Microenvironment& S, double dt ); 
+	friend void diffusion_decay_solver__constant_coefficients_LOD_3D_sweep( Microenvironment& S, double dt , int direction ); 
 	friend void diffusion_decay_solver__constant_coefficients_LOD_2D( Microenvironment& S, double dt ); 
 	friend void diffusion_decay_solver__constant_coefficients_LOD_1D( Microenvironment& S, double dt ); 
 	
+	friend void diffusion_decay_solver__variable_coefficients_LOD_3D( Microenvironment& S, double dt ); 
+	friend void diffusion_decay_solver__variable_coefficients_LOD_2D( Microenvironment& S, double dt ); 
+	
+	friend void diffusion_decay_solver__steady_state_multigrid( Microenvironment& S, double dt ); 
+	friend void diffusion_decay_solver__constant_coefficients_DCT( Microenvironment& S, double dt ); 
+	friend void diffusion_decay_solver__constant_coefficients_DCT_exponential( Microenvironment& S, double dt ); 
+	
 	friend void diffusion_decay_explicit_uniform_rates( Microenvironment& M, double dt );
 	
 	void write_to_matlab( std::string filename );
@@ -290,6 +514,10 @@ extern void diffusion_decay_solver__variable_coefficients_LOD_2D( Microenvironme
 
 extern void diffusion_decay_source_sink_solver__constant_coefficients_LOD_3D( Microenvironment& S, double dt );
 
+extern void diffusion_decay_solver__steady_state_multigrid( Microenvironment& S, double dt ); 
+extern void diffusion_decay_solver__constant_coefficients_DCT( Microenvironment& S, double dt ); 
+extern void diffusion_decay_solver__constant_coefficients_DCT_exponential( Microenvironment& S, double dt ); 
+
 void zero_function( std::vector<double>& position, std::vector<double>& input , std::vector<double>* destination );
 void one_function( std::vector<double>& position, std::vector<double>& input , std::vector<double>* destination );
 
@@ -350,6 +578,17 @@ class Microenvironment_Options
 	bool use_oxygen_as_first_field;
 	
 	bool track_internalized_substrates_in_each_agent; 	
+	
+	// new in 1.7.2: memory layout of the density data (see Density_Store) 
+	int density_layout; 
+	// new in 1.7.2: cache-blocked y- and z-sweeps in the LOD solvers 
+	bool blocked_diffusion_sweeps; 
+	// new in 1.7.2: solve for the steady state (multigrid) rather than time-stepping 
+	bool steady_state_diffusion; 
+	double steady_state_tolerance; 
+	int steady_state_max_cycles; 
+	// new in 1.7.2: skip quiescent tiles in the LOD solvers (0: solve everywhere) 
+	double active_region_tolerance; 
 };
 
 extern Microenvironment_Options default_microenvironment_options; 
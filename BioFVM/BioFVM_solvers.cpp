@@ -48,6 +48,7 @@
 
 #include "BioFVM_solvers.h" 
 #include "BioFVM_vector.h" 
+#include "BioFVM_basic_agent.h" 
 
 #include <iostream>
 #include <omp.h>
@@ -93,437 +94,877 @@ void diffusion_decay_solver__constant_coefficients_explicit_uniform_mesh( Microe
 	return; 
 }
 
-void diffusion_decay_solver__constant_coefficients_LOD_3D( Microenvironment& M, double dt )
-{
-	if( M.mesh.regular_mesh == false || M.mesh.Cartesian_mesh == false )
-	{
-		std::cout << "Error: This algorithm is written for regular Cartesian meshes. Try: other solvers!" << std::endl << std::endl; 
-	return; 
-	}
+/* helper functions for the LOD solvers (new in 1.7.2). The Thomas 
+   coefficients are stored flat: entry (i,q) is at [i*number_of_densities+q]. */ 
 
-	// define constants and pre-computed quantities 
+// With interior set, the line is taken to continue past both ends (a segment 
+// of a longer line whose neighbors are held fixed), so no row gets the no-flux 
+// diagonal. 
+
+static void setup_thomas_coefficients( unsigned int size , std::vector<double>& constant1 , 
+	std::vector<double>& constant2 , std::vector<double>& denom , std::vector<double>& c , 
+	bool interior = false )
+{
+	unsigned int nd = constant1.size(); 
+	denom.assign( size*nd , 0.0 ); 
+	c.assign( size*nd , 0.0 ); 
 	
-	if( !M.diffusion_solver_setup_done )
+	for( unsigned int q=0; q < nd ; q++ )
 	{
-		std::cout << std::endl << "Using method " << __FUNCTION__ << " (implicit 3-D LOD with Thomas Algorithm) ... " 
-		<< std::endl << std::endl;  
-		
-		M.thomas_denomx.resize( M.mesh.x_coordinates.size() , M.zero );
-		M.thomas_cx.resize( M.mesh.x_coordinates.size() , M.zero );
-
-		M.thomas_denomy.resize( M.mesh.y_coordinates.size() , M.zero );
-		M.thomas_cy.resize( M.mesh.y_coordinates.size() , M.zero );
+		for( unsigned int i=0; i < size ; i++ )
+		{
+			c[i*nd+q] = -constant1[q]; 
+			denom[i*nd+q] = 1.0 + constant1[q] + constant1[q] + constant2[q]; 
+		}
+		if( interior == false )
+		{
+			denom[q] = 1.0 + constant1[q] + constant2[q]; 
+			denom[(size-1)*nd+q] = 1.0 + constant1[q] + constant2[q]; 
+			if( size == 1 )
+			{ denom[q] = 1.0 + constant2[q]; } 
+		}
 		
-		M.thomas_denomz.resize( M.mesh.z_coordinates.size() , M.zero );
-		M.thomas_cz.resize( M.mesh.z_coordinates.size() , M.zero );
-
-		M.thomas_i_jump = 1; 
-		M.thomas_j_jump = M.mesh.x_coordinates.size(); 
-		M.thomas_k_jump = M.thomas_j_jump * M.mesh.y_coordinates.size(); 
-
-		M.thomas_constant1 =  M.diffusion_coefficients; // dt*D/dx^2 
-		M.thomas_constant1a = M.zero; // -dt*D/dx^2; 
-		M.thomas_constant2 =  M.decay_rates; // (1/3)* dt*lambda 
-		M.thomas_constant3 = M.one; // 1 + 2*constant1 + constant2; 
-		M.thomas_constant3a = M.one; // 1 + constant1 + constant2; 		
-			
-		M.thomas_constant1 *= dt; 
-		M.thomas_constant1 /= M.mesh.dx; 
-		M.thomas_constant1 /= M.mesh.dx; 
-
-		M.thomas_constant1a = M.thomas_constant1; 
-		M.thomas_constant1a *= -1.0; 
-
-		M.thomas_constant2 *= dt; 
-		M.thomas_constant2 /= 3.0; // for the LOD splitting of the source 
-
-		M.thomas_constant3 += M.thomas_constant1; 
-		M.thomas_constant3 += M.thomas_constant1; 
-		M.thomas_constant3 += M.thomas_constant2; 
-
-		M.thomas_constant3a += M.thomas_constant1; 
-		M.thomas_constant3a += M.thomas_constant2; 
-
-		// Thomas solver coefficients 
-
-		M.thomas_cx.assign( M.mesh.x_coordinates.size() , M.thomas_constant1a ); 
-		M.thomas_denomx.assign( M.mesh.x_coordinates.size()  , M.thomas_constant3 ); 
-		M.thomas_denomx[0] = M.thomas_constant3a; 
-		M.thomas_denomx[ M.mesh.x_coordinates.size()-1 ] = M.thomas_constant3a; 
-		if( M.mesh.x_coordinates.size() == 1 )
-		{ M.thomas_denomx[0] = M.one; M.thomas_denomx[0] += M.thomas_constant2; } 
-
-		M.thomas_cx[0] /= M.thomas_denomx[0]; 
-		for( unsigned int i=1 ; i <= M.mesh.x_coordinates.size()-1 ; i++ )
-		{ 
-			axpy( &M.thomas_denomx[i] , M.thomas_constant1 , M.thomas_cx[i-1] ); 
-			M.thomas_cx[i] /= M.thomas_denomx[i]; // the value at  size-1 is not actually used  
-		}
-
-		M.thomas_cy.assign( M.mesh.y_coordinates.size() , M.thomas_constant1a ); 
-		M.thomas_denomy.assign( M.mesh.y_coordinates.size()  , M.thomas_constant3 ); 
-		M.thomas_denomy[0] = M.thomas_constant3a; 
-		M.thomas_denomy[ M.mesh.y_coordinates.size()-1 ] = M.thomas_constant3a; 
-		if( M.mesh.y_coordinates.size() == 1 )
-		{ M.thomas_denomy[0] = M.one; M.thomas_denomy[0] += M.thomas_constant2; } 
-
-		M.thomas_cy[0] /= M.thomas_denomy[0]; 
-		for( unsigned int i=1 ; i <= M.mesh.y_coordinates.size()-1 ; i++ )
-		{ 
-			axpy( &M.thomas_denomy[i] , M.thomas_constant1 , M.thomas_cy[i-1] ); 
-			M.thomas_cy[i] /= M.thomas_denomy[i]; // the value at  size-1 is not actually used  
-		}
-
-		M.thomas_cz.assign( M.mesh.z_coordinates.size() , M.thomas_constant1a ); 
-		M.thomas_denomz.assign( M.mesh.z_coordinates.size()  , M.thomas_constant3 ); 
-		M.thomas_denomz[0] = M.thomas_constant3a; 
-		M.thomas_denomz[ M.mesh.z_coordinates.size()-1 ] = M.thomas_constant3a; 
-		if( M.mesh.z_coordinates.size() == 1 )
-		{ M.thomas_denomz[0] = M.one; M.thomas_denomz[0] += M.thomas_constant2; } 
-
-		M.thomas_cz[0] /= M.thomas_denomz[0]; 
-		for( unsigned int i=1 ; i <= M.mesh.z_coordinates.size()-1 ; i++ )
-		{ 
-			axpy( &M.thomas_denomz[i] , M.thomas_constant1 , M.thomas_cz[i-1] ); 
-			M.thomas_cz[i] /= M.thomas_denomz[i]; // the value at  size-1 is not actually used  
-		}	
-
-		M.diffusion_solver_setup_done = true; 
+		c[q] /= denom[q]; 
+		for( unsigned int i=1; i < size ; i++ )
+		{
+			denom[i*nd+q] += constant1[q] * c[(i-1)*nd+q]; 
+			c[i*nd+q] /= denom[i*nd+q]; // the value at  size-1 is not actually used  
+		}
 	}
+	return; 
+}
 
-	// x-diffusion 
+// Thomas solve along one line of the mesh. p points at the first voxel of the line, 
+// voxel_jump is the distance (in doubles) between neighboring voxels on the line, 
+// and substrate_jump is the distance between substrates within a voxel. 
+
+static void thomas_solve_line( double* p , unsigned int count , unsigned int voxel_jump , 
+	unsigned int nd , unsigned int substrate_jump , 
+	const double* constant1 , const double* denom , const double* c )
+{
+	// remaining part of forward elimination, using pre-computed quantities 
+	for( unsigned int q=0; q < nd ; q++ )
+	{ p[q*substrate_jump] /= denom[q]; }
 	
-	M.apply_dirichlet_conditions();
-	#pragma omp parallel for 
-	for( unsigned int k=0; k < M.mesh.z_coordinates.size() ; k++ )
+	for( unsigned int i=1; i < count ; i++ )
 	{
-		for( unsigned int j=0; j < M.mesh.y_coordinates.size() ; j++ )
+		double* pCurrent = p + i*voxel_jump; 
+		double* pPrevious = pCurrent - voxel_jump; 
+		const double* pDenom = denom + i*nd; 
+		for( unsigned int q=0; q < nd ; q++ )
 		{
-			// Thomas solver, x-direction
+			pCurrent[q*substrate_jump] += constant1[q] * pPrevious[q*substrate_jump]; 
+			pCurrent[q*substrate_jump] /= pDenom[q]; 
+		}
+	}
+	
+	// back substitution 
+	for( int i = count-2 ; i >= 0 ; i-- )
+	{
+		double* pCurrent = p + i*voxel_jump; 
+		double* pNext = pCurrent + voxel_jump; 
+		const double* pC = c + i*nd; 
+		for( unsigned int q=0; q < nd ; q++ )
+		{ pCurrent[q*substrate_jump] -= pC[q] * pNext[q*substrate_jump]; }
+	}
+	return; 
+}
 
-			// remaining part of forward elimination, using pre-computed quantities 
-			int n = M.voxel_index(0,j,k);
-			(*M.p_density_vectors)[n] /= M.thomas_denomx[0]; 
+/* batched Thomas sweeps (new in 1.7.2). The coefficients are the same 
+   for every line in a direction, so we solve thomas_batch_width lines at 
+   once on a packed copy where the lines sit side by side. The inner loops 
+   then run over contiguous memory and vectorize cleanly. */ 
 
-			for( unsigned int i=1; i < M.mesh.x_coordinates.size() ; i++ )
-			{
-				n = M.voxel_index(i,j,k); 
-				axpy( &(*M.p_density_vectors)[n] , M.thomas_constant1 , (*M.p_density_vectors)[n-M.thomas_i_jump] ); 
-				(*M.p_density_vectors)[n] /= M.thomas_denomx[i]; 
-			}
+static const unsigned int thomas_batch_width = 8; 
 
-			for( int i = M.mesh.x_coordinates.size()-2 ; i >= 0 ; i-- )
+// replicates flat (i,q) coefficients across a batch of lines. Entry (i,w,q) is at 
+// [(i*width+w)*nd+q] for density_layout_voxel_major, or at [(i*nd+q)*width+w] for 
+// density_layout_substrate_major. 
+static void replicate_thomas_coefficients( unsigned int size , unsigned int nd , unsigned int width , 
+	std::vector<double>& in , std::vector<double>& out , int layout )
+{
+	out.resize( size*width*nd ); 
+	for( unsigned int i=0; i < size ; i++ )
+	{
+		for( unsigned int w=0; w < width ; w++ )
+		{
+			for( unsigned int q=0; q < nd ; q++ )
 			{
-				n = M.voxel_index(i,j,k); 
-				naxpy( &(*M.p_density_vectors)[n] , M.thomas_cx[i] , (*M.p_density_vectors)[n+M.thomas_i_jump] ); 
+				if( layout == density_layout_substrate_major )
+				{ out[ (i*nd+q)*width+w ] = in[ i*nd+q ]; }
+				else
+				{ out[ (i*width+w)*nd+q ] = in[ i*nd+q ]; }
 			}
-
 		}
 	}
+	return; 
+}
 
-	// y-diffusion 
-
-	M.apply_dirichlet_conditions();
-	#pragma omp parallel for 
-	for( unsigned int k=0; k < M.mesh.z_coordinates.size() ; k++ )
-	{
-		for( unsigned int i=0; i < M.mesh.x_coordinates.size() ; i++ )
-		{
-   // Thomas solver, y-direction
+// Thomas solve on packed data: row i holds "length" contiguous unknowns at 
+// p + i*data_jump, with matching coefficients at denom/c + i*coefficient_jump. 
+// For a segment solved with the interior factorization that runs up to the 
+// outer boundary, set no_flux_end: the last row then loses one constant1 from 
+// its diagonal, which lowers its denominator by constant1. 
 
+static void thomas_solve_packed( double* p , unsigned int count , unsigned int length , 
+	unsigned int data_jump , unsigned int coefficient_jump , 
+	const double* constant1 , const double* denom , const double* c , bool no_flux_end = false )
+{
 	// remaining part of forward elimination, using pre-computed quantities 
-
-	int n = M.voxel_index(i,0,k);
-	(*M.p_density_vectors)[n] /= M.thomas_denomy[0]; 
-
-	for( unsigned int j=1; j < M.mesh.y_coordinates.size() ; j++ )
+	if( no_flux_end && count == 1 )
 	{
-		n = M.voxel_index(i,j,k); 
-		axpy( &(*M.p_density_vectors)[n] , M.thomas_constant1 , (*M.p_density_vectors)[n-M.thomas_j_jump] ); 
-		(*M.p_density_vectors)[n] /= M.thomas_denomy[j]; 
+		#pragma omp simd
+		for( unsigned int m=0; m < length ; m++ )
+		{ p[m] /= denom[m] - constant1[m]; }
+		return; 
 	}
-
-	// back substitution 
-	// n = voxel_index( mesh.x_coordinates.size()-2 ,j,k); 
-
-	for( int j = M.mesh.y_coordinates.size()-2 ; j >= 0 ; j-- )
+	
+	#pragma omp simd
+	for( unsigned int m=0; m < length ; m++ )
+	{ p[m] /= denom[m]; }
+	
+	unsigned int last = no_flux_end ? count-1 : count; 
+	for( unsigned int i=1; i < last ; i++ )
 	{
-		n = M.voxel_index(i,j,k); 
-		naxpy( &(*M.p_density_vectors)[n] , M.thomas_cy[j] , (*M.p_density_vectors)[n+M.thomas_j_jump] ); 
+		double* pCurrent = p + i*data_jump; 
+		double* pPrevious = pCurrent - data_jump; 
+		const double* pDenom = denom + i*coefficient_jump; 
+		#pragma omp simd
+		for( unsigned int m=0; m < length ; m++ )
+		{
+			pCurrent[m] += constant1[m] * pPrevious[m]; 
+			pCurrent[m] /= pDenom[m]; 
+		}
 	}
-
-  }
- }
-
- // z-diffusion 
-
-	M.apply_dirichlet_conditions();
- #pragma omp parallel for 
- for( unsigned int j=0; j < M.mesh.y_coordinates.size() ; j++ )
- {
-	 
-  for( unsigned int i=0; i < M.mesh.x_coordinates.size() ; i++ )
-  {
-   // Thomas solver, y-direction
-
-	// remaining part of forward elimination, using pre-computed quantities 
-
-	int n = M.voxel_index(i,j,0);
-	(*M.p_density_vectors)[n] /= M.thomas_denomz[0]; 
-
-	// should be an empty loop if mesh.z_coordinates.size() < 2  
-	for( unsigned int k=1; k < M.mesh.z_coordinates.size() ; k++ )
+	if( no_flux_end )
 	{
-		n = M.voxel_index(i,j,k); 
-		axpy( &(*M.p_density_vectors)[n] , M.thomas_constant1 , (*M.p_density_vectors)[n-M.thomas_k_jump] ); 
-		(*M.p_density_vectors)[n] /= M.thomas_denomz[k]; 
+		double* pCurrent = p + last*data_jump; 
+		double* pPrevious = pCurrent - data_jump; 
+		const double* pDenom = denom + last*coefficient_jump; 
+		#pragma omp simd
+		for( unsigned int m=0; m < length ; m++ )
+		{
+			pCurrent[m] += constant1[m] * pPrevious[m]; 
+			pCurrent[m] /= pDenom[m] - constant1[m]; 
+		}
 	}
-
+	
 	// back substitution 
-
-	// should be an empty loop if mesh.z_coordinates.size() < 2 
-	for( int k = M.mesh.z_coordinates.size()-2 ; k >= 0 ; k-- )
+	for( int i = count-2 ; i >= 0 ; i-- )
 	{
-		n = M.voxel_index(i,j,k); 
-		naxpy( &(*M.p_density_vectors)[n] , M.thomas_cz[k] , (*M.p_density_vectors)[n+M.thomas_k_jump] ); 
-		// n -= i_jump; 
+		double* pCurrent = p + i*data_jump; 
+		double* pNext = pCurrent + data_jump; 
+		const double* pC = c + i*coefficient_jump; 
+		#pragma omp simd
+		for( unsigned int m=0; m < length ; m++ )
+		{ pCurrent[m] -= pC[m] * pNext[m]; }
 	}
-  }
- }
- 
-	M.apply_dirichlet_conditions();
-	
-	// reset gradient vectors 
-//	M.reset_all_gradient_vectors(); 
-
 	return; 
 }
 
-void diffusion_decay_solver__constant_coefficients_LOD_2D( Microenvironment& M, double dt )
+// solves up to thomas_batch_width x-lines. Line w starts at voxel first_voxel + w*line_jump. 
+// scratch must hold count*thomas_batch_width*number_of_densities values. The coefficients 
+// must be replicated over thomas_batch_width in the store's layout. In the substrate-major 
+// layout, only the substrates listed in active are solved. 
+// 
+// Only voxels start to end-1 of each line (of n voxels) are solved. Their neighbors 
+// outside that segment are held at their current values, and a segment that starts 
+// inside the line uses the interior factorization (active-region diffusion). 
+
+static void thomas_solve_x_lines( Density_Store& D , unsigned int first_voxel , unsigned int lines , 
+	unsigned int line_jump , unsigned int start , unsigned int end , unsigned int n , 
+	std::vector<double>& constant1 , std::vector<double>& denom , std::vector<double>& c , 
+	std::vector<double>& denom_interior , std::vector<double>& c_interior , double* scratch , 
+	const std::vector<unsigned int>& active )
 {
-	if( M.mesh.regular_mesh == false )
+	unsigned int nd = D.number_of_densities(); 
+	unsigned int vs = D.voxel_stride(); 
+	unsigned int ss = D.substrate_stride(); 
+	unsigned int row = thomas_batch_width*nd; 
+	unsigned int count = end - start; 
+	
+	const double* pDenom = denom.data(); 
+	const double* pC = c.data(); 
+	if( start > 0 )
 	{
-		std::cout << "Error: This algorithm is written for regular Cartesian meshes. Try: something else." << std::endl << std::endl; 
-		return; 
+		pDenom = denom_interior.data(); 
+		pC = c_interior.data(); 
 	}
+	bool no_flux_end = ( start > 0 && end == n ); 
 	
-	// constants for the linear solver (Thomas algorithm) 
-	
-	if( !M.diffusion_solver_setup_done )
+	if( D.layout() == density_layout_substrate_major )
 	{
-		std::cout << std::endl << "Using method " << __FUNCTION__ << " (2D LOD with Thomas Algorithm) ... " << std::endl << std::endl;  
-		
-		M.thomas_denomx.resize( M.mesh.x_coordinates.size() , M.zero );
-		M.thomas_cx.resize( M.mesh.x_coordinates.size() , M.zero );
-
-		M.thomas_denomy.resize( M.mesh.y_coordinates.size() , M.zero );
-		M.thomas_cy.resize( M.mesh.y_coordinates.size() , M.zero );
-		
-		// define constants and pre-computed quantities 
-
-		M.thomas_i_jump = 1; 
-		M.thomas_j_jump = M.mesh.x_coordinates.size(); 
-
-		M.thomas_constant1 =  M.diffusion_coefficients; //   dt*D/dx^2 
-		M.thomas_constant1a = M.zero; // -dt*D/dx^2; 
-		M.thomas_constant2 =  M.decay_rates; // (1/2)*dt*lambda 
-		M.thomas_constant3 = M.one; // 1 + 2*constant1 + constant2; 
-		M.thomas_constant3a = M.one; // 1 + constant1 + constant2; 
-		
-		M.thomas_constant1 *= dt; 
-		M.thomas_constant1 /= M.mesh.dx; 
-		M.thomas_constant1 /= M.mesh.dx; 
-
-		M.thomas_constant1a = M.thomas_constant1; 
-		M.thomas_constant1a *= -1.0; 
-
-		M.thomas_constant2 *= dt; 
-		M.thomas_constant2 *= 0.5; // for splitting via LOD
-
-		M.thomas_constant3 += M.thomas_constant1; 
-		M.thomas_constant3 += M.thomas_constant1; 
-		M.thomas_constant3 += M.thomas_constant2; 
-
-		M.thomas_constant3a += M.thomas_constant1; 
-		M.thomas_constant3a += M.thomas_constant2; 
-		
-		// Thomas solver coefficients 
-
-		M.thomas_cx.assign( M.mesh.x_coordinates.size() , M.thomas_constant1a ); 
-		M.thomas_denomx.assign( M.mesh.x_coordinates.size()  , M.thomas_constant3 ); 
-		M.thomas_denomx[0] = M.thomas_constant3a; 
-		M.thomas_denomx[ M.mesh.x_coordinates.size()-1 ] = M.thomas_constant3a; 
-		if( M.mesh.x_coordinates.size() == 1 )
-		{ M.thomas_denomx[0] = M.one; M.thomas_denomx[0] += M.thomas_constant2; } 
-
-		M.thomas_cx[0] /= M.thomas_denomx[0]; 
-		for( unsigned int i=1 ; i <= M.mesh.x_coordinates.size()-1 ; i++ )
-		{ 
-			axpy( &M.thomas_denomx[i] , M.thomas_constant1 , M.thomas_cx[i-1] ); 
-			M.thomas_cx[i] /= M.thomas_denomx[i]; // the value at  size-1 is not actually used  
-		}
-
-		M.thomas_cy.assign( M.mesh.y_coordinates.size() , M.thomas_constant1a ); 
-		M.thomas_denomy.assign( M.mesh.y_coordinates.size()  , M.thomas_constant3 ); 
-		M.thomas_denomy[0] = M.thomas_constant3a; 
-		M.thomas_denomy[ M.mesh.y_coordinates.size()-1 ] = M.thomas_constant3a; 
-		if( M.mesh.y_coordinates.size() == 1 )
-		{ M.thomas_denomy[0] = M.one; M.thomas_denomy[0] += M.thomas_constant2; } 
+		// one substrate at a time: each x-line is a contiguous run 
+		for( unsigned int a=0; a < active.size() ; a++ )
+		{
+			unsigned int q = active[a]; 
+			unsigned int offset = q*thomas_batch_width; 
+			for( unsigned int w=0; w < lines ; w++ )
+			{
+				double* pLine = D.data() + (first_voxel + w*line_jump)*vs + q*ss; 
+				for( unsigned int i=0; i < count ; i++ )
+				{ scratch[ i*thomas_batch_width + w ] = pLine[start+i]; }
+				// fixed neighbors just outside the segment 
+				if( start > 0 )
+				{ scratch[w] += constant1[offset+w] * pLine[start-1]; }
+				if( end < n )
+				{ scratch[ (count-1)*thomas_batch_width + w ] += constant1[offset+w] * pLine[end]; }
+			}
+			
+			thomas_solve_packed( scratch , count , lines , thomas_batch_width , row , 
+				constant1.data() + offset , pDenom + offset , pC + offset , no_flux_end ); 
 
-		M.thomas_cy[0] /= M.thomas_denomy[0]; 
-		for( unsigned int i=1 ; i <= M.mesh.y_coordinates.size()-1 ; i++ )
-		{ 
-			axpy( &M.thomas_denomy[i] , M.thomas_constant1 , M.thomas_cy[i-1] ); 
-			M.thomas_cy[i] /= M.thomas_denomy[i]; // the value at  size-1 is not actually used  
+			for( unsigned int w=0; w < lines ; w++ )
+			{
+				double* pLine = D.data() + (first_voxel + w*line_jump)*vs + q*ss; 
+				for( unsigned int i=0; i < count ; i++ )
+				{ pLine[start+i] = scratch[ i*thomas_batch_width + w ]; }
+			}
 		}
-
-		M.diffusion_solver_setup_done = true; 
+		return; 
 	}
-
-	// set the pointer
 	
-	M.apply_dirichlet_conditions();
-
-	// x-diffusion 
-	#pragma omp parallel for 
-	for( unsigned int j=0; j < M.mesh.y_coordinates.size() ; j++ )
+	// pack the lines side by side 
+	for( unsigned int w=0; w < lines ; w++ )
 	{
-		// Thomas solver, x-direction
-
-		// remaining part of forward elimination, using pre-computed quantities 
-		unsigned int n = M.voxel_index(0,j,0);
-		(*M.p_density_vectors)[n] /= M.thomas_denomx[0]; 
-
-		n += M.thomas_i_jump; 
-		for( unsigned int i=1; i < M.mesh.x_coordinates.size() ; i++ )
+		double* pLine = D.data() + (first_voxel + w*line_jump + start)*vs; 
+		for( unsigned int i=0; i < count ; i++ )
 		{
-			axpy( &(*M.p_density_vectors)[n] , M.thomas_constant1 , (*M.p_density_vectors)[n-M.thomas_i_jump] ); 
-			(*M.p_density_vectors)[n] /= M.thomas_denomx[i]; 
-			n += M.thomas_i_jump; 
+			for( unsigned int q=0; q < nd ; q++ )
+			{ scratch[ i*row + w*nd + q ] = pLine[ i*vs + q*ss ]; }
 		}
-
-		// back substitution 
-		n = M.voxel_index( M.mesh.x_coordinates.size()-2 ,j,0); 
-
-		for( int i = M.mesh.x_coordinates.size()-2 ; i >= 0 ; i-- )
+		if( start > 0 )
+		{
+			double* pBefore = pLine - vs; 
+			for( unsigned int q=0; q < nd ; q++ )
+			{ scratch[ w*nd + q ] += constant1[ w*nd + q ] * pBefore[ q*ss ]; }
+		}
+		if( end < n )
 		{
-			naxpy( &(*M.p_density_vectors)[n] , M.thomas_cx[i] , (*M.p_density_vectors)[n+M.thomas_i_jump] ); 
-			n -= M.thomas_i_jump; 
+			for( unsigned int q=0; q < nd ; q++ )
+			{ scratch[ (count-1)*row + w*nd + q ] += constant1[ w*nd + q ] * pLine[ count*vs + q*ss ]; }
 		}
 	}
 
-	// y-diffusion 
-
-	M.apply_dirichlet_conditions();
-	#pragma omp parallel for 
-	for( unsigned int i=0; i < M.mesh.x_coordinates.size() ; i++ )
+	thomas_solve_packed( scratch , count , lines*nd , row , row , constant1.data() , pDenom , pC , no_flux_end ); 
+	
+	// unpack 
+	for( unsigned int w=0; w < lines ; w++ )
 	{
-		// Thomas solver, y-direction
-
-		// remaining part of forward elimination, using pre-computed quantities 
-
-		int n = M.voxel_index(i,0,0);
-		(*M.p_density_vectors)[n] /= M.thomas_denomy[0]; 
-
-		n += M.thomas_j_jump; 
-		for( unsigned int j=1; j < M.mesh.y_coordinates.size() ; j++ )
+		double* pLine = D.data() + (first_voxel + w*line_jump + start)*vs; 
+		for( unsigned int i=0; i < count ; i++ )
 		{
-			axpy( &(*M.p_density_vectors)[n] , M.thomas_constant1 , (*M.p_density_vectors)[n-M.thomas_j_jump] ); 
-			(*M.p_density_vectors)[n] /= M.thomas_denomy[j]; 
-			n += M.thomas_j_jump; 
+			for( unsigned int q=0; q < nd ; q++ )
+			{ pLine[ i*vs + q*ss ] = scratch[ i*row + w*nd + q ]; }
 		}
+	}
+	return; 
+}
 
-		// back substitution 
-		n = M.voxel_index( i,M.mesh.y_coordinates.size()-2, 0); 
+/* cache-blocked sweeps (new in 1.7.2). In the y- and z-directions, each 
+   line is strided through memory by thomas_j_jump or thomas_k_jump voxels. 
+   Rather than walking one line at a time (a cache and TLB miss per voxel on 
+   large meshes), we solve a tile of thomas_tile_width adjacent i-columns 
+   together: each step of the sweep then touches one contiguous run of 
+   memory, and the tile stays in cache between forward elimination and 
+   back substitution. */ 
+
+static const unsigned int thomas_tile_width = 32; 
+
+// solves the lines through a tile of "columns" adjacent voxels starting at first_voxel. 
+// Consecutive unknowns on each line are line_jump voxels apart. The coefficients must 
+// be replicated over thomas_tile_width in the store's layout. In the substrate-major layout, 
+// only the substrates listed in active are solved. As in thomas_solve_x_lines, only the 
+// segment from start to end-1 of each line (of n voxels) is solved. 
+
+static void thomas_solve_tile( Density_Store& D , unsigned int first_voxel , unsigned int columns , 
+	unsigned int line_jump , unsigned int start , unsigned int end , unsigned int n , 
+	std::vector<double>& constant1 , std::vector<double>& denom , std::vector<double>& c , 
+	std::vector<double>& denom_interior , std::vector<double>& c_interior , 
+	const std::vector<unsigned int>& active )
+{
+	unsigned int nd = D.number_of_densities(); 
+	unsigned int vs = D.voxel_stride(); 
+	unsigned int ss = D.substrate_stride(); 
+	unsigned int count = end - start; 
+	unsigned int data_jump = line_jump*vs; 
+	double* p = D.data() + (first_voxel + start*line_jump)*vs; 
+	
+	const double* pDenom = denom.data(); 
+	const double* pC = c.data(); 
+	if( start > 0 )
+	{
+		pDenom = denom_interior.data(); 
+		pC = c_interior.data(); 
+	}
+	bool no_flux_end = ( start > 0 && end == n ); 
 
-		for( int j = M.mesh.y_coordinates.size()-2 ; j >= 0 ; j-- )
+	if( D.layout() == density_layout_substrate_major )
+	{
+		// each substrate is its own contiguous field: one run per substrate 
+		unsigned int row = nd*thomas_tile_width; 
+		for( unsigned int a=0; a < active.size() ; a++ )
 		{
-			naxpy( &(*M.p_density_vectors)[n] , M.thomas_cy[j] , (*M.p_density_vectors)[n+M.thomas_j_jump] ); 
-			n -= M.thomas_j_jump; 
+			unsigned int q = active[a]; 
+			unsigned int offset = q*thomas_tile_width; 
+			double* pq = p + q*ss; 
+			
+			// fixed neighbors just outside the segment 
+			if( start > 0 )
+			{
+				double* pBefore = pq - data_jump; 
+				for( unsigned int m=0; m < columns ; m++ )
+				{ pq[m] += constant1[offset+m] * pBefore[m]; }
+			}
+			if( end < n )
+			{
+				double* pLast = pq + (count-1)*data_jump; 
+				double* pAfter = pLast + data_jump; 
+				for( unsigned int m=0; m < columns ; m++ )
+				{ pLast[m] += constant1[offset+m] * pAfter[m]; }
+			}
+			
+			thomas_solve_packed( pq , count , columns , data_jump , row , 
+				constant1.data() + offset , pDenom + offset , pC + offset , no_flux_end ); 
 		}
+		return; 
 	}
-
-	M.apply_dirichlet_conditions();
 	
-	// reset gradient vectors 
-//	M.reset_all_gradient_vectors(); 
+	// substrates are interleaved: the tile is a single contiguous run 
+	unsigned int length = columns*nd; 
+	if( start > 0 )
+	{
+		double* pBefore = p - data_jump; 
+		for( unsigned int m=0; m < length ; m++ )
+		{ p[m] += constant1[m] * pBefore[m]; }
+	}
+	if( end < n )
+	{
+		double* pLast = p + (count-1)*data_jump; 
+		double* pAfter = pLast + data_jump; 
+		for( unsigned int m=0; m < length ; m++ )
+		{ pLast[m] += constant1[m] * pAfter[m]; }
+	}
 	
+	thomas_solve_packed( p , count , length , data_jump , thomas_tile_width*nd , 
+		constant1.data() , pDenom , pC , no_flux_end ); 
 	return; 
 }
 
-void diffusion_decay_explicit_uniform_rates( Microenvironment& M, double dt )
+// Thomas solve along one line of a substrate-major store, for the listed substrates only 
+
+static void thomas_solve_line_substrates( Density_Store& D , unsigned int first_voxel , unsigned int count , 
+	unsigned int line_jump , std::vector<double>& constant1 , std::vector<double>& denom , 
+	std::vector<double>& c , const std::vector<unsigned int>& active )
 {
-	using std::vector; 
-	using std::cout; 
-	using std::endl; 
+	unsigned int nd = D.number_of_densities(); 
+	unsigned int vs = D.voxel_stride(); 
+	unsigned int ss = D.substrate_stride(); 
+	for( unsigned int a=0; a < active.size() ; a++ )
+	{
+		unsigned int q = active[a]; 
+		thomas_solve_packed( D.data() + first_voxel*vs + q*ss , count , 1 , line_jump*vs , nd , 
+			constant1.data() + q , denom.data() + q , c.data() + q ); 
+	}
+	return; 
+}
 
-	// static int n_jump_i = 1; 
-	// static int n_jump_j = M.mesh.x_coordinates.size(); 
-	// static int n_jump_k = M.mesh.x_coordinates.size() * M.mesh.y_coordinates.size(); 
+// the substrates to advance: all of them, unless a multirate step selected fewer 
 
-	if( !M.diffusion_solver_setup_done )
-	{	
-		M.thomas_i_jump = 1; 
-		M.thomas_j_jump = M.mesh.x_coordinates.size(); 
-		M.thomas_k_jump = M.thomas_j_jump * M.mesh.y_coordinates.size(); 
-	
-		M.diffusion_solver_setup_done = true; 
-	}
-	
-	if( M.mesh.uniform_mesh == false )
+static const std::vector<unsigned int>& diffusion_substrates( Microenvironment& M )
+{
+	if( M.multirate_diffusion() == false && M.active_diffusion_substrates.size() != M.number_of_densities() )
 	{
-		cout << "Error: This algorithm is written for uniform Cartesian meshes. Try: something else" << endl << endl; 
-		return; 
+		M.active_diffusion_substrates.resize( M.number_of_densities() ); 
+		for( unsigned int q=0; q < M.number_of_densities() ; q++ )
+		{ M.active_diffusion_substrates[q] = q; }
 	}
+	return M.active_diffusion_substrates; 
+}
 
-	// double buffering to reduce memory copy / allocation overhead 
-
-	static vector< vector<double> >* pNew = &(M.temporary_density_vectors1);
-	static vector< vector<double> >* pOld = &(M.temporary_density_vectors2);
+// dt for each substrate: multirate substrates take several steps at once 
 
-	// swap the buffers 
+static std::vector<double> substrate_time_steps( Microenvironment& M , double dt )
+{
+	std::vector<double> out( M.number_of_densities() , dt ); 
+	for( unsigned int q=0; q < out.size() ; q++ )
+	{ out[q] *= M.diffusion_step_multiples[q]; }
+	return out; 
+}
 
-	vector< vector<double> >* pTemp = pNew; 
-	pNew = pOld; 
-	pOld = pTemp; 
-	M.p_density_vectors = pNew; 
+/* active-region diffusion (new in 1.7.2). The mesh is divided into tiles 
+   of active_tile_width^3 voxels (one layer of tiles in 2-D). Tiles that are 
+   quiescent -- their densities barely moved on the last step, and no cell 
+   sits in or next to them -- are held fixed, and the Thomas sweeps only 
+   solve the runs of active tiles along each line. The tile width matches 
+   thomas_batch_width, so each batch of x-lines is exactly one row of tiles. */ 
 
-	// static bool reaction_diffusion_shortcuts_are_set = false; 
+static const unsigned int active_tile_width = thomas_batch_width; 
 
-	static vector<double> constant1 = (1.0 / ( M.mesh.dx * M.mesh.dx )) * M.diffusion_coefficients; 
-	static vector<double> constant2 = dt * constant1; 
-	static vector<double> constant3 = M.one + dt * M.decay_rates;
+static unsigned int active_tile_count( unsigned int n )
+{ return (n + active_tile_width - 1) / active_tile_width; }
 
-	static vector<double> constant4 = M.one - dt * M.decay_rates;
+// voxel bounds [lower,upper) of tile t along each axis 
 
-	#pragma omp parallel for
-	for( unsigned int i=0; i < (*(M.p_density_vectors)).size() ; i++ )
+static void active_tile_bounds( unsigned int t , unsigned int nx , unsigned int ny , unsigned int nz , 
+	unsigned int* lower , unsigned int* upper )
+{
+	unsigned int tiles_x = active_tile_count( nx ); 
+	unsigned int tiles_y = active_tile_count( ny ); 
+	unsigned int n[3] = { nx , ny , nz }; 
+	unsigned int tile[3] = { t % tiles_x , (t / tiles_x) % tiles_y , t / (tiles_x*tiles_y) }; 
+	for( unsigned int d=0; d < 3 ; d++ )
 	{
-		unsigned int number_of_neighbors = M.mesh.connected_voxel_indices[i].size(); 
+		lower[d] = tile[d]*active_tile_width; 
+		upper[d] = std::min( lower[d] + active_tile_width , n[d] ); 
+	}
+	return; 
+}
 
-		double d1 = -1.0 * number_of_neighbors; 
+// finds the next run of active tiles along a line of tiles (tile m of the line is 
+// first_tile + m*tile_jump), starting the search at t. Returns false if there is none. 
+
+static bool next_active_run( const std::vector<bool>& active_tiles , unsigned int first_tile , unsigned int tile_jump , 
+	unsigned int tiles , unsigned int& t , unsigned int& run_start , unsigned int& run_end )
+{
+	while( t < tiles && active_tiles[ first_tile + t*tile_jump ] == false )
+	{ t++; }
+	if( t == tiles )
+	{ return false; }
+	
+	run_start = t; 
+	while( t < tiles && active_tiles[ first_tile + t*tile_jump ] == true )
+	{ t++; }
+	run_end = t; 
+	return true; 
+}
 
-		(*pNew)[i] = (*pOld)[i];  
-		(*pNew)[i] *= constant4; 
+// copies the densities of one tile into reference (entry (n,q) at [n*nd+q]), or, if 
+// measure is set, returns the largest relative change since they were copied 
 
-		for( unsigned int j=0; j < number_of_neighbors ; j++ )
+static double active_tile_reference( Density_Store& D , std::vector<double>& reference , 
+	unsigned int* lower , unsigned int* upper , unsigned int nx , unsigned int ny , bool measure )
+{
+	unsigned int nd = D.number_of_densities(); 
+	unsigned int vs = D.voxel_stride(); 
+	unsigned int ss = D.substrate_stride(); 
+	double change = 0.0; 
+	
+	for( unsigned int k=lower[2]; k < upper[2] ; k++ )
+	{
+		for( unsigned int j=lower[1]; j < upper[1] ; j++ )
 		{
-			axpy( &(*pNew)[i], constant2, (*pOld)[  M.mesh.connected_voxel_indices[i][j] ] ); 
+			for( unsigned int i=lower[0]; i < upper[0] ; i++ )
+			{
+				unsigned int n = i + nx*( j + ny*k ); 
+				const double* pDensity = D.data() + n*vs; 
+				double* pReference = reference.data() + n*nd; 
+				for( unsigned int q=0; q < nd ; q++ )
+				{
+					double value = pDensity[q*ss]; 
+					if( measure )
+					{ change = std::max( change , fabs( value - pReference[q] ) / ( 1.0 + fabs( value ) ) ); }
+					else
+					{ pReference[q] = value; }
+				}
+			}
 		}
-		vector<double> temp = constant2; 
-		temp *= d1; 
-		axpy( &(*pNew)[i] , temp , (*pOld)[i] ); 
 	}
-	
-	// reset gradient vectors 
-//	M.reset_all_gradient_vectors(); 
-
-	return; 
+	return change; 
 }
 
-void diffusion_decay_solver__constant_coefficients_LOD_1D( Microenvironment& M, double dt )
+// chooses the tiles to solve on this step. An empty active_tiles means all of them. 
+
+void Microenvironment::begin_active_region_step( void )
 {
-	if( M.mesh.regular_mesh == false )
+	active_tiles.clear(); 
+	if( active_region_tolerance <= 0.0 || blocked_diffusion_sweeps == false )
+	{ return; }
+	
+	Density_Store& D = *p_density_vectors; 
+	unsigned int nx = mesh.x_coordinates.size(); 
+	unsigned int ny = mesh.y_coordinates.size(); 
+	unsigned int nz = mesh.z_coordinates.size(); 
+	unsigned int tiles_x = active_tile_count( nx ); 
+	unsigned int tiles_y = active_tile_count( ny ); 
+	unsigned int tiles_z = active_tile_count( nz ); 
+	unsigned int number_of_tiles = tiles_x*tiles_y*tiles_z; 
+	
+	// solve everywhere after changes that the tile history does not reflect 
+	bool solve_all = active_region_stale || diffusion_solver_setup_done == false || 
+		dirichlet_node_list_stale || dirichlet_nodes_changed || 
+		tile_changes.size() != number_of_tiles || 
+		active_region_reference.size() != number_of_voxels()*number_of_densities(); 
+	
+	if( solve_all == false )
+	{
+		// seed with the tiles that changed on the last step, and those holding cells 
+		std::vector<char> seeds( number_of_tiles , 0 ); 
+		for( unsigned int t=0; t < number_of_tiles ; t++ )
+		{
+			if( tile_changes[t] > active_region_tolerance )
+			{ seeds[t] = 1; }
+		}
+		for( unsigned int a=0; a < all_basic_agents.size() ; a++ )
+		{
+			int n = all_basic_agents[a]->get_current_voxel_index(); 
+			if( all_basic_agents[a]->get_microenvironment() != this || n < 0 )
+			{ continue; }
+			unsigned int i = n % nx; 
+			unsigned int j = (n / nx) % ny; 
+			unsigned int k = n / (nx*ny); 
+			seeds[ ( (k/active_tile_width)*tiles_y + j/active_tile_width )*tiles_x + i/active_tile_width ] = 1; 
+		}
+		
+		// ... and activate them along with their neighbors 
+		active_tiles.assign( number_of_tiles , false ); 
+		unsigned int number_of_active_tiles = 0; 
+		for( unsigned int tk=0; tk < tiles_z ; tk++ )
+		{
+			for( unsigned int tj=0; tj < tiles_y ; tj++ )
+			{
+				for( unsigned int ti=0; ti < tiles_x ; ti++ )
+				{
+					if( seeds[ (tk*tiles_y + tj)*tiles_x + ti ] == 0 )
+					{ continue; }
+					for( unsigned int k = (tk > 0 ? tk-1 : 0); k <= std::min( tk+1 , tiles_z-1 ) ; k++ )
+					{
+						for( unsigned int j = (tj > 0 ? tj-1 : 0); j <= std::min( tj+1 , tiles_y-1 ) ; j++ )
+						{
+							for( unsigned int i = (ti > 0 ? ti-1 : 0); i <= std::min( ti+1 , tiles_x-1 ) ; i++ )
+							{
+								unsigned int t = (k*tiles_y + j)*tiles_x + i; 
+								if( active_tiles[t] == false )
+								{
+									active_tiles[t] = true; 
+									number_of_active_tiles++; 
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+		if( number_of_active_tiles == number_of_tiles )
+		{ active_tiles.clear(); }
+	}
+	else
+	{
+		active_region_stale = false; 
+		tile_changes.assign( number_of_tiles , 0.0 ); 
+		active_region_reference.resize( number_of_voxels()*number_of_densities() ); 
+	}
+	
+	// remember the starting densities of the tiles to solve 
+	#pragma omp parallel for 
+	for( unsigned int t=0; t < number_of_tiles ; t++ )
+	{
+		if( active_tiles.size() > 0 && active_tiles[t] == false )
+		{ continue; }
+		unsigned int lower[3], upper[3]; 
+		active_tile_bounds( t , nx , ny , nz , lower , upper ); 
+		active_tile_reference( D , active_region_reference , lower , upper , nx , ny , false ); 
+	}
+	return; 
+}
+
+// records how much each solved tile changed, and the fraction of voxels skipped 
+
+void Microenvironment::end_active_region_step( void )
+{
+	last_skipped_voxel_fraction = 0.0; 
+	if( active_region_tolerance <= 0.0 || blocked_diffusion_sweeps == false )
+	{ return; }
+	
+	Density_Store& D = *p_density_vectors; 
+	unsigned int nx = mesh.x_coordinates.size(); 
+	unsigned int ny = mesh.y_coordinates.size(); 
+	unsigned int nz = mesh.z_coordinates.size(); 
+	unsigned int number_of_tiles = tile_changes.size(); 
+	
+	double solved_voxels = 0.0; 
+	#pragma omp parallel for reduction(+:solved_voxels) 
+	for( unsigned int t=0; t < number_of_tiles ; t++ )
+	{
+		if( active_tiles.size() > 0 && active_tiles[t] == false )
+		{
+			tile_changes[t] = 0.0; 
+			continue; 
+		}
+		unsigned int lower[3], upper[3]; 
+		active_tile_bounds( t , nx , ny , nz , lower , upper ); 
+		tile_changes[t] = active_tile_reference( D , active_region_reference , lower , upper , nx , ny , true ); 
+		solved_voxels += (double) (upper[0]-lower[0]) * (upper[1]-lower[1]) * (upper[2]-lower[2]); 
+	}
+	
+	last_skipped_voxel_fraction = 1.0 - solved_voxels / (double) number_of_voxels(); 
+	total_skipped_voxel_fraction += last_skipped_voxel_fraction; 
+	active_region_steps++; 
+	
+	// sweeps called outside of a full step solve everywhere 
+	active_tiles.clear(); 
+	return; 
+}
+
+void diffusion_decay_solver__constant_coefficients_LOD_3D_sweep( Microenvironment& M, double dt , int direction )
+{
+	// define constants and pre-computed quantities 
+	
+	if( !M.diffusion_solver_setup_done )
+	{
+		std::cout << std::endl << "Using method diffusion_decay_solver__constant_coefficients_LOD_3D (implicit 3-D LOD with Thomas Algorithm) ... " 
+		<< std::endl << std::endl;  
+		
+		M.thomas_i_jump = 1; 
+		M.thomas_j_jump = M.mesh.x_coordinates.size(); 
+		M.thomas_k_jump = M.thomas_j_jump * M.mesh.y_coordinates.size(); 
+
+		M.thomas_constant1 =  M.diffusion_coefficients; // dt*D/dx^2 
+		M.thomas_constant2 =  M.decay_rates; // (1/3)* dt*lambda 
+		std::vector<double> substrate_dt = substrate_time_steps( M , dt ); 
+			
+		M.thomas_constant1 *= substrate_dt; 
+		M.thomas_constant1 /= M.mesh.dx; 
+		M.thomas_constant1 /= M.mesh.dx; 
+
+		M.thomas_constant2 *= substrate_dt; 
+		M.thomas_constant2 /= 3.0; // for the LOD splitting of the source 
+
+		// Thomas solver coefficients 
+
+		setup_thomas_coefficients( M.mesh.x_coordinates.size() , M.thomas_constant1 , M.thomas_constant2 , M.thomas_denomx , M.thomas_cx ); 
+		setup_thomas_coefficients( M.mesh.y_coordinates.size() , M.thomas_constant1 , M.thomas_constant2 , M.thomas_denomy , M.thomas_cy ); 
+		setup_thomas_coefficients( M.mesh.z_coordinates.size() , M.thomas_constant1 , M.thomas_constant2 , M.thomas_denomz , M.thomas_cz ); 
+
+		// coefficients for the batched x-sweeps 
+		unsigned int nd = M.number_of_densities(); 
+		int layout = M.get_density_layout(); 
+		replicate_thomas_coefficients( 1 , nd , thomas_batch_width , M.thomas_constant1 , M.thomas_constant1_batch , layout ); 
+		replicate_thomas_coefficients( M.mesh.x_coordinates.size() , nd , thomas_batch_width , M.thomas_denomx , M.thomas_denomx_batch , layout ); 
+		replicate_thomas_coefficients( M.mesh.x_coordinates.size() , nd , thomas_batch_width , M.thomas_cx , M.thomas_cx_batch , layout ); 
+		
+		// coefficients for the blocked y- and z-sweeps 
+		replicate_thomas_coefficients( 1 , nd , thomas_tile_width , M.thomas_constant1 , M.thomas_constant1_tile , layout ); 
+		replicate_thomas_coefficients( M.mesh.y_coordinates.size() , nd , thomas_tile_width , M.thomas_denomy , M.thomas_denomy_tile , layout ); 
+		replicate_thomas_coefficients( M.mesh.y_coordinates.size() , nd , thomas_tile_width , M.thomas_cy , M.thomas_cy_tile , layout ); 
+		replicate_thomas_coefficients( M.mesh.z_coordinates.size() , nd , thomas_tile_width , M.thomas_denomz , M.thomas_denomz_tile , layout ); 
+		replicate_thomas_coefficients( M.mesh.z_coordinates.size() , nd , thomas_tile_width , M.thomas_cz , M.thomas_cz_tile , layout ); 
+		
+		// coefficients for line segments that start inside the domain (active-region diffusion) 
+		unsigned int longest = std::max( M.mesh.x_coordinates.size() , std::max( M.mesh.y_coordinates.size() , M.mesh.z_coordinates.size() ) ); 
+		setup_thomas_coefficients( longest , M.thomas_constant1 , M.thomas_constant2 , M.thomas_denom_interior , M.thomas_c_interior , true ); 
+		replicate_thomas_coefficients( longest , nd , thomas_batch_width , M.thomas_denom_interior , M.thomas_denom_interior_batch , layout ); 
+		replicate_thomas_coefficients( longest , nd , thomas_batch_width , M.thomas_c_interior , M.thomas_c_interior_batch , layout ); 
+		replicate_thomas_coefficients( longest , nd , thomas_tile_width , M.thomas_denom_interior , M.thomas_denom_interior_tile , layout ); 
+		replicate_thomas_coefficients( longest , nd , thomas_tile_width , M.thomas_c_interior , M.thomas_c_interior_tile , layout ); 
+
+		M.diffusion_solver_setup_done = true; 
+	}
+
+	Density_Store& D = *M.p_density_vectors; 
+	unsigned int nd = D.number_of_densities(); 
+	unsigned int vs = D.voxel_stride(); 
+	unsigned int ss = D.substrate_stride(); 
+	const std::vector<unsigned int>& active = diffusion_substrates( M ); 
+	
+	unsigned int nx = M.mesh.x_coordinates.size(); 
+	unsigned int ny = M.mesh.y_coordinates.size(); 
+	unsigned int nz = M.mesh.z_coordinates.size(); 
+	
+	unsigned int tiles_per_row = (nx + thomas_tile_width - 1) / thomas_tile_width; 
+	
+	// active-region diffusion: solve only the runs of active tiles along each line 
+	bool active_region = ( M.blocked_diffusion_sweeps && M.active_tiles.size() > 0 ); 
+	unsigned int tiles_x = active_tile_count( nx ); 
+	unsigned int tiles_y = active_tile_count( ny ); 
+	unsigned int tiles_z = active_tile_count( nz ); 
+
+	M.apply_dirichlet_conditions();
+	
+	if( direction == 0 )
+	{
+		// x-diffusion (batches of x-lines along j)
+		
+		unsigned int batches_per_plane = (ny + thomas_batch_width - 1) / thomas_batch_width; 
+		
+		#pragma omp parallel 
+		{
+			aligned_vector scratch( nx*thomas_batch_width*nd ); 
+			
+			#pragma omp for schedule(dynamic) 
+			for( unsigned int b=0; b < nz*batches_per_plane ; b++ )
+			{
+				unsigned int k = b / batches_per_plane; 
+				unsigned int j = (b % batches_per_plane)*thomas_batch_width; 
+				unsigned int lines = std::min( thomas_batch_width , ny-j ); 
+				
+				// Thomas solver, x-direction
+				if( active_region == false )
+				{
+					thomas_solve_x_lines( D , M.voxel_index(0,j,k) , lines , M.thomas_j_jump , 0 , nx , nx , 
+						M.thomas_constant1_batch , M.thomas_denomx_batch , M.thomas_cx_batch , 
+						M.thomas_denom_interior_batch , M.thomas_c_interior_batch , scratch.data() , active ); 
+					continue; 
+				}
+				
+				unsigned int first_tile = ( (k/active_tile_width)*tiles_y + j/active_tile_width )*tiles_x; 
+				unsigned int t = 0, run_start, run_end; 
+				while( next_active_run( M.active_tiles , first_tile , 1 , tiles_x , t , run_start , run_end ) )
+				{
+					thomas_solve_x_lines( D , M.voxel_index(0,j,k) , lines , M.thomas_j_jump , 
+						run_start*active_tile_width , std::min( run_end*active_tile_width , nx ) , nx , 
+						M.thomas_constant1_batch , M.thomas_denomx_batch , M.thomas_cx_batch , 
+						M.thomas_denom_interior_batch , M.thomas_c_interior_batch , scratch.data() , active ); 
+				}
+			}
+		}
+		return; 
+	}
+
+	if( direction == 1 )
+	{
+		// y-diffusion 
+		
+		if( active_region )
+		{
+			// columns one active tile wide, so that each run of tiles has a single pattern 
+			#pragma omp parallel for schedule(dynamic) 
+			for( unsigned int b=0; b < nz*tiles_x ; b++ )
+			{
+				unsigned int k = b / tiles_x; 
+				unsigned int i = (b % tiles_x)*active_tile_width; 
+				unsigned int first_tile = (k/active_tile_width)*tiles_y*tiles_x + b % tiles_x; 
+				unsigned int t = 0, run_start, run_end; 
+				while( next_active_run( M.active_tiles , first_tile , tiles_x , tiles_y , t , run_start , run_end ) )
+				{
+					thomas_solve_tile( D , M.voxel_index(i,0,k) , std::min( active_tile_width , nx-i ) , M.thomas_j_jump , 
+						run_start*active_tile_width , std::min( run_end*active_tile_width , ny ) , ny , 
+						M.thomas_constant1_tile , M.thomas_denomy_tile , M.thomas_cy_tile , 
+						M.thomas_denom_interior_tile , M.thomas_c_interior_tile , active ); 
+				}
+			}
+			return; 
+		}
+		
+		if( M.blocked_diffusion_sweeps )
+		{
+			#pragma omp parallel for 
+			for( unsigned int b=0; b < nz*tiles_per_row ; b++ )
+			{
+				unsigned int k = b / tiles_per_row; 
+				unsigned int i = (b % tiles_per_row)*thomas_tile_width; 
+				
+				// Thomas solver, y-direction, for a tile of i-columns 
+				thomas_solve_tile( D , M.voxel_index(i,0,k) , std::min( thomas_tile_width , nx-i ) , M.thomas_j_jump , 0 , ny , ny , 
+					M.thomas_constant1_tile , M.thomas_denomy_tile , M.thomas_cy_tile , 
+					M.thomas_denom_interior_tile , M.thomas_c_interior_tile , active ); 
+			}
+			return; 
+		}
+
+		#pragma omp parallel for 
+		for( unsigned int k=0; k < nz ; k++ )
+		{
+			for( unsigned int i=0; i < nx ; i++ )
+			{
+				// Thomas solver, y-direction
+				int n = M.voxel_index(i,0,k);
+				if( D.layout() == density_layout_substrate_major )
+				{
+					thomas_solve_line_substrates( D , n , ny , M.thomas_j_jump , 
+						M.thomas_constant1 , M.thomas_denomy , M.thomas_cy , active ); 
+					continue; 
+				}
+				thomas_solve_line( D.data() + n*vs , ny , M.thomas_j_jump*vs , nd , ss , 
+					M.thomas_constant1.data() , M.thomas_denomy.data() , M.thomas_cy.data() ); 
+			}
+		}
+		return; 
+	}
+	
+	// z-diffusion 
+
+	if( active_region )
+	{
+		#pragma omp parallel for schedule(dynamic) 
+		for( unsigned int b=0; b < ny*tiles_x ; b++ )
+		{
+			unsigned int j = b / tiles_x; 
+			unsigned int i = (b % tiles_x)*active_tile_width; 
+			unsigned int first_tile = (j/active_tile_width)*tiles_x + b % tiles_x; 
+			unsigned int t = 0, run_start, run_end; 
+			while( next_active_run( M.active_tiles , first_tile , tiles_x*tiles_y , tiles_z , t , run_start , run_end ) )
+			{
+				thomas_solve_tile( D , M.voxel_index(i,j,0) , std::min( active_tile_width , nx-i ) , M.thomas_k_jump , 
+					run_start*active_tile_width , std::min( run_end*active_tile_width , nz ) , nz , 
+					M.thomas_constant1_tile , M.thomas_denomz_tile , M.thomas_cz_tile , 
+					M.thomas_denom_interior_tile , M.thomas_c_interior_tile , active ); 
+			}
+		}
+		return; 
+	}
+
+	if( M.blocked_diffusion_sweeps )
+	{
+		#pragma omp parallel for 
+		for( unsigned int b=0; b < ny*tiles_per_row ; b++ )
+		{
+			unsigned int j = b / tiles_per_row; 
+			unsigned int i = (b % tiles_per_row)*thomas_tile_width; 
+			
+			// Thomas solver, z-direction, for a tile of i-columns 
+			thomas_solve_tile( D , M.voxel_index(i,j,0) , std::min( thomas_tile_width , nx-i ) , M.thomas_k_jump , 0 , nz , nz , 
+				M.thomas_constant1_tile , M.thomas_denomz_tile , M.thomas_cz_tile , 
+				M.thomas_denom_interior_tile , M.thomas_c_interior_tile , active ); 
+		}
+		return; 
+	}
+
+	#pragma omp parallel for 
+	for( unsigned int j=0; j < ny ; j++ )
+	{
+		for( unsigned int i=0; i < nx ; i++ )
+		{
+			// Thomas solver, z-direction
+			int n = M.voxel_index(i,j,0);
+			if( D.layout() == density_layout_substrate_major )
+			{
+				thomas_solve_line_substrates( D , n , nz , M.thomas_k_jump , 
+					M.thomas_constant1 , M.thomas_denomz , M.thomas_cz , active ); 
+				continue; 
+			}
+			thomas_solve_line( D.data() + n*vs , nz , M.thomas_k_jump*vs , nd , ss , 
+				M.thomas_constant1.data() , M.thomas_denomz.data() , M.thomas_cz.data() ); 
+		}
+	}
+	return; 
+}
+
+void diffusion_decay_solver__constant_coefficients_LOD_3D( Microenvironment& M, double dt )
+{
+	if( M.mesh.regular_mesh == false || M.mesh.Cartesian_mesh == false )
+	{
+		std::cout << "Error: This algorithm is written for regular Cartesian meshes. Try: other solvers!" << std::endl << std::endl; 
+	return; 
+	}
+
+	M.begin_active_region_step(); 
+	diffusion_decay_solver__constant_coefficients_LOD_3D_sweep( M , dt , 0 ); 
+	diffusion_decay_solver__constant_coefficients_LOD_3D_sweep( M , dt , 1 ); 
+	diffusion_decay_solver__constant_coefficients_LOD_3D_sweep( M , dt , 2 ); 
+ 
+	M.apply_dirichlet_conditions();
+	M.end_active_region_step(); 
+	
+	// reset gradient vectors 
+//	M.reset_all_gradient_vectors(); 
+
+	return; 
+}
+
+void diffusion_decay_solver__constant_coefficients_LOD_2D( Microenvironment& M, double dt )
+{
+	if( M.mesh.regular_mesh == false )
 	{
 		std::cout << "Error: This algorithm is written for regular Cartesian meshes. Try: something else." << std::endl << std::endl; 
 		return; 
@@ -535,89 +976,155 @@ void diffusion_decay_solver__constant_coefficients_LOD_1D( Microenvironment& M,
 	{
 		std::cout << std::endl << "Using method " << __FUNCTION__ << " (2D LOD with Thomas Algorithm) ... " << std::endl << std::endl;  
 		
-		M.thomas_denomx.resize( M.mesh.x_coordinates.size() , M.zero );
-		M.thomas_cx.resize( M.mesh.x_coordinates.size() , M.zero );
-
 		// define constants and pre-computed quantities 
 
 		M.thomas_i_jump = 1; 
 		M.thomas_j_jump = M.mesh.x_coordinates.size(); 
 
 		M.thomas_constant1 =  M.diffusion_coefficients; //   dt*D/dx^2 
-		M.thomas_constant1a = M.zero; // -dt*D/dx^2; 
 		M.thomas_constant2 =  M.decay_rates; // (1/2)*dt*lambda 
-		M.thomas_constant3 = M.one; // 1 + 2*constant1 + constant2; 
-		M.thomas_constant3a = M.one; // 1 + constant1 + constant2; 
+		std::vector<double> substrate_dt = substrate_time_steps( M , dt ); 
 		
-		M.thomas_constant1 *= dt; 
+		M.thomas_constant1 *= substrate_dt; 
 		M.thomas_constant1 /= M.mesh.dx; 
 		M.thomas_constant1 /= M.mesh.dx; 
 
-		M.thomas_constant1a = M.thomas_constant1; 
-		M.thomas_constant1a *= -1.0; 
-
-		M.thomas_constant2 *= dt; 
-		M.thomas_constant2 *= 1; // no splitting via LOD
-
-		M.thomas_constant3 += M.thomas_constant1; 
-		M.thomas_constant3 += M.thomas_constant1; 
-		M.thomas_constant3 += M.thomas_constant2; 
+		M.thomas_constant2 *= substrate_dt; 
+		M.thomas_constant2 *= 0.5; // for splitting via LOD
 
-		M.thomas_constant3a += M.thomas_constant1; 
-		M.thomas_constant3a += M.thomas_constant2; 
-		
 		// Thomas solver coefficients 
 
-		M.thomas_cx.assign( M.mesh.x_coordinates.size() , M.thomas_constant1a ); 
-		M.thomas_denomx.assign( M.mesh.x_coordinates.size()  , M.thomas_constant3 ); 
-		M.thomas_denomx[0] = M.thomas_constant3a; 
-		M.thomas_denomx[ M.mesh.x_coordinates.size()-1 ] = M.thomas_constant3a; 
-		if( M.mesh.x_coordinates.size() == 1 )
-		{ M.thomas_denomx[0] = M.one; M.thomas_denomx[0] += M.thomas_constant2; } 
+		setup_thomas_coefficients( M.mesh.x_coordinates.size() , M.thomas_constant1 , M.thomas_constant2 , M.thomas_denomx , M.thomas_cx ); 
+		setup_thomas_coefficients( M.mesh.y_coordinates.size() , M.thomas_constant1 , M.thomas_constant2 , M.thomas_denomy , M.thomas_cy ); 
 
-		M.thomas_cx[0] /= M.thomas_denomx[0]; 
-		for( unsigned int i=1 ; i <= M.mesh.x_coordinates.size()-1 ; i++ )
-		{ 
-			axpy( &M.thomas_denomx[i] , M.thomas_constant1 , M.thomas_cx[i-1] ); 
-			M.thomas_cx[i] /= M.thomas_denomx[i]; // the value at  size-1 is not actually used  
-		}
+		// coefficients for the batched x-sweeps 
+		unsigned int nd = M.number_of_densities(); 
+		int layout = M.get_density_layout(); 
+		replicate_thomas_coefficients( 1 , nd , thomas_batch_width , M.thomas_constant1 , M.thomas_constant1_batch , layout ); 
+		replicate_thomas_coefficients( M.mesh.x_coordinates.size() , nd , thomas_batch_width , M.thomas_denomx , M.thomas_denomx_batch , layout ); 
+		replicate_thomas_coefficients( M.mesh.x_coordinates.size() , nd , thomas_batch_width , M.thomas_cx , M.thomas_cx_batch , layout ); 
+
+		// coefficients for the blocked y-sweeps 
+		replicate_thomas_coefficients( 1 , nd , thomas_tile_width , M.thomas_constant1 , M.thomas_constant1_tile , layout ); 
+		replicate_thomas_coefficients( M.mesh.y_coordinates.size() , nd , thomas_tile_width , M.thomas_denomy , M.thomas_denomy_tile , layout ); 
+		replicate_thomas_coefficients( M.mesh.y_coordinates.size() , nd , thomas_tile_width , M.thomas_cy , M.thomas_cy_tile , layout ); 
+		
+		// coefficients for line segments that start inside the domain (active-region diffusion) 
+		unsigned int longest = std::max( M.mesh.x_coordinates.size() , M.mesh.y_coordinates.size() ); 
+		setup_thomas_coefficients( longest , M.thomas_constant1 , M.thomas_constant2 , M.thomas_denom_interior , M.thomas_c_interior , true ); 
+		replicate_thomas_coefficients( longest , nd , thomas_batch_width , M.thomas_denom_interior , M.thomas_denom_interior_batch , layout ); 
+		replicate_thomas_coefficients( longest , nd , thomas_batch_width , M.thomas_c_interior , M.thomas_c_interior_batch , layout ); 
+		replicate_thomas_coefficients( longest , nd , thomas_tile_width , M.thomas_denom_interior , M.thomas_denom_interior_tile , layout ); 
+		replicate_thomas_coefficients( longest , nd , thomas_tile_width , M.thomas_c_interior , M.thomas_c_interior_tile , layout ); 
 
 		M.diffusion_solver_setup_done = true; 
 	}
 
-	// set the pointer
+	Density_Store& D = *M.p_density_vectors; 
+	unsigned int nd = D.number_of_densities(); 
+	unsigned int vs = D.voxel_stride(); 
+	unsigned int ss = D.substrate_stride(); 
+	const std::vector<unsigned int>& active = diffusion_substrates( M ); 
+	
+	unsigned int nx = M.mesh.x_coordinates.size(); 
+	unsigned int ny = M.mesh.y_coordinates.size(); 
 	
+	// active-region diffusion: solve only the runs of active tiles along each line 
+	M.begin_active_region_step(); 
+	bool active_region = ( M.blocked_diffusion_sweeps && M.active_tiles.size() > 0 ); 
+	unsigned int tiles_x = active_tile_count( nx ); 
+	unsigned int tiles_y = active_tile_count( ny ); 
+
 	M.apply_dirichlet_conditions();
 
-	// x-diffusion 
-	#pragma omp parallel for 
-	for( unsigned int j=0; j < M.mesh.y_coordinates.size() ; j++ )
+	// x-diffusion (batches of x-lines along j)
+	
+	unsigned int number_of_batches = (ny + thomas_batch_width - 1) / thomas_batch_width; 
+	
+	#pragma omp parallel 
 	{
-		// Thomas solver, x-direction
-
-		// remaining part of forward elimination, using pre-computed quantities 
-		unsigned int n = M.voxel_index(0,j,0);
-		(*M.p_density_vectors)[n] /= M.thomas_denomx[0]; 
-
-		n += M.thomas_i_jump; 
-		for( unsigned int i=1; i < M.mesh.x_coordinates.size() ; i++ )
+		aligned_vector scratch( nx*thomas_batch_width*nd ); 
+		
+		#pragma omp for schedule(dynamic) 
+		for( unsigned int b=0; b < number_of_batches ; b++ )
 		{
-			axpy( &(*M.p_density_vectors)[n] , M.thomas_constant1 , (*M.p_density_vectors)[n-M.thomas_i_jump] ); 
-			(*M.p_density_vectors)[n] /= M.thomas_denomx[i]; 
-			n += M.thomas_i_jump; 
+			unsigned int j = b*thomas_batch_width; 
+			unsigned int lines = std::min( thomas_batch_width , ny-j ); 
+			
+			// Thomas solver, x-direction
+			if( active_region == false )
+			{
+				thomas_solve_x_lines( D , M.voxel_index(0,j,0) , lines , M.thomas_j_jump , 0 , nx , nx , 
+					M.thomas_constant1_batch , M.thomas_denomx_batch , M.thomas_cx_batch , 
+					M.thomas_denom_interior_batch , M.thomas_c_interior_batch , scratch.data() , active ); 
+				continue; 
+			}
+			
+			unsigned int t = 0, run_start, run_end; 
+			while( next_active_run( M.active_tiles , (j/active_tile_width)*tiles_x , 1 , tiles_x , t , run_start , run_end ) )
+			{
+				thomas_solve_x_lines( D , M.voxel_index(0,j,0) , lines , M.thomas_j_jump , 
+					run_start*active_tile_width , std::min( run_end*active_tile_width , nx ) , nx , 
+					M.thomas_constant1_batch , M.thomas_denomx_batch , M.thomas_cx_batch , 
+					M.thomas_denom_interior_batch , M.thomas_c_interior_batch , scratch.data() , active ); 
+			}
 		}
+	}
 
-		// back substitution 
-		n = M.voxel_index( M.mesh.x_coordinates.size()-2 ,j,0); 
+	// y-diffusion 
 
-		for( int i = M.mesh.x_coordinates.size()-2 ; i >= 0 ; i-- )
+	M.apply_dirichlet_conditions();
+	if( active_region )
+	{
+		#pragma omp parallel for schedule(dynamic) 
+		for( unsigned int b=0; b < tiles_x ; b++ )
+		{
+			unsigned int i = b*active_tile_width; 
+			unsigned int t = 0, run_start, run_end; 
+			while( next_active_run( M.active_tiles , b , tiles_x , tiles_y , t , run_start , run_end ) )
+			{
+				thomas_solve_tile( D , M.voxel_index(i,0,0) , std::min( active_tile_width , nx-i ) , M.thomas_j_jump , 
+					run_start*active_tile_width , std::min( run_end*active_tile_width , ny ) , ny , 
+					M.thomas_constant1_tile , M.thomas_denomy_tile , M.thomas_cy_tile , 
+					M.thomas_denom_interior_tile , M.thomas_c_interior_tile , active ); 
+			}
+		}
+	}
+	else if( M.blocked_diffusion_sweeps )
+	{
+		unsigned int number_of_tiles = (nx + thomas_tile_width - 1) / thomas_tile_width; 
+		
+		#pragma omp parallel for 
+		for( unsigned int b=0; b < number_of_tiles ; b++ )
+		{
+			unsigned int i = b*thomas_tile_width; 
+			
+			// Thomas solver, y-direction, for a tile of i-columns 
+			thomas_solve_tile( D , M.voxel_index(i,0,0) , std::min( thomas_tile_width , nx-i ) , M.thomas_j_jump , 0 , ny , ny , 
+				M.thomas_constant1_tile , M.thomas_denomy_tile , M.thomas_cy_tile , 
+				M.thomas_denom_interior_tile , M.thomas_c_interior_tile , active ); 
+		}
+	}
+	else
+	{
+		#pragma omp parallel for 
+		for( unsigned int i=0; i < nx ; i++ )
 		{
-			naxpy( &(*M.p_density_vectors)[n] , M.thomas_cx[i] , (*M.p_density_vectors)[n+M.thomas_i_jump] ); 
-			n -= M.thomas_i_jump; 
+			// Thomas solver, y-direction
+			int n = M.voxel_index(i,0,0);
+			if( D.layout() == density_layout_substrate_major )
+			{
+				thomas_solve_line_substrates( D , n , ny , M.thomas_j_jump , 
+					M.thomas_constant1 , M.thomas_denomy , M.thomas_cy , active ); 
+				continue; 
+			}
+			thomas_solve_line( D.data() + n*vs , ny , M.thomas_j_jump*vs , nd , ss , 
+				M.thomas_constant1.data() , M.thomas_denomy.data() , M.thomas_cy.data() ); 
 		}
 	}
 
 	M.apply_dirichlet_conditions();
+	M.end_active_region_step(); 
 	
 	// reset gradient vectors 
 //	M.reset_all_gradient_vectors(); 
@@ -625,5 +1132,1601 @@ void diffusion_decay_solver__constant_coefficients_LOD_1D( Microenvironment& M,
 	return; 
 }
 
+void diffusion_decay_explicit_uniform_rates( Microenvironment& M, double dt )
+{
+	using std::vector; 
+	using std::cout; 
+	using std::endl; 
+
+	// static int n_jump_i = 1; 
+	// static int n_jump_j = M.mesh.x_coordinates.size(); 
+	// static int n_jump_k = M.mesh.x_coordinates.size() * M.mesh.y_coordinates.size(); 
+
+	if( !M.diffusion_solver_setup_done )
+	{	
+		M.thomas_i_jump = 1; 
+		M.thomas_j_jump = M.mesh.x_coordinates.size(); 
+		M.thomas_k_jump = M.thomas_j_jump * M.mesh.y_coordinates.size(); 
+	
+		M.diffusion_solver_setup_done = true; 
+	}
+	
+	if( M.mesh.uniform_mesh == false )
+	{
+		cout << "Error: This algorithm is written for uniform Cartesian meshes. Try: something else" << endl << endl; 
+		return; 
+	}
+
+	// double buffering to reduce memory copy / allocation overhead 
+
+	static Density_Store* pNew = &(M.temporary_density_vectors1);
+	static Density_Store* pOld = &(M.temporary_density_vectors2);
+
+	// swap the buffers 
+
+	Density_Store* pTemp = pNew; 
+	pNew = pOld; 
+	pOld = pTemp; 
+	M.p_density_vectors = pNew; 
+
+	// static bool reaction_diffusion_shortcuts_are_set = false; 
+
+	static vector<double> constant1 = (1.0 / ( M.mesh.dx * M.mesh.dx )) * M.diffusion_coefficients; 
+	static vector<double> constant2 = dt * constant1; 
+	static vector<double> constant3 = M.one + dt * M.decay_rates;
+
+	static vector<double> constant4 = M.one - dt * M.decay_rates;
+
+	#pragma omp parallel for
+	for( unsigned int i=0; i < M.number_of_voxels() ; i++ )
+	{
+		unsigned int number_of_neighbors = M.mesh.connected_voxel_indices[i].size(); 
+
+		double d1 = -1.0 * number_of_neighbors; 
+
+		Density_Vector_View new_density = (*pNew)[i]; 
+		Density_Vector_View old_density = (*pOld)[i]; 
+
+		for( unsigned int q=0; q < new_density.size() ; q++ )
+		{ new_density[q] = old_density[q] * constant4[q]; }
+
+		for( unsigned int j=0; j < number_of_neighbors ; j++ )
+		{
+			Density_Vector_View neighbor_density = (*pOld)[ M.mesh.connected_voxel_indices[i][j] ]; 
+			for( unsigned int q=0; q < new_density.size() ; q++ )
+			{ new_density[q] += constant2[q] * neighbor_density[q]; }
+		}
+		for( unsigned int q=0; q < new_density.size() ; q++ )
+		{ new_density[q] += ( constant2[q] * d1 ) * old_density[q]; }
+	}
+	
+	// reset gradient vectors 
+//	M.reset_all_gradient_vectors(); 
+
+	return; 
+}
+
+void diffusion_decay_solver__constant_coefficients_LOD_1D( Microenvironment& M, double dt )
+{
+	if( M.mesh.regular_mesh == false )
+	{
+		std::cout << "Error: This algorithm is written for regular Cartesian meshes. Try: something else." << std::endl << std::endl; 
+		return; 
+	}
+	
+	// constants for the linear solver (Thomas algorithm) 
+	
+	if( !M.diffusion_solver_setup_done )
+	{
+		std::cout << std::endl << "Using method " << __FUNCTION__ << " (2D LOD with Thomas Algorithm) ... " << std::endl << std::endl;  
+		
+		// define constants and pre-computed quantities 
+
+		M.thomas_i_jump = 1; 
+		M.thomas_j_jump = M.mesh.x_coordinates.size(); 
+
+		M.thomas_constant1 =  M.diffusion_coefficients; //   dt*D/dx^2 
+		M.thomas_constant2 =  M.decay_rates; // (1/2)*dt*lambda 
+		
+		M.thomas_constant1 *= dt; 
+		M.thomas_constant1 /= M.mesh.dx; 
+		M.thomas_constant1 /= M.mesh.dx; 
+
+		M.thomas_constant2 *= dt; 
+		M.thomas_constant2 *= 1; // no splitting via LOD
+
+		// Thomas solver coefficients 
+
+		setup_thomas_coefficients( M.mesh.x_coordinates.size() , M.thomas_constant1 , M.thomas_constant2 , M.thomas_denomx , M.thomas_cx ); 
+
+		M.diffusion_solver_setup_done = true; 
+	}
+
+	Density_Store& D = *M.p_density_vectors; 
+	unsigned int nd = D.number_of_densities(); 
+	unsigned int vs = D.voxel_stride(); 
+	unsigned int ss = D.substrate_stride(); 
+	
+	M.apply_dirichlet_conditions();
+
+	// x-diffusion 
+	#pragma omp parallel for 
+	for( unsigned int j=0; j < M.mesh.y_coordinates.size() ; j++ )
+	{
+		// Thomas solver, x-direction
+		unsigned int n = M.voxel_index(0,j,0);
+		thomas_solve_line( D.data() + n*vs , M.mesh.x_coordinates.size() , M.thomas_i_jump*vs , nd , ss , 
+			M.thomas_constant1.data() , M.thomas_denomx.data() , M.thomas_cx.data() ); 
+	}
+
+	M.apply_dirichlet_conditions();
+	
+	// reset gradient vectors 
+//	M.reset_all_gradient_vectors(); 
+	
+	return; 
+}
+
+
+/* variable-coefficient LOD solvers (new in 1.7.2). Each voxel has its own 
+   diffusion coefficient and decay rate. The diffusion coefficient on the 
+   face between two voxels is the harmonic mean of the two, and the outer 
+   faces are no-flux, as in the constant-coefficient solvers. */ 
+
+static double face_diffusion_coefficient( double D1 , double D2 )
+{
+	if( D1 == D2 )
+	{ return D1; }
+	if( D1 + D2 <= 0.0 )
+	{ return 0.0; }
+	return 2.0*D1*D2 / ( D1 + D2 ); 
+}
+
+// first voxel, voxel jump, and length of LOD line number "line" in the given direction 
+static void LOD_line( Microenvironment& M , int direction , unsigned int line , 
+	unsigned int& first_voxel , unsigned int& voxel_jump , unsigned int& count )
+{
+	unsigned int nx = M.mesh.x_coordinates.size(); 
+	unsigned int ny = M.mesh.y_coordinates.size(); 
+	
+	if( direction == 0 )
+	{
+		first_voxel = M.voxel_index( 0 , line % ny , line / ny ); 
+		voxel_jump = 1; 
+		count = nx; 
+		return; 
+	}
+	if( direction == 1 )
+	{
+		first_voxel = M.voxel_index( line % nx , 0 , line / nx ); 
+		voxel_jump = nx; 
+		count = ny; 
+		return; 
+	}
+	first_voxel = M.voxel_index( line % nx , line / nx , 0 ); 
+	voxel_jump = nx*ny; 
+	count = M.mesh.z_coordinates.size(); 
+	return; 
+}
+
+// factors every line of one direction. decay_split is the number of LOD sweeps 
+// that share the decay term. 
+static void variable_coefficient_factor( Microenvironment& M , int direction , double dt , double decay_split , 
+	Density_Store& diffusion , Density_Store& decay , 
+	Density_Store& face , Density_Store& denom , Density_Store& c )
+{
+	unsigned int nd = diffusion.number_of_densities(); 
+	unsigned int vs = diffusion.voxel_stride(); 
+	unsigned int ss = diffusion.substrate_stride(); 
+	
+	face.set_layout( diffusion.layout() ); 
+	denom.set_layout( diffusion.layout() ); 
+	c.set_layout( diffusion.layout() ); 
+	face.resize( diffusion.number_of_voxels() , nd ); 
+	denom.resize( diffusion.number_of_voxels() , nd ); 
+	c.resize( diffusion.number_of_voxels() , nd ); 
+	
+	unsigned int first_voxel, voxel_jump, count; 
+	LOD_line( M , direction , 0 , first_voxel , voxel_jump , count ); 
+	unsigned int number_of_lines = M.number_of_voxels() / count; 
+	
+	#pragma omp parallel for 
+	for( unsigned int line=0; line < number_of_lines ; line++ )
+	{
+		unsigned int n0, jump, size; 
+		LOD_line( M , direction , line , n0 , jump , size ); 
+		
+		for( unsigned int q=0; q < nd ; q++ )
+		{
+			double previous_c = 0.0; 
+			for( unsigned int i=0; i < size ; i++ )
+			{
+				unsigned int m = (n0 + i*jump)*vs + q*ss; 
+				
+				double below = 0.0; 
+				if( i > 0 )
+				{
+					below = face_diffusion_coefficient( diffusion.data()[m - jump*vs] , diffusion.data()[m] ); 
+					below *= dt; 
+					below /= M.mesh.dx; 
+					below /= M.mesh.dx; 
+				}
+				double above = 0.0; 
+				if( i+1 < size )
+				{
+					above = face_diffusion_coefficient( diffusion.data()[m] , diffusion.data()[m + jump*vs] ); 
+					above *= dt; 
+					above /= M.mesh.dx; 
+					above /= M.mesh.dx; 
+				}
+				
+				face.data()[m] = below; 
+				denom.data()[m] = 1.0 + below + above + dt*decay.data()[m]/decay_split; 
+				denom.data()[m] += below * previous_c; 
+				c.data()[m] = -above / denom.data()[m]; 
+				previous_c = c.data()[m]; 
+			}
+		}
+	}
+	return; 
+}
+
+// Thomas solve on runs of "length" contiguous unknowns, where face, denom, and c 
+// share the layout (and offsets) of the data 
+static void variable_thomas_solve_packed( double* p , const double* face , const double* denom , const double* c , 
+	unsigned int count , unsigned int length , unsigned int data_jump )
+{
+	#pragma omp simd
+	for( unsigned int m=0; m < length ; m++ )
+	{ p[m] /= denom[m]; }
+	
+	for( unsigned int i=1; i < count ; i++ )
+	{
+		unsigned int offset = i*data_jump; 
+		#pragma omp simd
+		for( unsigned int m=offset; m < offset+length ; m++ )
+		{
+			p[m] += face[m] * p[m-data_jump]; 
+			p[m] /= denom[m]; 
+		}
+	}
+	
+	for( int i = count-2 ; i >= 0 ; i-- )
+	{
+		unsigned int offset = i*data_jump; 
+		#pragma omp simd
+		for( unsigned int m=offset; m < offset+length ; m++ )
+		{ p[m] -= c[m] * p[m+data_jump]; }
+	}
+	return; 
+}
+
+static void variable_coefficient_sweep( Microenvironment& M , int direction , Density_Store& D , 
+	Density_Store& face , Density_Store& denom , Density_Store& c )
+{
+	unsigned int nd = D.number_of_densities(); 
+	unsigned int vs = D.voxel_stride(); 
+	unsigned int ss = D.substrate_stride(); 
+	unsigned int nx = M.mesh.x_coordinates.size(); 
+
+	unsigned int first_voxel, voxel_jump, count; 
+	LOD_line( M , direction , 0 , first_voxel , voxel_jump , count ); 
+	
+	if( direction == 0 || M.blocked_diffusion_sweeps == false )
+	{
+		// one line at a time 
+		unsigned int number_of_lines = M.number_of_voxels() / count; 
+		#pragma omp parallel for 
+		for( unsigned int line=0; line < number_of_lines ; line++ )
+		{
+			unsigned int n0, jump, size; 
+			LOD_line( M , direction , line , n0 , jump , size ); 
+			if( D.layout() == density_layout_substrate_major )
+			{
+				for( unsigned int q=0; q < nd ; q++ )
+				{
+					unsigned int m = n0*vs + q*ss; 
+					variable_thomas_solve_packed( D.data() + m , face.data() + m , denom.data() + m , c.data() + m , 
+						size , 1 , jump*vs ); 
+				}
+			}
+			else
+			{
+				// all substrates of a voxel are adjacent 
+				unsigned int m = n0*vs; 
+				variable_thomas_solve_packed( D.data() + m , face.data() + m , denom.data() + m , c.data() + m , 
+					size , nd , jump*vs ); 
+			}
+		}
+		return; 
+	}
+	
+	// tiles of adjacent i-columns, as in the constant-coefficient solvers 
+	unsigned int tiles_per_row = (nx + thomas_tile_width - 1) / thomas_tile_width; 
+	unsigned int number_of_rows = M.number_of_voxels() / ( nx*count ); 
+	
+	#pragma omp parallel for 
+	for( unsigned int b=0; b < number_of_rows*tiles_per_row ; b++ )
+	{
+		unsigned int i = (b % tiles_per_row)*thomas_tile_width; 
+		unsigned int columns = std::min( thomas_tile_width , nx-i ); 
+		unsigned int n0, jump, size; 
+		LOD_line( M , direction , (b / tiles_per_row)*nx + i , n0 , jump , size ); 
+		
+		if( D.layout() == density_layout_substrate_major )
+		{
+			for( unsigned int q=0; q < nd ; q++ )
+			{
+				unsigned int m = n0*vs + q*ss; 
+				variable_thomas_solve_packed( D.data() + m , face.data() + m , denom.data() + m , c.data() + m , 
+					size , columns , jump*vs ); 
+			}
+		}
+		else
+		{
+			unsigned int m = n0*vs; 
+			variable_thomas_solve_packed( D.data() + m , face.data() + m , denom.data() + m , c.data() + m , 
+				size , columns*nd , jump*vs ); 
+		}
+	}
+	return; 
+}
+
+static void variable_coefficients_LOD( Microenvironment& M , double dt , int dimensions , Density_Store& D , 
+	Density_Store& diffusion , Density_Store& decay , bool refactor , 
+	std::vector<Density_Store>& face , std::vector<Density_Store>& denom , std::vector<Density_Store>& c ) 
+{
+	face.resize( 3 ); 
+	denom.resize( 3 ); 
+	c.resize( 3 ); 
+	
+	if( refactor )
+	{
+		for( int d=0; d < dimensions ; d++ )
+		{ variable_coefficient_factor( M , d , dt , dimensions , diffusion , decay , face[d] , denom[d] , c[d] ); }
+	}
+
+	for( int d=0; d < dimensions ; d++ )
+	{
+		M.apply_dirichlet_conditions(); 
+		variable_coefficient_sweep( M , d , D , face[d] , denom[d] , c[d] ); 
+	}
+	M.apply_dirichlet_conditions();
+	return; 
+}
+
+void diffusion_decay_solver__variable_coefficients_LOD_3D( Microenvironment& M, double dt )
+{
+	if( M.mesh.regular_mesh == false || M.mesh.Cartesian_mesh == false )
+	{
+		std::cout << "Error: This algorithm is written for regular Cartesian meshes. Try: other solvers!" << std::endl << std::endl; 
+		return; 
+	}
+	
+	if( !M.diffusion_solver_setup_done )
+	{
+		std::cout << std::endl << "Using method " << __FUNCTION__ << " (implicit 3-D LOD with Thomas Algorithm, variable coefficients) ... " 
+		<< std::endl << std::endl;  
+		M.variable_coefficients_changed = true; 
+		M.diffusion_solver_setup_done = true; 
+	}
+	
+	if( M.variable_diffusion_coefficients.number_of_voxels() != M.number_of_voxels() || 
+		M.variable_diffusion_coefficients.number_of_densities() != M.number_of_densities() )
+	{ M.initialize_variable_coefficients(); }
+	
+	// refactor only if the coefficients or the time step changed 
+	bool refactor = M.variable_coefficients_changed || dt != M.variable_thomas_dt || 
+		M.variable_diffusion_coefficients.layout() != M.get_density_layout(); 
+	if( refactor )
+	{
+		M.variable_diffusion_coefficients.set_layout( M.get_density_layout() ); 
+		M.variable_decay_rates.set_layout( M.get_density_layout() ); 
+	}
+	
+	variable_coefficients_LOD( M , dt , 3 , *M.p_density_vectors , M.variable_diffusion_coefficients , M.variable_decay_rates , refactor , 
+		M.variable_thomas_face , M.variable_thomas_denom , M.variable_thomas_c ); 
+	
+	M.variable_coefficients_changed = false; 
+	M.variable_thomas_dt = dt; 
+	return; 
+}
+
+void diffusion_decay_solver__variable_coefficients_LOD_2D( Microenvironment& M, double dt )
+{
+	if( M.mesh.regular_mesh == false )
+	{
+		std::cout << "Error: This algorithm is written for regular Cartesian meshes. Try: something else." << std::endl << std::endl; 
+		return; 
+	}
+	
+	if( !M.diffusion_solver_setup_done )
+	{
+		std::cout << std::endl << "Using method " << __FUNCTION__ << " (2D LOD with Thomas Algorithm, variable coefficients) ... " 
+		<< std::endl << std::endl;  
+		M.variable_coefficients_changed = true; 
+		M.diffusion_solver_setup_done = true; 
+	}
+	
+	if( M.variable_diffusion_coefficients.number_of_voxels() != M.number_of_voxels() || 
+		M.variable_diffusion_coefficients.number_of_densities() != M.number_of_densities() )
+	{ M.initialize_variable_coefficients(); }
+	
+	bool refactor = M.variable_coefficients_changed || dt != M.variable_thomas_dt || 
+		M.variable_diffusion_coefficients.layout() != M.get_density_layout(); 
+	if( refactor )
+	{
+		M.variable_diffusion_coefficients.set_layout( M.get_density_layout() ); 
+		M.variable_decay_rates.set_layout( M.get_density_layout() ); 
+	}
+	
+	variable_coefficients_LOD( M , dt , 2 , *M.p_density_vectors , M.variable_diffusion_coefficients , M.variable_decay_rates , refactor , 
+		M.variable_thomas_face , M.variable_thomas_denom , M.variable_thomas_c ); 
+	
+	M.variable_coefficients_changed = false; 
+	M.variable_thomas_dt = dt; 
+	return; 
+}
+
+/* steady-state multigrid solver (new in 1.7.2). For each substrate, solves 
+      -D*Laplacian(u) + ( lambda + sigma_cells )*u = f_cells 
+   with no-flux outer boundaries (as in the LOD solvers) and the Dirichlet 
+   nodes held fixed. sigma_cells and f_cells gather the agents' uptake, 
+   secretion, and net export in each voxel. We use V-cycles of red-black 
+   Gauss-Seidel on a hierarchy of cell-centered grids, starting from the 
+   current densities: when the cells change slowly between calls, few (or 
+   no) cycles are needed. */ 
+
+static const unsigned int multigrid_smoothing_sweeps = 2; 
+static const unsigned int multigrid_coarsest_sweeps = 50; 
+
+static void build_multigrid_levels( Microenvironment& M , std::vector<Multigrid_Level>& levels )
+{
+	levels.resize( 1 ); 
+	levels[0].nx = M.mesh.x_coordinates.size(); 
+	levels[0].ny = M.mesh.y_coordinates.size(); 
+	levels[0].nz = M.mesh.z_coordinates.size(); 
+	levels[0].hx = M.mesh.dx; 
+	levels[0].hy = M.mesh.dy; 
+	levels[0].hz = M.mesh.dz; 
+	
+	while( true )
+	{
+		Multigrid_Level coarse = levels.back(); 
+		bool coarsened = false; 
+		if( coarse.nx >= 4 )
+		{ coarse.nx = (coarse.nx+1)/2; coarse.hx *= 2.0; coarsened = true; }
+		if( coarse.ny >= 4 )
+		{ coarse.ny = (coarse.ny+1)/2; coarse.hy *= 2.0; coarsened = true; }
+		if( coarse.nz >= 4 )
+		{ coarse.nz = (coarse.nz+1)/2; coarse.hz *= 2.0; coarsened = true; }
+		if( coarsened == false )
+		{ break; }
+		levels.push_back( coarse ); 
+	}
+
+	for( unsigned int L=0; L < levels.size() ; L++ )
+	{
+		unsigned int size = levels[L].nx * levels[L].ny * levels[L].nz; 
+		levels[L].u.assign( size , 0.0 ); 
+		levels[L].f.assign( size , 0.0 ); 
+		levels[L].r.assign( size , 0.0 ); 
+		levels[L].sigma.assign( size , 0.0 ); 
+		levels[L].fixed.assign( size , 0 ); 
+	}
+	return; 
+}
+
+// the coarse voxels (and weights) that voxel i of a fine line interpolates from 
+static void multigrid_parents( unsigned int i , unsigned int n_fine , unsigned int n_coarse , 
+	unsigned int& I1 , unsigned int& I2 , double& w1 )
+{
+	if( n_fine == n_coarse )
+	{ I1 = i; I2 = i; w1 = 1.0; return; }
+	
+	I1 = i/2; 
+	I2 = I1; 
+	w1 = 1.0; 
+	if( i % 2 == 1 && I1+1 < n_coarse )
+	{ I2 = I1+1; w1 = 0.75; }
+	if( i % 2 == 0 && I1 > 0 )
+	{ I2 = I1-1; w1 = 0.75; }
+	return; 
+}
+
+static void multigrid_smooth( Multigrid_Level& G , double D , unsigned int sweeps )
+{
+	double cx = D / ( G.hx*G.hx ); 
+	double cy = D / ( G.hy*G.hy ); 
+	double cz = D / ( G.hz*G.hz ); 
+	unsigned int nx = G.nx; 
+	unsigned int ny = G.ny; 
+	unsigned int nz = G.nz; 
+	
+	for( unsigned int s=0; s < 2*sweeps ; s++ )
+	{
+		unsigned int color = s % 2; 
+		
+		#pragma omp parallel for 
+		for( unsigned int row=0; row < ny*nz ; row++ )
+		{
+			unsigned int j = row % ny; 
+			unsigned int k = row / ny; 
+			for( unsigned int i = (j+k+color) % 2 ; i < nx ; i += 2 )
+			{
+				unsigned int n = i + nx*row; 
+				if( G.fixed[n] )
+				{ continue; }
+				
+				double sum = G.f[n]; 
+				double diagonal = G.sigma[n]; 
+				if( i > 0 )
+				{ sum += cx*G.u[n-1]; diagonal += cx; }
+				if( i+1 < nx )
+				{ sum += cx*G.u[n+1]; diagonal += cx; }
+				if( j > 0 )
+				{ sum += cy*G.u[n-nx]; diagonal += cy; }
+				if( j+1 < ny )
+				{ sum += cy*G.u[n+nx]; diagonal += cy; }
+				if( k > 0 )
+				{ sum += cz*G.u[n-nx*ny]; diagonal += cz; }
+				if( k+1 < nz )
+				{ sum += cz*G.u[n+nx*ny]; diagonal += cz; }
+				
+				if( diagonal > 0.0 )
+				{ G.u[n] = sum / diagonal; }
+			}
+		}
+	}
+	return; 
+}
+
+// r = f - A*u. Returns the largest |r|, and in scale the largest |f| + diagonal*|u|. 
+static double multigrid_residual( Multigrid_Level& G , double D , double& scale )
+{
+	double cx = D / ( G.hx*G.hx ); 
+	double cy = D / ( G.hy*G.hy ); 
+	double cz = D / ( G.hz*G.hz ); 
+	unsigned int nx = G.nx; 
+	unsigned int ny = G.ny; 
+	unsigned int nz = G.nz; 
+	
+	double max_residual = 0.0; 
+	double max_scale = 0.0; 
+	
+	#pragma omp parallel for reduction(max:max_residual,max_scale)
+	for( unsigned int row=0; row < ny*nz ; row++ )
+	{
+		unsigned int j = row % ny; 
+		unsigned int k = row / ny; 
+		for( unsigned int i=0; i < nx ; i++ )
+		{
+			unsigned int n = i + nx*row; 
+			if( G.fixed[n] )
+			{ G.r[n] = 0.0; continue; }
+			
+			double Au = 0.0; 
+			double diagonal = G.sigma[n]; 
+			if( i > 0 )
+			{ Au -= cx*G.u[n-1]; diagonal += cx; }
+			if( i+1 < nx )
+			{ Au -= cx*G.u[n+1]; diagonal += cx; }
+			if( j > 0 )
+			{ Au -= cy*G.u[n-nx]; diagonal += cy; }
+			if( j+1 < ny )
+			{ Au -= cy*G.u[n+nx]; diagonal += cy; }
+			if( k > 0 )
+			{ Au -= cz*G.u[n-nx*ny]; diagonal += cz; }
+			if( k+1 < nz )
+			{ Au -= cz*G.u[n+nx*ny]; diagonal += cz; }
+			Au += diagonal*G.u[n]; 
+			
+			G.r[n] = G.f[n] - Au; 
+			max_residual = std::max( max_residual , fabs( G.r[n] ) ); 
+			max_scale = std::max( max_scale , fabs( G.f[n] ) + diagonal*fabs( G.u[n] ) ); 
+		}
+	}
+	scale = max_scale; 
+	return max_residual; 
+}
+
+// averages a fine-level quantity over the children of each coarse voxel 
+static void multigrid_restrict( Multigrid_Level& fine , std::vector<double>& in , Multigrid_Level& coarse , std::vector<double>& out )
+{
+	unsigned int rx = fine.nx == coarse.nx ? 1 : 2; 
+	unsigned int ry = fine.ny == coarse.ny ? 1 : 2; 
+	unsigned int rz = fine.nz == coarse.nz ? 1 : 2; 
+	
+	#pragma omp parallel for 
+	for( unsigned int row=0; row < coarse.ny*coarse.nz ; row++ )
+	{
+		unsigned int J = row % coarse.ny; 
+		unsigned int K = row / coarse.ny; 
+		for( unsigned int I=0; I < coarse.nx ; I++ )
+		{
+			double sum = 0.0; 
+			unsigned int count = 0; 
+			for( unsigned int k=K*rz; k < std::min( (K+1)*rz , fine.nz ) ; k++ )
+			{
+				for( unsigned int j=J*ry; j < std::min( (J+1)*ry , fine.ny ) ; j++ )
+				{
+					for( unsigned int i=I*rx; i < std::min( (I+1)*rx , fine.nx ) ; i++ )
+					{
+						sum += in[ i + fine.nx*( j + fine.ny*k ) ]; 
+						count++; 
+					}
+				}
+			}
+			out[ I + coarse.nx*row ] = sum / count; 
+		}
+	}
+	return; 
+}
+
+// a coarse voxel is fixed (its correction stays zero) if any of its children is 
+static void multigrid_restrict_fixed( Multigrid_Level& fine , Multigrid_Level& coarse )
+{
+	unsigned int rx = fine.nx == coarse.nx ? 1 : 2; 
+	unsigned int ry = fine.ny == coarse.ny ? 1 : 2; 
+	unsigned int rz = fine.nz == coarse.nz ? 1 : 2; 
+	
+	std::fill( coarse.fixed.begin() , coarse.fixed.end() , 0 ); 
+	for( unsigned int k=0; k < fine.nz ; k++ )
+	{
+		for( unsigned int j=0; j < fine.ny ; j++ )
+		{
+			for( unsigned int i=0; i < fine.nx ; i++ )
+			{
+				if( fine.fixed[ i + fine.nx*( j + fine.ny*k ) ] )
+				{ coarse.fixed[ i/rx + coarse.nx*( j/ry + coarse.ny*(k/rz) ) ] = 1; }
+			}
+		}
+	}
+	return; 
+}
+
+// adds the interpolated coarse correction to the fine level (except at fixed nodes) 
+static void multigrid_prolong( Multigrid_Level& coarse , Multigrid_Level& fine )
+{
+	#pragma omp parallel for 
+	for( unsigned int row=0; row < fine.ny*fine.nz ; row++ )
+	{
+		unsigned int j = row % fine.ny; 
+		unsigned int k = row / fine.ny; 
+		unsigned int J[2], K[2]; 
+		double wy, wz; 
+		multigrid_parents( j , fine.ny , coarse.ny , J[0] , J[1] , wy ); 
+		multigrid_parents( k , fine.nz , coarse.nz , K[0] , K[1] , wz ); 
+		double WY[2] = { wy , 1.0-wy }; 
+		double WZ[2] = { wz , 1.0-wz }; 
+		
+		for( unsigned int i=0; i < fine.nx ; i++ )
+		{
+			unsigned int n = i + fine.nx*row; 
+			if( fine.fixed[n] )
+			{ continue; }
+			
+			unsigned int I[2]; 
+			double wx; 
+			multigrid_parents( i , fine.nx , coarse.nx , I[0] , I[1] , wx ); 
+			double WX[2] = { wx , 1.0-wx }; 
+			
+			double correction = 0.0; 
+			for( int c=0; c < 2 ; c++ )
+			{
+				for( int b=0; b < 2 ; b++ )
+				{
+					for( int a=0; a < 2 ; a++ )
+					{ correction += WX[a]*WY[b]*WZ[c] * coarse.u[ I[a] + coarse.nx*( J[b] + coarse.ny*K[c] ) ]; }
+				}
+			}
+			fine.u[n] += correction; 
+		}
+	}
+	return; 
+}
+
+static void multigrid_V_cycle( std::vector<Multigrid_Level>& levels , unsigned int L , double D )
+{
+	if( L+1 == levels.size() )
+	{
+		multigrid_smooth( levels[L] , D , multigrid_coarsest_sweeps ); 
+		return; 
+	}
+	
+	double scale; 
+	multigrid_smooth( levels[L] , D , multigrid_smoothing_sweeps ); 
+	multigrid_residual( levels[L] , D , scale ); 
+	
+	multigrid_restrict( levels[L] , levels[L].r , levels[L+1] , levels[L+1].f ); 
+	std::fill( levels[L+1].u.begin() , levels[L+1].u.end() , 0.0 ); 
+	multigrid_V_cycle( levels , L+1 , D ); 
+	multigrid_prolong( levels[L+1] , levels[L] ); 
+	
+	multigrid_smooth( levels[L] , D , multigrid_smoothing_sweeps ); 
+	return; 
+}
+
+void diffusion_decay_solver__steady_state_multigrid( Microenvironment& M, double dt )
+{
+	if( M.mesh.regular_mesh == false || M.mesh.Cartesian_mesh == false )
+	{
+		std::cout << "Error: This algorithm is written for regular Cartesian meshes. Try: other solvers!" << std::endl << std::endl; 
+		return; 
+	}
+
+	if( !M.diffusion_solver_setup_done || M.multigrid_levels.size() == 0 || 
+		M.multigrid_levels[0].u.size() != M.number_of_voxels() )
+	{
+		std::cout << std::endl << "Using method " << __FUNCTION__ << " (steady state, geometric multigrid) ... " << std::endl << std::endl;  
+		build_multigrid_levels( M , M.multigrid_levels ); 
+		M.diffusion_solver_setup_done = true; 
+	}
+	
+	std::vector<Multigrid_Level>& levels = M.multigrid_levels; 
+	Density_Store& D = *M.p_density_vectors; 
+	unsigned int nd = D.number_of_densities(); 
+	unsigned int nv = M.number_of_voxels(); 
+	
+	// gather the cell sources and sinks: dp/dt = (V_cell/V_voxel)*( S*(T-p) - U*p ) + E/V_voxel 
+	M.steady_state_reaction.assign( nv*nd , 0.0 ); 
+	M.steady_state_source.assign( nv*nd , 0.0 ); 
+	for( unsigned int a=0; a < all_basic_agents.size() ; a++ )
+	{
+		Basic_Agent* pAgent = all_basic_agents[a]; 
+		int n = pAgent->get_current_voxel_index(); 
+		if( pAgent->is_active == false || pAgent->get_microenvironment() != &M || n < 0 )
+		{ continue; }
+		
+		double voxel_volume = M.mesh.voxels[n].volume; 
+		double ratio = pAgent->get_total_volume() / voxel_volume; 
+		unsigned int size = std::min( (unsigned int) pAgent->secretion_rates->size() , nd ); 
+		for( unsigned int q=0; q < size ; q++ )
+		{
+			double S = (*pAgent->secretion_rates)[q]; 
+			M.steady_state_reaction[n*nd+q] += ratio * ( S + (*pAgent->uptake_rates)[q] ); 
+			M.steady_state_source[n*nd+q] += ratio * S * (*pAgent->saturation_densities)[q]; 
+			M.steady_state_source[n*nd+q] += (*pAgent->net_export_rates)[q] / voxel_volume; 
+		}
+	}
+	
+	// the Dirichlet values are fixed 
+	M.apply_dirichlet_conditions(); 
+	
+	M.steady_state_cycles = 0; 
+	Multigrid_Level& G = levels[0]; 
+	for( unsigned int q=0; q < nd ; q++ )
+	{
+		double diffusion_coefficient = M.diffusion_coefficients[q]; 
+		
+		#pragma omp parallel for 
+		for( unsigned int n=0; n < nv ; n++ )
+		{
+			G.u[n] = D(n,q); 
+			G.f[n] = M.steady_state_source[n*nd+q]; 
+			G.sigma[n] = M.decay_rates[q] + M.steady_state_reaction[n*nd+q]; 
+			G.fixed[n] = 0; 
+		}
+		for( unsigned int t=0; t < M.dirichlet_indices.size() ; t++ )
+		{ G.fixed[ M.dirichlet_indices[t] ] = M.dirichlet_packed_activation[t*nd+q]; }
+		
+		for( unsigned int L=1; L < levels.size() ; L++ )
+		{
+			multigrid_restrict( levels[L-1] , levels[L-1].sigma , levels[L] , levels[L].sigma ); 
+			multigrid_restrict_fixed( levels[L-1] , levels[L] ); 
+		}
+		
+		int cycles = 0; 
+		double scale; 
+		double residual = multigrid_residual( G , diffusion_coefficient , scale ); 
+		while( residual > M.steady_state_tolerance * scale && cycles < M.steady_state_max_cycles )
+		{
+			multigrid_V_cycle( levels , 0 , diffusion_coefficient ); 
+			residual = multigrid_residual( G , diffusion_coefficient , scale ); 
+			cycles++; 
+		}
+		M.steady_state_cycles = std::max( M.steady_state_cycles , cycles ); 
+		
+		if( residual > M.steady_state_tolerance * scale )
+		{
+			std::cout << "Warning: steady-state solve for " << M.density_names[q] << " did not converge in " 
+				<< cycles << " V-cycles (relative residual " << residual / scale << ")" << std::endl; 
+		}
+		
+		#pragma omp parallel for 
+		for( unsigned int n=0; n < nv ; n++ )
+		{ D(n,q) = G.u[n]; }
+	}
+	
+	return; 
+}
+
+/* DCT solver (new in 1.7.2). With uniform D and lambda and no-flux outer 
+   boundaries, the 7-point Laplacian on a regular Cartesian mesh is 
+   diagonalized by the DCT-II along each axis. So one fully implicit step 
+   ( I + dt*(lambda - D*Laplacian) ) u_new = u_old is: transform, divide each 
+   mode by its eigenvalue, transform back. Unlike the LOD solvers, there is 
+   no splitting error, so much larger steps stay accurate. 
+   
+   The transforms are fast cosine transforms (see Cosine_Transform), with 
+   O(log n) work per voxel per axis, on blocks of lines gathered from the 
+   densities (for y and z, adjacent lines, so that memory is read in 
+   contiguous runs). Each density takes one pass over memory per transform, 
+   except along the last axis, where the lines are transformed, stepped, and 
+   transformed back in one pass. As in the LOD solvers, Dirichlet nodes are 
+   applied before and after the step. 
+   
+   Since each mode decays independently, the same transforms also give the 
+   exact solution of du/dt = D*Laplacian(u) - lambda*u over dt (each mode 
+   times exp(-dt*eigenvalue)): the _exponential variant has no time-stepping 
+   error at all for the diffusion-decay part. Its factor is a product of one 
+   factor per axis, which are only recomputed when dt or the coefficients 
+   change. */ 
+
+Cosine_Transform::Cosine_Transform()
+{
+	n = 0; 
+	fft_size = 0; 
+	return; 
+}
+
+// split n into FFT radices (4, 2, 3, 5); false if it has other prime factors 
+static bool factor_fft_length( unsigned int n , std::vector<unsigned int>& radices )
+{
+	radices.clear(); 
+	unsigned int factors[4] = { 4 , 2 , 3 , 5 }; 
+	for( unsigned int f=0; f < 4 ; f++ )
+	{
+		while( n % factors[f] == 0 )
+		{
+			radices.push_back( factors[f] ); 
+			n /= factors[f]; 
+		}
+	}
+	return ( n == 1 ); 
+}
+
+void Cosine_Transform::setup( unsigned int n_in , double h )
+{
+	n = n_in; 
+	double pi = 3.141592653589793; 
+	
+	eigenvalues.resize( n ); 
+	scale.resize( n ); 
+	shift_re.resize( n ); 
+	shift_im.resize( n ); 
+	even_odd_order.resize( n ); 
+	for( unsigned int k=0; k < n ; k++ )
+	{
+		double s = sin( pi * k / ( 2.0 * n ) ); 
+		eigenvalues[k] = 4.0 * s * s / ( h*h ); 
+		scale[k] = ( k == 0 ) ? sqrt( 1.0 / n ) : sqrt( 2.0 / n ); 
+		shift_re[k] = cos( pi * k / ( 2.0 * n ) ); 
+		shift_im[k] = -sin( pi * k / ( 2.0 * n ) ); 
+		even_odd_order[k] = ( 2*k < n ) ? 2*k : 2*(n-1-k)+1; 
+	}
+	
+	// an FFT of length n if possible, or else of the shortest length 
+	// (with radices 2, 3, and 5) that fits Bluestein's convolution 
+	fft_size = n; 
+	if( factor_fft_length( fft_size , radices ) == false )
+	{
+		fft_size = 2*n-1; 
+		while( factor_fft_length( fft_size , radices ) == false )
+		{ fft_size++; }
+	}
+	
+	twiddles_re.clear(); 
+	twiddles_im.clear(); 
+	unsigned int length = fft_size; 
+	for( unsigned int stage=0; stage < radices.size() ; stage++ )
+	{
+		unsigned int m = length / radices[stage]; 
+		for( unsigned int p=0; p < m ; p++ )
+		{
+			for( unsigned int u=0; u < radices[stage] ; u++ )
+			{
+				double angle = 2.0 * pi * ( ( (unsigned long long) p * u ) % length ) / length; 
+				twiddles_re.push_back( cos( angle ) ); 
+				twiddles_im.push_back( -sin( angle ) ); 
+			}
+		}
+		length = m; 
+	}
+	
+	chirp_re.clear(); 
+	chirp_im.clear(); 
+	kernel_re.clear(); 
+	kernel_im.clear(); 
+	if( fft_size != n )
+	{
+		chirp_re.resize( n ); 
+		chirp_im.resize( n ); 
+		for( unsigned int k=0; k < n ; k++ )
+		{
+			// k^2 mod 2n keeps the angle accurate for long axes 
+			double angle = pi * ( ( (unsigned long long) k * k ) % ( 2ull * n ) ) / n; 
+			chirp_re[k] = cos( angle ); 
+			chirp_im[k] = -sin( angle ); 
+		}
+		
+		// the kernel conj(chirp) at -(n-1) ... n-1 (wrapped around), 
+		// transformed in the first lane 
+		std::vector<double> buffer( 4*fft_size*lanes , 0.0 ); 
+		double* re = buffer.data(); 
+		double* im = re + fft_size*lanes; 
+		for( unsigned int k=0; k < n ; k++ )
+		{
+			re[k*lanes] = chirp_re[k]; 
+			im[k*lanes] = -chirp_im[k]; 
+			if( k > 0 )
+			{
+				re[(fft_size-k)*lanes] = chirp_re[k]; 
+				im[(fft_size-k)*lanes] = -chirp_im[k]; 
+			}
+		}
+		fft( re , im , im + fft_size*lanes , im + 2*fft_size*lanes ); 
+		kernel_re.resize( fft_size ); 
+		kernel_im.resize( fft_size ); 
+		for( unsigned int j=0; j < fft_size ; j++ )
+		{
+			kernel_re[j] = re[j*lanes]; 
+			kernel_im[j] = im[j*lanes]; 
+		}
+	}
+	return; 
+}
+
+unsigned int Cosine_Transform::work_size( void ) const
+{ return 2*lanes*( n + 2*fft_size ); }
+
+/* The butterflies of one FFT stage of radix r, for one twiddle index p: 
+   y_u = w_u * sum_t x_t exp(-2 pi i t u / r), where x_t starts at x + t*in_stride 
+   and y_u at y + u*out_stride, each L consecutive entries long. */ 
+
+static void radix2_butterflies( const double* xr , const double* xi , unsigned int in_stride , 
+	double* yr , double* yi , unsigned int out_stride , unsigned int L , const double* wr , const double* wi )
+{
+	const double* x1r = xr + in_stride; 
+	const double* x1i = xi + in_stride; 
+	double* y1r = yr + out_stride; 
+	double* y1i = yi + out_stride; 
+	const double w1r = wr[1] , w1i = wi[1]; 
+	#pragma omp simd
+	for( unsigned int v=0; v < L ; v++ )
+	{
+		double dr = xr[v] - x1r[v]; 
+		double di = xi[v] - x1i[v]; 
+		yr[v] = xr[v] + x1r[v]; 
+		yi[v] = xi[v] + x1i[v]; 
+		y1r[v] = w1r*dr - w1i*di; 
+		y1i[v] = w1r*di + w1i*dr; 
+	}
+	return; 
+}
+
+static void radix3_butterflies( const double* xr , const double* xi , unsigned int in_stride , 
+	double* yr , double* yi , unsigned int out_stride , unsigned int L , const double* wr , const double* wi )
+{
+	const double s3 = 0.86602540378443865; // sin(2 pi/3) 
+	const double* x1r = xr + in_stride; 
+	const double* x1i = xi + in_stride; 
+	const double* x2r = xr + 2*in_stride; 
+	const double* x2i = xi + 2*in_stride; 
+	double* y1r = yr + out_stride; 
+	double* y1i = yi + out_stride; 
+	double* y2r = yr + 2*out_stride; 
+	double* y2i = yi + 2*out_stride; 
+	const double w1r = wr[1] , w1i = wi[1]; 
+	const double w2r = wr[2] , w2i = wi[2]; 
+	#pragma omp simd
+	for( unsigned int v=0; v < L ; v++ )
+	{
+		double a0r = xr[v] , a0i = xi[v]; 
+		double a1r = x1r[v] , a1i = x1i[v]; 
+		double a2r = x2r[v] , a2i = x2i[v]; 
+		double tr = a1r + a2r , ti = a1i + a2i; 
+		double cr = a0r - 0.5*tr , ci = a0i - 0.5*ti; 
+		// -i sin(2 pi/3) ( a1 - a2 ) 
+		double dr = s3*( a1i - a2i ) , di = -s3*( a1r - a2r ); 
+		yr[v] = a0r + tr; 
+		yi[v] = a0i + ti; 
+		double z1r = cr + dr , z1i = ci + di; 
+		double z2r = cr - dr , z2i = ci - di; 
+		y1r[v] = w1r*z1r - w1i*z1i; 
+		y1i[v] = w1r*z1i + w1i*z1r; 
+		y2r[v] = w2r*z2r - w2i*z2i; 
+		y2i[v] = w2r*z2i + w2i*z2r; 
+	}
+	return; 
+}
+
+static void radix4_butterflies( const double* xr , const double* xi , unsigned int in_stride , 
+	double* yr , double* yi , unsigned int out_stride , unsigned int L , const double* wr , const double* wi )
+{
+	const double* x1r = xr + in_stride; 
+	const double* x1i = xi + in_stride; 
+	const double* x2r = xr + 2*in_stride; 
+	const double* x2i = xi + 2*in_stride; 
+	const double* x3r = xr + 3*in_stride; 
+	const double* x3i = xi + 3*in_stride; 
+	double* y1r = yr + out_stride; 
+	double* y1i = yi + out_stride; 
+	double* y2r = yr + 2*out_stride; 
+	double* y2i = yi + 2*out_stride; 
+	double* y3r = yr + 3*out_stride; 
+	double* y3i = yi + 3*out_stride; 
+	const double w1r = wr[1] , w1i = wi[1]; 
+	const double w2r = wr[2] , w2i = wi[2]; 
+	const double w3r = wr[3] , w3i = wi[3]; 
+	#pragma omp simd
+	for( unsigned int v=0; v < L ; v++ )
+	{
+		double a0r = xr[v] , a0i = xi[v]; 
+		double a1r = x1r[v] , a1i = x1i[v]; 
+		double a2r = x2r[v] , a2i = x2i[v]; 
+		double a3r = x3r[v] , a3i = x3i[v]; 
+		double b0r = a0r + a2r , b0i = a0i + a2i; 
+		double b1r = a0r - a2r , b1i = a0i - a2i; 
+		double b2r = a1r + a3r , b2i = a1i + a3i; 
+		// -i ( a1 - a3 ) 
+		double b3r = a1i - a3i , b3i = -( a1r - a3r ); 
+		yr[v] = b0r + b2r; 
+		yi[v] = b0i + b2i; 
+		double z1r = b1r + b3r , z1i = b1i + b3i; 
+		double z2r = b0r - b2r , z2i = b0i - b2i; 
+		double z3r = b1r - b3r , z3i = b1i - b3i; 
+		y1r[v] = w1r*z1r - w1i*z1i; 
+		y1i[v] = w1r*z1i + w1i*z1r; 
+		y2r[v] = w2r*z2r - w2i*z2i; 
+		y2i[v] = w2r*z2i + w2i*z2r; 
+		y3r[v] = w3r*z3r - w3i*z3i; 
+		y3i[v] = w3r*z3i + w3i*z3r; 
+	}
+	return; 
+}
+
+static void radix5_butterflies( const double* xr , const double* xi , unsigned int in_stride , 
+	double* yr , double* yi , unsigned int out_stride , unsigned int L , const double* wr , const double* wi )
+{
+	const double c1 = 0.30901699437494742; // cos(2 pi/5) 
+	const double c2 = -0.80901699437494742; // cos(4 pi/5) 
+	const double s1 = 0.95105651629515357; // sin(2 pi/5) 
+	const double s2 = 0.58778525229247313; // sin(4 pi/5) 
+	const double* x1r = xr + in_stride; 
+	const double* x1i = xi + in_stride; 
+	const double* x2r = xr + 2*in_stride; 
+	const double* x2i = xi + 2*in_stride; 
+	const double* x3r = xr + 3*in_stride; 
+	const double* x3i = xi + 3*in_stride; 
+	const double* x4r = xr + 4*in_stride; 
+	const double* x4i = xi + 4*in_stride; 
+	double* y1r = yr + out_stride; 
+	double* y1i = yi + out_stride; 
+	double* y2r = yr + 2*out_stride; 
+	double* y2i = yi + 2*out_stride; 
+	double* y3r = yr + 3*out_stride; 
+	double* y3i = yi + 3*out_stride; 
+	double* y4r = yr + 4*out_stride; 
+	double* y4i = yi + 4*out_stride; 
+	const double w1r = wr[1] , w1i = wi[1]; 
+	const double w2r = wr[2] , w2i = wi[2]; 
+	const double w3r = wr[3] , w3i = wi[3]; 
+	const double w4r = wr[4] , w4i = wi[4]; 
+	#pragma omp simd
+	for( unsigned int v=0; v < L ; v++ )
+	{
+		double a0r = xr[v] , a0i = xi[v]; 
+		double a1r = x1r[v] , a1i = x1i[v]; 
+		double a2r = x2r[v] , a2i = x2i[v]; 
+		double a3r = x3r[v] , a3i = x3i[v]; 
+		double a4r = x4r[v] , a4i = x4i[v]; 
+		double b1r = a1r + a4r , b1i = a1i + a4i; 
+		double b2r = a2r + a3r , b2i = a2i + a3i; 
+		double d1r = a1r - a4r , d1i = a1i - a4i; 
+		double d2r = a2r - a3r , d2i = a2i - a3i; 
+		double e1r = a0r + c1*b1r + c2*b2r , e1i = a0i + c1*b1i + c2*b2i; 
+		double e2r = a0r + c2*b1r + c1*b2r , e2i = a0i + c2*b1i + c1*b2i; 
+		double f1r = s1*d1r + s2*d2r , f1i = s1*d1i + s2*d2i; 
+		double f2r = s2*d1r - s1*d2r , f2i = s2*d1i - s1*d2i; 
+		yr[v] = a0r + b1r + b2r; 
+		yi[v] = a0i + b1i + b2i; 
+		// y1 = e1 - i f1, y4 = e1 + i f1, y2 = e2 - i f2, y3 = e2 + i f2 
+		double z1r = e1r + f1i , z1i = e1i - f1r; 
+		double z4r = e1r - f1i , z4i = e1i + f1r; 
+		double z2r = e2r + f2i , z2i = e2i - f2r; 
+		double z3r = e2r - f2i , z3i = e2i + f2r; 
+		y1r[v] = w1r*z1r - w1i*z1i; 
+		y1i[v] = w1r*z1i + w1i*z1r; 
+		y2r[v] = w2r*z2r - w2i*z2i; 
+		y2i[v] = w2r*z2i + w2i*z2r; 
+		y3r[v] = w3r*z3r - w3i*z3i; 
+		y3i[v] = w3r*z3i + w3i*z3r; 
+		y4r[v] = w4r*z4r - w4i*z4i; 
+		y4i[v] = w4r*z4i + w4i*z4r; 
+	}
+	return; 
+}
+
+/* in-place FFT of fft_size rows of lanes (Stockham's self-sorting order, 
+   decimation in frequency): each stage of radix r splits the current 
+   length into r interleaved subsequences, so that the twiddle factor is 
+   the same for s consecutive rows, and the inner loops run over s*lanes 
+   contiguous entries. */ 
+
+void Cosine_Transform::fft( double* re , double* im , double* temp_re , double* temp_im ) const
+{
+	double* x_re = re; 
+	double* x_im = im; 
+	double* y_re = temp_re; 
+	double* y_im = temp_im; 
+	unsigned int length = fft_size; 
+	unsigned int s = 1; 
+	unsigned int offset = 0; 
+	for( unsigned int stage=0; stage < radices.size() ; stage++ )
+	{
+		unsigned int r = radices[stage]; 
+		unsigned int m = length / r; 
+		unsigned int L = s*lanes; 
+		for( unsigned int p=0; p < m ; p++ )
+		{
+			const double* wr = twiddles_re.data() + offset + p*r; 
+			const double* wi = twiddles_im.data() + offset + p*r; 
+			const double* xr = x_re + s*p*lanes; 
+			const double* xi = x_im + s*p*lanes; 
+			double* yr = y_re + s*r*p*lanes; 
+			double* yi = y_im + s*r*p*lanes; 
+			switch( r )
+			{
+				case 2: radix2_butterflies( xr , xi , m*L , yr , yi , L , L , wr , wi ); break; 
+				case 3: radix3_butterflies( xr , xi , m*L , yr , yi , L , L , wr , wi ); break; 
+				case 4: radix4_butterflies( xr , xi , m*L , yr , yi , L , L , wr , wi ); break; 
+				default: radix5_butterflies( xr , xi , m*L , yr , yi , L , L , wr , wi ); break; 
+			}
+		}
+		offset += length; 
+		length = m; 
+		s *= r; 
+		std::swap( x_re , y_re ); 
+		std::swap( x_im , y_im ); 
+	}
+	
+	if( x_re != re )
+	{
+		for( unsigned int m=0; m < fft_size*lanes ; m++ )
+		{
+			re[m] = x_re[m]; 
+			im[m] = x_im[m]; 
+		}
+	}
+	return; 
+}
+
+// in-place DFT of the n rows of lanes in z 
+void Cosine_Transform::dft( double* z_re , double* z_im , double* work ) const
+{
+	const unsigned int W = lanes; 
+	double* a_re = work; 
+	double* a_im = a_re + fft_size*W; 
+	double* b_re = a_im + fft_size*W; 
+	double* b_im = b_re + fft_size*W; 
+	
+	if( fft_size == n )
+	{
+		fft( z_re , z_im , a_re , a_im ); 
+		return; 
+	}
+	
+	// Bluestein: z_k = chirp_k * sum_j ( z_j chirp_j ) conj( chirp_{k-j} ), a 
+	// convolution evaluated with FFTs (the inverse one as conj(FFT(conj)) / fft_size) 
+	for( unsigned int j=0; j < n ; j++ )
+	{
+		double cr = chirp_re[j]; 
+		double ci = chirp_im[j]; 
+		const double* zr = z_re + j*W; 
+		const double* zi = z_im + j*W; 
+		double* ar = a_re + j*W; 
+		double* ai = a_im + j*W; 
+		#pragma omp simd
+		for( unsigned int w=0; w < W ; w++ )
+		{
+			ar[w] = zr[w]*cr - zi[w]*ci; 
+			ai[w] = zr[w]*ci + zi[w]*cr; 
+		}
+	}
+	for( unsigned int m=n*W; m < fft_size*W ; m++ )
+	{
+		a_re[m] = 0.0; 
+		a_im[m] = 0.0; 
+	}
+	fft( a_re , a_im , b_re , b_im ); 
+	for( unsigned int j=0; j < fft_size ; j++ )
+	{
+		double kr = kernel_re[j]; 
+		double ki = kernel_im[j]; 
+		double* ar = a_re + j*W; 
+		double* ai = a_im + j*W; 
+		#pragma omp simd
+		for( unsigned int w=0; w < W ; w++ )
+		{
+			double xr = ar[w]; 
+			double xi = ai[w]; 
+			ar[w] = xr*kr - xi*ki; 
+			ai[w] = -( xr*ki + xi*kr ); 
+		}
+	}
+	fft( a_re , a_im , b_re , b_im ); 
+	double normalization = 1.0 / fft_size; 
+	for( unsigned int k=0; k < n ; k++ )
+	{
+		double cr = chirp_re[k] * normalization; 
+		double ci = chirp_im[k] * normalization; 
+		const double* ar = a_re + k*W; 
+		const double* ai = a_im + k*W; 
+		double* zr = z_re + k*W; 
+		double* zi = z_im + k*W; 
+		#pragma omp simd
+		for( unsigned int w=0; w < W ; w++ )
+		{
+			double xr = ar[w]; 
+			double xi = -ai[w]; 
+			zr[w] = xr*cr - xi*ci; 
+			zi[w] = xr*ci + xi*cr; 
+		}
+	}
+	return; 
+}
+
+/* Makhoul's method: with v the line reordered as its even entries followed 
+   by its odd entries backwards, and V = DFT(v), the unnormalized DCT-II is 
+   Y_k = Re( shift_k V_k ), and conversely V_k = conj(shift_k) ( Y_k - i Y_{n-k} ). 
+   Lines a (lanes 0 ... lanes-1 of the block) and b (the other lanes) are 
+   transformed together as the complex line a + ib. */ 
+
+void Cosine_Transform::transform( double* block , bool inverse , double* work ) const
+{
+	const unsigned int W = lanes; 
+	const unsigned int B = 2*lanes; 
+	double* z_re = work; 
+	double* z_im = z_re + n*W; 
+	double* dft_work = z_im + n*W; 
+	
+	if( inverse == false )
+	{
+		for( unsigned int k=0; k < n ; k++ )
+		{
+			const double* pIn = block + even_odd_order[k]*B; 
+			double* zr = z_re + k*W; 
+			double* zi = z_im + k*W; 
+			#pragma omp simd
+			for( unsigned int w=0; w < W ; w++ )
+			{
+				zr[w] = pIn[w]; 
+				zi[w] = pIn[W+w]; 
+			}
+		}
+		
+		dft( z_re , z_im , dft_work ); 
+		
+		for( unsigned int k=0; k < n ; k++ )
+		{
+			// separate the transforms of a and b 
+			unsigned int m = ( k == 0 ) ? 0 : n-k; 
+			double sr = scale[k]*shift_re[k]; 
+			double si = scale[k]*shift_im[k]; 
+			const double* zr = z_re + k*W; 
+			const double* zi = z_im + k*W; 
+			const double* zr_mirror = z_re + m*W; 
+			const double* zi_mirror = z_im + m*W; 
+			double* pOut = block + k*B; 
+			#pragma omp simd
+			for( unsigned int w=0; w < W ; w++ )
+			{
+				double Va_re = 0.5*( zr[w] + zr_mirror[w] ); 
+				double Va_im = 0.5*( zi[w] - zi_mirror[w] ); 
+				double d_re = 0.5*( zr[w] - zr_mirror[w] ); 
+				double d_im = 0.5*( zi[w] + zi_mirror[w] ); 
+				pOut[w] = sr*Va_re - si*Va_im; 
+				pOut[W+w] = sr*d_im + si*d_re; 
+			}
+		}
+		return; 
+	}
+	
+	for( unsigned int k=0; k < n ; k++ )
+	{
+		unsigned int m = ( k == 0 ) ? 0 : n-k; 
+		double s = 1.0 / scale[k]; 
+		double s_mirror = ( k == 0 ) ? 0.0 : 1.0 / scale[m]; 
+		double sr = shift_re[k]; 
+		double si = shift_im[k]; 
+		const double* pIn = block + k*B; 
+		const double* pMirror = block + m*B; 
+		double* zr = z_re + k*W; 
+		double* zi = z_im + k*W; 
+		#pragma omp simd
+		for( unsigned int w=0; w < W ; w++ )
+		{
+			double Ya = s*pIn[w]; 
+			double Yb = s*pIn[W+w]; 
+			double Ya_mirror = s_mirror*pMirror[w]; 
+			double Yb_mirror = s_mirror*pMirror[W+w]; 
+			// conj(shift) times ( Y - i Y_mirror ) 
+			double Va_re = sr*Ya - si*Ya_mirror; 
+			double Va_im = -sr*Ya_mirror - si*Ya; 
+			double Vb_re = sr*Yb - si*Yb_mirror; 
+			double Vb_im = -sr*Yb_mirror - si*Yb; 
+			// conjugated, for the inverse DFT as conj( DFT( conj ) ) / n 
+			zr[w] = Va_re - Vb_im; 
+			zi[w] = -( Va_im + Vb_re ); 
+		}
+	}
+	
+	dft( z_re , z_im , dft_work ); 
+	
+	double normalization = 1.0 / n; 
+	for( unsigned int k=0; k < n ; k++ )
+	{
+		double* pOut = block + even_odd_order[k]*B; 
+		const double* zr = z_re + k*W; 
+		const double* zi = z_im + k*W; 
+		#pragma omp simd
+		for( unsigned int w=0; w < W ; w++ )
+		{
+			pOut[w] = zr[w] * normalization; 
+			pOut[W+w] = -zi[w] * normalization; 
+		}
+	}
+	return; 
+}
+
+// the step of each mode, applied while the lines along the last axis are 
+// transformed: entry p of line l is multiplied by line[l]*axis[p] (exponential) 
+// or divided by line[l]+axis[p] (implicit) 
+struct DCT_Mode_Step
+{
+	const double* line; 
+	const double* axis; 
+	bool exponential; 
+}; 
+
+// transform every line along one axis: line l of group g starts at offset 
+// g*group_stride + l*line_stride, with entries stride apart; the entry at 
+// offset o is read from in[o*in_spacing] and written to out[o*out_spacing]. 
+// Blocks of lines are gathered into the interleaved layout, transformed, and 
+// scattered back. With a mode step, the lines are transformed, stepped, and 
+// transformed back. 
+static void cosine_transform_lines( const double* in , unsigned int in_spacing , double* out , unsigned int out_spacing , 
+	const Cosine_Transform& T , unsigned int groups , unsigned int group_stride , unsigned int lines , 
+	unsigned int line_stride , unsigned int stride , bool inverse , const DCT_Mode_Step* step )
+{
+	const unsigned int B = 2*Cosine_Transform::lanes; 
+	unsigned int n = T.n; 
+	unsigned int blocks_per_group = ( lines + B - 1 ) / B; 
+	// the strides in memory 
+	unsigned int in_stride = stride*in_spacing; 
+	unsigned int in_line_stride = line_stride*in_spacing; 
+	unsigned int out_stride = stride*out_spacing; 
+	unsigned int out_line_stride = line_stride*out_spacing; 
+	#pragma omp parallel
+	{
+		std::vector<double> work( T.work_size() ); 
+		std::vector<double> block( B*n , 0.0 ); 
+		#pragma omp for
+		for( unsigned int t=0; t < groups*blocks_per_group ; t++ )
+		{
+			unsigned int first = ( t % blocks_per_group ) * B; 
+			unsigned int length = std::min( B , lines - first ); 
+			unsigned int base = ( t / blocks_per_group ) * group_stride + first*line_stride; 
+			
+			// loop over whichever index is closer together in memory innermost 
+			const double* pBase = in + base*in_spacing; 
+			if( stride < line_stride )
+			{
+				for( unsigned int l=0; l < length ; l++ )
+				{
+					const double* pIn = pBase + l*in_line_stride; 
+					for( unsigned int p=0; p < n ; p++ )
+					{ block[p*B+l] = pIn[p*in_stride]; }
+				}
+			}
+			else
+			{
+				for( unsigned int p=0; p < n ; p++ )
+				{
+					const double* pIn = pBase + p*in_stride; 
+					double* pBlock = block.data() + p*B; 
+					for( unsigned int l=0; l < length ; l++ )
+					{ pBlock[l] = pIn[l*in_line_stride]; }
+				}
+			}
+			
+			if( step == NULL )
+			{ T.transform( block.data() , inverse , work.data() ); }
+			else
+			{
+				T.transform( block.data() , false , work.data() ); 
+				const double* line = step->line + first; 
+				for( unsigned int p=0; p < n ; p++ )
+				{
+					double* pBlock = block.data() + p*B; 
+					double axis = step->axis[p]; 
+					if( step->exponential )
+					{
+						for( unsigned int l=0; l < length ; l++ )
+						{ pBlock[l] *= line[l] * axis; }
+					}
+					else
+					{
+						for( unsigned int l=0; l < length ; l++ )
+						{ pBlock[l] /= line[l] + axis; }
+					}
+				}
+				T.transform( block.data() , true , work.data() ); 
+			}
+			
+			double* pOutBase = out + base*out_spacing; 
+			if( stride < line_stride )
+			{
+				for( unsigned int l=0; l < length ; l++ )
+				{
+					double* pOut = pOutBase + l*out_line_stride; 
+					for( unsigned int p=0; p < n ; p++ )
+					{ pOut[p*out_stride] = block[p*B+l]; }
+				}
+			}
+			else
+			{
+				for( unsigned int p=0; p < n ; p++ )
+				{
+					double* pOut = pOutBase + p*out_stride; 
+					const double* pBlock = block.data() + p*B; 
+					for( unsigned int l=0; l < length ; l++ )
+					{ pOut[l*out_line_stride] = pBlock[l]; }
+				}
+			}
+		}
+	}
+	return; 
+}
+
+void Microenvironment::constant_coefficients_DCT_step( double dt , bool exponential )
+{
+	if( mesh.regular_mesh == false || mesh.Cartesian_mesh == false )
+	{
+		std::cout << "Error: This algorithm is written for regular Cartesian meshes. Try: other solvers!" << std::endl << std::endl; 
+		return; 
+	}
+	
+	unsigned int nx = mesh.x_coordinates.size(); 
+	unsigned int ny = mesh.y_coordinates.size(); 
+	unsigned int nz = mesh.z_coordinates.size(); 
+	unsigned int nv = number_of_voxels(); 
+
+	if( !diffusion_solver_setup_done || dct_work.size() != nv )
+	{
+		if( exponential )
+		{ std::cout << std::endl << "Using method diffusion_decay_solver__constant_coefficients_DCT_exponential (exact 3-D step by cosine transforms) ... " << std::endl << std::endl; }
+		else
+		{ std::cout << std::endl << "Using method diffusion_decay_solver__constant_coefficients_DCT (implicit 3-D step by cosine transforms) ... " << std::endl << std::endl; }
+		
+		dct_x.setup( nx , mesh.dx ); 
+		dct_y.setup( ny , mesh.dy ); 
+		dct_z.setup( nz , mesh.dz ); 
+		dct_work.resize( nv ); 
+		dct_factors_dt = 0.0; 
+		
+		diffusion_solver_setup_done = true; 
+	}
+	
+	Density_Store& D = *p_density_vectors; 
+	unsigned int nd = D.number_of_densities(); 
+	
+	// the per-axis factors of the exact step, if dt or the coefficients changed 
+	if( exponential && ( dct_factors_dt != dt || 
+		dct_factors_diffusion_coefficients != diffusion_coefficients || 
+		dct_factors_decay_rates != decay_rates ) )
+	{
+		dct_factors_x.resize( nd*nx ); 
+		dct_factors_y.resize( nd*ny ); 
+		dct_factors_z.resize( nd*nz ); 
+		for( unsigned int q=0; q < nd ; q++ )
+		{
+			double c1 = dt*diffusion_coefficients[q]; 
+			for( unsigned int i=0; i < nx ; i++ )
+			{ dct_factors_x[q*nx+i] = exp( -c1*dct_x.eigenvalues[i] ); }
+			for( unsigned int j=0; j < ny ; j++ )
+			{ dct_factors_y[q*ny+j] = exp( -c1*dct_y.eigenvalues[j] ); }
+			for( unsigned int k=0; k < nz ; k++ )
+			{ dct_factors_z[q*nz+k] = exp( -c1*dct_z.eigenvalues[k] ); }
+		}
+		dct_factors_dt = dt; 
+		dct_factors_diffusion_coefficients = diffusion_coefficients; 
+		dct_factors_decay_rates = decay_rates; 
+	}
+	
+	// the lines along each axis: groups, group stride, lines, line stride, and 
+	// stride, for voxel (i,j,k) at i + nx*(j + ny*k) 
+	const Cosine_Transform* transforms[3] = { &dct_x , &dct_y , &dct_z }; 
+	const std::vector<double>* factors[3] = { &dct_factors_x , &dct_factors_y , &dct_factors_z }; 
+	unsigned int axis_lines[3][5] = { { 1 , 0 , ny*nz , nx , 1 } , 
+		{ nz , nx*ny , nx , 1 , nx } , { 1 , 0 , nx*ny , 1 , nx*ny } }; 
+	
+	// the last axis with more than one voxel is transformed, stepped, and 
+	// transformed back in one pass; the others are transformed around it 
+	// (an axis with a single voxel needs no transform). Lines along the last 
+	// axis are numbered i + nlx*j. 
+	unsigned int last = ( nz > 1 ) ? 2 : ( ( ny > 1 ) ? 1 : 0 ); 
+	unsigned int nlx = ( last == 0 ) ? 1 : nx; 
+	unsigned int nly = ( last == 2 ) ? ny : 1; 
+	std::vector<unsigned int> pass_axes; 
+	for( unsigned int a=0; a < last ; a++ )
+	{
+		if( transforms[a]->n > 1 )
+		{ pass_axes.push_back( a ); }
+	}
+	unsigned int forward_passes = pass_axes.size(); 
+	pass_axes.push_back( last ); 
+	for( unsigned int a=forward_passes; a > 0 ; a-- )
+	{ pass_axes.push_back( pass_axes[a-1] ); }
+	
+	dct_line_factors.resize( nlx*nly ); 
+	std::vector<double> axis_factors( transforms[last]->n ); 
+	
+	apply_dirichlet_conditions(); 
+	
+	for( unsigned int q=0; q < nd ; q++ )
+	{
+		// the implicit (or exact) step for each mode, split into the factors 
+		// of the other axes for each line, and of the last axis (an axis with 
+		// a single voxel has a zero eigenvalue, and a factor of one) 
+		double c0 = dt*decay_rates[q]; 
+		double c1 = dt*diffusion_coefficients[q]; 
+		for( unsigned int j=0; j < nly ; j++ )
+		{
+			for( unsigned int i=0; i < nlx ; i++ )
+			{
+				if( exponential )
+				{ dct_line_factors[i+nlx*j] = exp( -c0 ) * dct_factors_x[q*nx+i] * dct_factors_y[q*ny+j]; }
+				else
+				{ dct_line_factors[i+nlx*j] = 1.0 + c0 + c1*( dct_x.eigenvalues[i] + dct_y.eigenvalues[j] ); }
+			}
+		}
+		for( unsigned int k=0; k < axis_factors.size() ; k++ )
+		{
+			if( exponential )
+			{ axis_factors[k] = (*factors[last])[q*axis_factors.size()+k]; }
+			else
+			{ axis_factors[k] = c1*transforms[last]->eigenvalues[k]; }
+		}
+		DCT_Mode_Step step; 
+		step.line = dct_line_factors.data(); 
+		step.axis = axis_factors.data(); 
+		step.exponential = exponential; 
+		
+		// the first pass reads the density, and the last one writes it back 
+		double* pDensity = D.data() + q*D.substrate_stride(); 
+		double* pWork = dct_work.data(); 
+		for( unsigned int t=0; t < pass_axes.size() ; t++ )
+		{
+			const double* in = ( t == 0 ) ? pDensity : pWork; 
+			unsigned int in_spacing = ( t == 0 ) ? D.voxel_stride() : 1; 
+			double* out = ( t+1 == pass_axes.size() ) ? pDensity : pWork; 
+			unsigned int out_spacing = ( t+1 == pass_axes.size() ) ? D.voxel_stride() : 1; 
+			unsigned int* L = axis_lines[ pass_axes[t] ]; 
+			cosine_transform_lines( in , in_spacing , out , out_spacing , *transforms[ pass_axes[t] ] , 
+				L[0] , L[1] , L[2] , L[3] , L[4] , t > forward_passes , ( t == forward_passes ) ? &step : NULL ); 
+		}
+	}
+	
+	apply_dirichlet_conditions(); 
+	return; 
+}
+
+void diffusion_decay_solver__constant_coefficients_DCT( Microenvironment& M, double dt )
+{ M.constant_coefficients_DCT_step( dt , false ); }
+
+void diffusion_decay_solver__constant_coefficients_DCT_exponential( Microenvironment& M, double dt )
+{ M.constant_coefficients_DCT_step( dt , true ); }
 
 };
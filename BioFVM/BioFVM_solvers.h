@@ -56,10 +56,26 @@ namespace BioFVM{
 
 // /*! diffusion-decay solver: 3D LOD implicit (stable method). D and r uniform */  
 void diffusion_decay_solver__constant_coefficients_LOD_3D( Microenvironment& M, double dt ); // done
+// /*! a single sweep of the 3D LOD solver (direction 0, 1, 2 for x, y, z). Mainly for benchmarking. */ 
+void diffusion_decay_solver__constant_coefficients_LOD_3D_sweep( Microenvironment& M, double dt , int direction ); 
 // /*! diffusion-decay solver: 2D LOD implicit (stable method). D and r uniform */  
 void diffusion_decay_solver__constant_coefficients_LOD_2D( Microenvironment& M, double dt ); // done
 void diffusion_decay_solver__constant_coefficients_LOD_1D( Microenvironment& M, double dt ); // done
 
+// /*! diffusion-decay solvers: 3D and 2D LOD implicit, with a diffusion coefficient and decay rate per voxel -- 1.7.2 */ 
+void diffusion_decay_solver__variable_coefficients_LOD_3D( Microenvironment& M, double dt ); 
+void diffusion_decay_solver__variable_coefficients_LOD_2D( Microenvironment& M, double dt ); 
+
+// /*! steady-state solver: geometric multigrid for D*Laplacian(u) - lambda*u - U(x)*u + M(X)*(uT-u) = 0, 
+//     including the cell sources and sinks. Warm-started from the current densities; dt is unused. -- 1.7.2 */ 
+void diffusion_decay_solver__steady_state_multigrid( Microenvironment& M, double dt ); 
+
+// /*! diffusion-decay solver: one fully implicit step (no splitting error) by cosine transforms along 
+//     each axis. D and lambda uniform, no-flux outer boundaries. -- 1.7.2 */ 
+void diffusion_decay_solver__constant_coefficients_DCT( Microenvironment& M, double dt ); 
+// /*! as above, but each mode is advanced exactly (by exp(-dt*eigenvalue)) rather than by an implicit step -- 1.7.2 */ 
+void diffusion_decay_solver__constant_coefficients_DCT_exponential( Microenvironment& M, double dt ); 
+
 /*! This solves for constant diffusion coefficients on a general mesh using the 
     explicit stepping for the diffusion operator, and implicit stepping for all 
     other terms to increase stability. It is suitable for a general mesh. */ 
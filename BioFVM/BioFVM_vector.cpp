@@ -484,4 +484,213 @@ void vector3_to_list( const std::vector<double>& vect , char*& buffer , char del
 	return; 
 }
 
+/* flat density storage (new in 1.7.2) */ 
+
+void* aligned_malloc( size_t bytes , size_t alignment )
+{
+	// over-allocate, then stash the original pointer just before the aligned block 
+	void* raw = malloc( bytes + alignment + sizeof(void*) ); 
+	if( raw == NULL )
+	{ throw std::bad_alloc(); }
+	size_t address = (size_t) raw + sizeof(void*); 
+	address += alignment - ( address % alignment ); 
+	void* aligned = (void*) address; 
+	((void**) aligned)[-1] = raw; 
+	return aligned; 
+}
+
+void aligned_free( void* ptr )
+{
+	if( ptr )
+	{ free( ((void**) ptr)[-1] ); }
+	return; 
+}
+
+Density_Vector_View::Density_Vector_View( double* data , unsigned int size , unsigned int stride )
+{
+	pData = data; 
+	n = size; 
+	jump = stride; 
+	return; 
+}
+
+Density_Vector_View::operator std::vector<double>() const
+{
+	std::vector<double> out( n ); 
+	for( unsigned int i=0; i < n ; i++ )
+	{ out[i] = pData[i*jump]; }
+	return out; 
+}
+
+Density_Vector_View& Density_Vector_View::operator=( const Density_Vector_View& v )
+{
+	for( unsigned int i=0; i < n ; i++ )
+	{ pData[i*jump] = v[i]; }
+	return *this; 
+}
+
+Density_Vector_View& Density_Vector_View::operator=( const std::vector<double>& v )
+{
+	for( unsigned int i=0; i < n ; i++ )
+	{ pData[i*jump] = v[i]; }
+	return *this; 
+}
+
+void Density_Vector_View::operator+=( const std::vector<double>& v )
+{
+	for( unsigned int i=0; i < n ; i++ )
+	{ pData[i*jump] += v[i]; }
+	return; 
+}
+
+void Density_Vector_View::operator-=( const std::vector<double>& v )
+{
+	for( unsigned int i=0; i < n ; i++ )
+	{ pData[i*jump] -= v[i]; }
+	return; 
+}
+
+void Density_Vector_View::operator*=( const std::vector<double>& v )
+{
+	for( unsigned int i=0; i < n ; i++ )
+	{ pData[i*jump] *= v[i]; }
+	return; 
+}
+
+void Density_Vector_View::operator/=( const std::vector<double>& v )
+{
+	for( unsigned int i=0; i < n ; i++ )
+	{ pData[i*jump] /= v[i]; }
+	return; 
+}
+
+void Density_Vector_View::operator*=( double a )
+{
+	for( unsigned int i=0; i < n ; i++ )
+	{ pData[i*jump] *= a; }
+	return; 
+}
+
+void Density_Vector_View::operator/=( double a )
+{
+	for( unsigned int i=0; i < n ; i++ )
+	{ pData[i*jump] /= a; }
+	return; 
+}
+
+std::ostream& operator<<( std::ostream& os, const Density_Vector_View& v )
+{
+	for( unsigned int i=0; i < v.size(); i++ )
+	{ os << v[i] << " " ; }
+	return os; 
+}
+
+void axpy( std::vector<double>* y, double& a , const Density_Vector_View& x )
+{
+	for( unsigned int i=0; i < (*y).size() ; i++ )
+	{ (*y)[i] += a * x[i]; }
+	return; 
+}
+
+void axpy( std::vector<double>* y, std::vector<double>& a , const Density_Vector_View& x )
+{
+	for( unsigned int i=0; i < (*y).size() ; i++ )
+	{ (*y)[i] += a[i] * x[i]; }
+	return; 
+}
+
+Density_Store::Density_Store()
+{
+	voxel_count = 0; 
+	density_count = 0; 
+	layout_code = density_layout_voxel_major; 
+	update_strides(); 
+	return; 
+}
+
+void Density_Store::update_strides( void )
+{
+	if( layout_code == density_layout_substrate_major )
+	{
+		voxel_jump = 1; 
+		substrate_jump = voxel_count; 
+	}
+	else
+	{
+		voxel_jump = density_count; 
+		substrate_jump = 1; 
+	}
+	return; 
+}
+
+void Density_Store::resize( unsigned int number_of_voxels , unsigned int number_of_densities )
+{
+	voxel_count = number_of_voxels; 
+	density_count = number_of_densities; 
+	values.assign( (size_t) voxel_count * density_count , 0.0 ); 
+	update_strides(); 
+	return; 
+}
+
+void Density_Store::reshape( unsigned int number_of_voxels , unsigned int number_of_densities )
+{
+	Density_Store temp; 
+	temp.layout_code = layout_code; 
+	temp.resize( number_of_voxels , number_of_densities ); 
+	
+	unsigned int common_voxels = std::min( voxel_count , number_of_voxels ); 
+	unsigned int common_densities = std::min( density_count , number_of_densities ); 
+	for( unsigned int n=0; n < common_voxels ; n++ )
+	{
+		for( unsigned int q=0; q < common_densities ; q++ )
+		{ temp(n,q) = (*this)(n,q); }
+	}
+	swap( temp ); 
+	return; 
+}
+
+void Density_Store::resize_voxels( unsigned int number_of_voxels )
+{ return reshape( number_of_voxels , density_count ); } 
+
+void Density_Store::resize_densities( unsigned int number_of_densities )
+{ return reshape( voxel_count , number_of_densities ); } 
+
+void Density_Store::set_layout( int new_layout )
+{
+	if( new_layout == layout_code )
+	{ return; }
+	
+	Density_Store temp; 
+	temp.layout_code = new_layout; 
+	temp.resize( voxel_count , density_count ); 
+	for( unsigned int n=0; n < voxel_count ; n++ )
+	{
+		for( unsigned int q=0; q < density_count ; q++ )
+		{ temp(n,q) = (*this)(n,q); }
+	}
+	swap( temp ); 
+	return; 
+}
+
+void Density_Store::fill( const std::vector<double>& value )
+{
+	for( unsigned int n=0; n < voxel_count ; n++ )
+	{
+		for( unsigned int q=0; q < density_count ; q++ )
+		{ (*this)(n,q) = value[q]; }
+	}
+	return; 
+}
+
+void Density_Store::swap( Density_Store& other )
+{
+	values.swap( other.values ); 
+	std::swap( voxel_count , other.voxel_count ); 
+	std::swap( density_count , other.density_count ); 
+	std::swap( layout_code , other.layout_code ); 
+	update_strides(); 
+	other.update_strides(); 
+	return; 
+}
+
 };
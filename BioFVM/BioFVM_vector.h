@@ -54,6 +54,8 @@
 #include <vector> 
 #include <cmath>
 #include <cstring>
+#include <algorithm>
+#include <new>
 
 namespace BioFVM{
 
@@ -139,6 +141,140 @@ void vector_to_list( const std::vector<double>& vect , char*& buffer , char deli
 
 void vector3_to_list( const std::vector<double>& vect , char*& buffer , char delim ); 
 
+/* flat density storage (new in 1.7.2) */ 
+
+// over-aligned allocator so that the flat density store (and other solver 
+// scratch arrays) start on a cache-line boundary 
+
+void* aligned_malloc( size_t bytes , size_t alignment ); 
+void aligned_free( void* ptr ); 
+
+template <class T> 
+class Aligned_Allocator
+{
+ public:
+	typedef T value_type; 
+	static const size_t alignment = 64; 
+
+	Aligned_Allocator() {} 
+	template <class U> Aligned_Allocator( const Aligned_Allocator<U>& ) {} 
+
+	T* allocate( size_t n )
+	{ return (T*) aligned_malloc( n*sizeof(T) , alignment ); }
+	void deallocate( T* p , size_t /*n*/ )
+	{ aligned_free( p ); }
+};
+
+template <class T, class U> 
+bool operator==( const Aligned_Allocator<T>& , const Aligned_Allocator<U>& ) { return true; } 
+template <class T, class U> 
+bool operator!=( const Aligned_Allocator<T>& , const Aligned_Allocator<U>& ) { return false; } 
+
+typedef std::vector< double , Aligned_Allocator<double> > aligned_vector; 
+
+/* 
+   A Density_Vector_View is a lightweight handle to the substrate values of 
+   a single voxel inside a flat density store. It behaves like a reference: 
+   copying a view does not copy data, but assigning to it writes through to 
+   the store. It converts to a std::vector<double> (by copy) wherever one 
+   is expected, so that older custom code keeps compiling. 
+*/ 
+
+class Density_Vector_View
+{
+ private:
+	double* pData; 
+	unsigned int n; 
+	unsigned int jump; 
+	
+ public:
+	Density_Vector_View( double* data , unsigned int size , unsigned int stride ); 
+	
+	double& operator[]( unsigned int i ) const { return pData[ i*jump ]; } 
+	unsigned int size( void ) const { return n; }  
+	unsigned int stride( void ) const { return jump; } 
+	double* data( void ) const { return pData; } 
+	
+	operator std::vector<double>() const; 
+	
+	// these write through to the store 
+	Density_Vector_View& operator=( const Density_Vector_View& v ); 
+	Density_Vector_View& operator=( const std::vector<double>& v ); 
+	
+	void operator+=( const std::vector<double>& v ); 
+	void operator-=( const std::vector<double>& v ); 
+	void operator*=( const std::vector<double>& v ); 
+	void operator/=( const std::vector<double>& v ); 
+	void operator*=( double a ); 
+	void operator/=( double a ); 
+};
+
+std::ostream& operator<<( std::ostream& os, const Density_Vector_View& v ); 
+
+// y = y + a*x 
+void axpy( std::vector<double>* y, double& a , const Density_Vector_View& x );
+// y = y + a.*x
+void axpy( std::vector<double>* y, std::vector<double>& a , const Density_Vector_View& x ); 
+
+/* 
+   Density_Store keeps all substrate densities of a mesh in a single, 
+   aligned block. The storage layout is chosen at setup: 
+   
+   density_layout_voxel_major: [voxel][substrate] (substrates interleaved, 
+      so each voxel's densities are contiguous). This is the default. 
+   density_layout_substrate_major: [substrate][voxel] (each substrate is a 
+      contiguous field over the whole mesh). 
+   
+   Value (n,q) lives at data()[ n*voxel_stride() + q*substrate_stride() ]. 
+*/ 
+
+static const int density_layout_voxel_major = 0; 
+static const int density_layout_substrate_major = 1; 
+
+class Density_Store
+{
+ private:
+	aligned_vector values; 
+	unsigned int voxel_count; 
+	unsigned int density_count; 
+	int layout_code; 
+	unsigned int voxel_jump; 
+	unsigned int substrate_jump; 
+	
+	void update_strides( void ); 
+	// resizes while keeping the overlapping data 
+	void reshape( unsigned int number_of_voxels , unsigned int number_of_densities ); 
+	
+ public:
+	Density_Store(); 
+	
+	// discards all data; everything is set to zero 
+	void resize( unsigned int number_of_voxels , unsigned int number_of_densities ); 
+	// these keep existing data; new entries are zero 
+	void resize_voxels( unsigned int number_of_voxels ); 
+	void resize_densities( unsigned int number_of_densities ); 
+	// keeps existing data; rearranges it in memory as needed 
+	void set_layout( int new_layout ); 
+	
+	int layout( void ) const { return layout_code; } 
+	unsigned int number_of_voxels( void ) const { return voxel_count; } 
+	unsigned int number_of_densities( void ) const { return density_count; } 
+	unsigned int voxel_stride( void ) const { return voxel_jump; } 
+	unsigned int substrate_stride( void ) const { return substrate_jump; } 
+	
+	double* data( void ) { return values.data(); } 
+	const double* data( void ) const { return values.data(); } 
+	
+	double& operator()( unsigned int n , unsigned int q ) 
+	{ return values[ n*voxel_jump + q*substrate_jump ]; } 
+	Density_Vector_View operator[]( unsigned int n )
+	{ return Density_Vector_View( values.data() + n*voxel_jump , density_count , substrate_jump ); } 
+	
+	// sets every voxel to the same density vector 
+	void fill( const std::vector<double>& value ); 
+	void swap( Density_Store& other ); 
+};
+
 };
 
 #endif
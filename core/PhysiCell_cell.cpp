@@ -71,6 +71,7 @@
 #include "PhysiCell_constants.h"
 #include "../BioFVM/BioFVM_vector.h" 
 #include<limits.h>
+#include <new>
 
 #include <signal.h>  // for segfault
 
@@ -320,6 +321,20 @@ void Cell::advance_bundled_phenotype_functions( double dt_ )
 }
 
 Cell::Cell()
+{
+	pool_slot = -1; 
+	initialize_to_defaults(); 
+	return; 
+}
+
+void Cell::reset( void )
+{
+	Basic_Agent::reset(); 
+	initialize_to_defaults(); 
+	return; 
+}
+
+void Cell::initialize_to_defaults( void )
 {
 	// use the cell defaults; 
 	
@@ -335,6 +350,10 @@ Cell::Cell()
 	phenotype.molecular.sync_to_cell( this ); 
 	
 	// cell state should be fine by the default constructor 
+	// (but a reused cell carries the state of its last life) 
+	state.neighbors.clear(); 
+	state.orientation.assign( 3 , 0.0 ); 
+	state.simple_pressure = 0.0; 
 	
 	current_mechanics_voxel_index=-1;
 	
@@ -342,7 +361,8 @@ Cell::Cell()
 	
 	is_movable = true;
 	is_out_of_domain = false;
-	displacement.resize(3,0.0); // state? 
+	previous_mechanics_dt = 0.0; 
+	displacement.assign(3,0.0); // state? 
 	
 	assign_orientation();
 	container = NULL;
@@ -418,6 +438,20 @@ Cell* Cell::divide( )
 	// phenotype.flagged_for_removal = false; 
 	
 	Cell* child = create_cell();
+	std::vector<double> direction = cell_division_orientation(); 
+	divide_into( child , direction ); 
+	
+	// register the child in its voxel, and move this cell to its new one 
+	child->assign_position( child->position ); 
+	update_voxel_in_container();
+	child->update_interaction_distance_in_voxel(); 
+	update_interaction_distance_in_voxel(); 
+	
+	return child;
+}
+
+void Cell::divide_into( Cell* child , std::vector<double>& direction )
+{
 	child->copy_data( this );	
 	child->copy_function_pointers(this);
 	child->parameters = parameters;
@@ -458,15 +492,16 @@ Cell* Cell::divide( )
 	rand_vec *= radius; // multiply direction times the displacement 
 	*/
 	
-	std::vector<double> rand_vec = cell_division_orientation(); 
+	std::vector<double> rand_vec = direction; 
 	rand_vec = rand_vec- phenotype.geometry.polarity*(rand_vec[0]*state.orientation[0]+ 
 		rand_vec[1]*state.orientation[1]+rand_vec[2]*state.orientation[2])*state.orientation;	
 	rand_vec *= phenotype.geometry.radius;
 
-	child->assign_position(position[0] + rand_vec[0],
-						   position[1] + rand_vec[1],
-						   position[2] + rand_vec[2]);
-						 
+	// (the caller registers the child at this position) 
+	child->position[0] = position[0] + rand_vec[0]; 
+	child->position[1] = position[1] + rand_vec[1]; 
+	child->position[2] = position[2] + rand_vec[2]; 
+	
 	//change my position to keep the center of mass intact 
 	// and then see if I need to update my voxel index
 	static double negative_one_half = -0.5; 
@@ -481,16 +516,19 @@ Cell* Cell::divide( )
 		is_movable = false;
 	}	
 	 
-	update_voxel_in_container();
 	phenotype.volume.divide(); 
 	child->phenotype.volume.divide();
-	child->set_total_volume(child->phenotype.volume.total);
-	set_total_volume(phenotype.volume.total);
+	child->set_total_volume_of_cell(child->phenotype.volume.total);
+	set_total_volume_of_cell(phenotype.volume.total);
 	
 	// child->set_phenotype( phenotype ); 
 	child->phenotype = phenotype; 
 	
-	return child;
+	// the daughter draws its own event clocks -- 1.7.2 
+	child->phenotype.cycle.data.reset_transition_clock(); 
+	child->phenotype.death.reset_death_clock(); 
+	
+	return; 
 }
 
 bool Cell::assign_position(std::vector<double> new_position)
@@ -532,6 +570,13 @@ bool Cell::assign_position(double x, double y, double z)
 }
 
 void Cell::set_total_volume(double volume)
+{
+	set_total_volume_of_cell( volume ); 
+	update_interaction_distance_in_voxel(); 
+	return; 
+}
+
+void Cell::set_total_volume_of_cell( double volume )
 {
 	Basic_Agent::set_total_volume(volume);
 	
@@ -548,15 +593,20 @@ void Cell::set_total_volume(double volume)
 	
 	phenotype.geometry.update( this, phenotype, 0.0 ); 
 	// phenotype.update_radius();
+	return; 
+}
+
+void Cell::update_interaction_distance_in_voxel( void )
+{
+	// cells that are not in a voxel yet (or any more) have nothing to update 
+	if( get_current_mechanics_voxel_index() < 0 )
+	{ return; }
+	
 	//if( get_container()->max_cell_interactive_distance_in_voxel[get_current_mechanics_voxel_index()] < 
 	//	phenotype.geometry.radius * parameters.max_interaction_distance_factor )
-	if( get_container()->max_cell_interactive_distance_in_voxel[get_current_mechanics_voxel_index()] < 
-		phenotype.geometry.radius * phenotype.mechanics.relative_maximum_adhesion_distance )
-	{
-		// get_container()->max_cell_interactive_distance_in_voxel[get_current_mechanics_voxel_index()]= phenotype.geometry.radius*parameters.max_interaction_distance_factor;
-		get_container()->max_cell_interactive_distance_in_voxel[get_current_mechanics_voxel_index()] = phenotype.geometry.radius
-			* phenotype.mechanics.relative_maximum_adhesion_distance;
-	}
+	// (through the container, which may hash its voxels -- 1.7.2) 
+	get_container()->record_interaction_distance( get_current_mechanics_voxel_index() , 
+		phenotype.geometry.radius * phenotype.mechanics.relative_maximum_adhesion_distance ); 
 	
 	return; 
 }
@@ -664,18 +714,14 @@ void Cell::update_position( double dt )
 	// 
 	// Basic_Agent::update_position(dt);
 		
-	// use Adams-Bashforth 
-	static double d1; 
-	static double d2; 
-	static bool constants_defined = false; 
-	if( constants_defined == false )
-	{
-		d1 = dt; 
-		d1 *= 1.5; 
-		d2 = dt; 
-		d2 *= -0.5; 
-		constants_defined = true; 
-	}
+	// use Adams-Bashforth, for steps of varying size (the adaptive mechanics 
+	// step -- 1.7.2). With equal steps, d1 = 1.5*dt and d2 = -0.5*dt. 
+	double ratio = 1.0; 
+	if( previous_mechanics_dt > 0.0 )
+	{ ratio = dt / previous_mechanics_dt; }
+	double d1 = dt * ( 1.0 + 0.5 * ratio ); 
+	double d2 = -0.5 * dt * ratio; 
+	previous_mechanics_dt = dt; 
 	
 	// new AUgust 2017
 	if( default_microenvironment_options.simulate_2D == true )
@@ -868,10 +914,148 @@ void Cell::add_potentials(Cell* other_agent)
 	return;
 }
 
+Cell_Handle::Cell_Handle()
+{
+	slot = -1; 
+	generation = 0; 
+	return; 
+}
+
+Cell* Cell_Handle::get( void ) const
+{ return cell_pool.resolve( *this ); }
+
+bool Cell_Handle::is_stale( void ) const
+{ return get() == NULL; }
+
+bool Cell_Handle::operator==( const Cell_Handle& other ) const
+{ return slot == other.slot && generation == other.generation; }
+
+Cell_Handle Cell::get_handle( void ) const
+{ return cell_pool.get_handle( this ); }
+
+Cell_Pool cell_pool; 
+
+Cell_Pool::Cell_Pool()
+{
+	cells_per_slab = 256; 
+	slabs.resize(0); 
+	used_in_last_slab = cells_per_slab; 
+	free_cells.resize(0); 
+	live = 0; 
+	generations.resize(0); 
+	return; 
+}
+
+Cell* Cell_Pool::allocate( void )
+{
+	Cell* pCell = NULL; 
+	bool reuse = false; 
+	int slot = -1; 
+	#pragma omp critical(cell_pool) 
+	{
+		if( free_cells.size() > 0 )
+		{
+			pCell = free_cells.back(); 
+			free_cells.pop_back(); 
+			reuse = true; 
+		}
+		else
+		{
+			if( used_in_last_slab == cells_per_slab )
+			{
+				slabs.push_back( (Cell*) ::operator new( cells_per_slab * sizeof(Cell) ) ); 
+				generations.resize( slabs.size() * cells_per_slab , 0 ); 
+				used_in_last_slab = 0; 
+			}
+			pCell = slabs.back() + used_in_last_slab; 
+			slot = ( slabs.size() - 1 ) * cells_per_slab + used_in_last_slab; 
+			used_in_last_slab++; 
+		}
+		live++; 
+	}
+	
+	// build (or rebuild) the cell outside of the critical section 
+	if( reuse )
+	{ pCell->reset(); }
+	else
+	{
+		new (pCell) Cell; 
+		pCell->pool_slot = slot; 
+	}
+	
+	return pCell; 
+}
+
+void Cell_Pool::release( Cell* pCell )
+{
+	#pragma omp critical(cell_pool) 
+	{
+		free_cells.push_back( pCell ); 
+		live--; 
+		generations[ pCell->pool_slot ]++; 
+		
+		std::unordered_map<int,int>::iterator search = slots_by_ID.find( pCell->ID ); 
+		if( search != slots_by_ID.end() && search->second == pCell->pool_slot )
+		{ slots_by_ID.erase( search ); }
+	}
+	return; 
+}
+
+void Cell_Pool::register_ID( Cell* pCell )
+{
+	#pragma omp critical(cell_pool) 
+	{ slots_by_ID[ pCell->ID ] = pCell->pool_slot; }
+	return; 
+}
+
+Cell* Cell_Pool::find_cell_by_ID( int ID ) const
+{
+	std::unordered_map<int,int>::const_iterator search = slots_by_ID.find( ID ); 
+	if( search == slots_by_ID.end() )
+	{ return NULL; }
+	int slot = search->second; 
+	return slabs[ slot / cells_per_slab ] + ( slot % cells_per_slab ); 
+}
+
+Cell_Handle Cell_Pool::get_handle( const Cell* pCell ) const
+{
+	Cell_Handle handle; 
+	if( pCell->pool_slot < 0 )
+	{ return handle; }
+	handle.slot = pCell->pool_slot; 
+	handle.generation = generations[ pCell->pool_slot ]; 
+	return handle; 
+}
+
+Cell* Cell_Pool::resolve( const Cell_Handle& handle ) const
+{
+	if( handle.slot < 0 || handle.slot >= (int) generations.size() || 
+		generations[ handle.slot ] != handle.generation )
+	{ return NULL; }
+	return slabs[ handle.slot / cells_per_slab ] + ( handle.slot % cells_per_slab ); 
+}
+
+int Cell_Pool::live_cells( void ) const
+{ return live; }
+
+int Cell_Pool::reserved_cells( void ) const
+{ return slabs.size() * cells_per_slab; }
+
+double Cell_Pool::reserved_megabytes( void ) const
+{ return reserved_cells() * sizeof(Cell) / ( 1024.0 * 1024.0 ); }
+
+void Cell_Pool::display( std::ostream& os ) const
+{
+	os << "cell pool: " << live_cells() << " live cells, " << reserved_cells() << " reserved (" 
+		<< reserved_megabytes() << " MB)" << std::endl; 
+	return; 
+}
+
 Cell* create_cell( void )
 {
 	Cell* pNew; 
-	pNew = new Cell;		
+	pNew = cell_pool.allocate();		
+	cell_pool.register_ID( pNew ); 
 	(*all_cells).push_back( pNew ); 
 	pNew->index=(*all_cells).size()-1;
 	
@@ -947,8 +1131,8 @@ void delete_cell( int index )
 	
 	// deregister agent in from the agent container
 	(*all_cells)[index]->get_container()->remove_agent((*all_cells)[index]);
-	// de-allocate (delete) the cell; 
-	delete (*all_cells)[index]; 
+	// keep the cell for reuse (it is no longer an agent) 
+	cell_pool.release( (*all_cells)[index] ); 
 
 	// performance goal: don't delete in the middle -- very expensive reallocation
 	// alternative: copy last element to index position, then shrink vector by 1 at the end O(constant)
@@ -967,10 +1151,16 @@ void delete_cell( Cell* pDelete )
 	return; 
 }
 
-bool is_neighbor_voxel(Cell* pCell, std::vector<double> my_voxel_center, std::vector<double> other_voxel_center, int other_voxel_index)
+Cell* find_cell_by_ID( int ID )
+{ return cell_pool.find_cell_by_ID( ID ); }
+
+bool is_neighbor_voxel(Cell* pCell, const std::vector<double>& my_voxel_center, const std::vector<double>& other_voxel_center, int other_voxel_index)
+{ return is_neighbor_voxel( pCell, my_voxel_center.data(), other_voxel_center.data(), other_voxel_index ); }
+
+bool is_neighbor_voxel(Cell* pCell, const double* my_voxel_center, const double* other_voxel_center, int other_voxel_index)
 {
 	double max_interactive_distance = pCell->phenotype.mechanics.relative_maximum_adhesion_distance * pCell->phenotype.geometry.radius 
-		+ pCell->get_container()->max_cell_interactive_distance_in_voxel[other_voxel_index];
+		+ pCell->get_container()->max_interaction_distance_in_voxel(other_voxel_index);
 	
 	int comparing_dimension = -1, comparing_dimension2 = -1;
 	if(my_voxel_center[0] == other_voxel_center[0] && my_voxel_center[1] == other_voxel_center[1])
@@ -1016,7 +1206,10 @@ bool is_neighbor_voxel(Cell* pCell, std::vector<double> my_voxel_center, std::ve
 		{ return false; }
 		return true;
 	}
-	std::vector<double> corner_point= 0.5*(my_voxel_center+other_voxel_center);
+	// corner point, without building temporary vectors 
+	double corner_point[3]; 
+	for( int i=0; i < 3 ; i++ )
+	{ corner_point[i] = 0.5*( my_voxel_center[i] + other_voxel_center[i] ); }
 	double distance_squared= (corner_point[0]-pCell->position[0])*(corner_point[0]-pCell->position[0])
 		+(corner_point[1]-pCell->position[1])*(corner_point[1]-pCell->position[1]) 
 		+(corner_point[2]-pCell->position[2]) * (corner_point[2]-pCell->position[2]);
@@ -1027,7 +1220,46 @@ bool is_neighbor_voxel(Cell* pCell, std::vector<double> my_voxel_center, std::ve
 
 std::vector<Cell*>& Cell::cells_in_my_container( void )
 {
-	return get_container()->agent_grid[get_current_mechanics_voxel_index()];
+	return get_container()->cells_in_voxel( get_current_mechanics_voxel_index() );
+}
+
+std::vector<Cell*> Cell::nearby_cells( void )
+{
+	std::vector<Cell*> neighbors; 
+	
+	Mechanics_Engine& engine = get_container()->mechanics_engine; 
+	if( engine.is_packed( this ) && engine.has_full_neighbor_lists() )
+	{
+		const std::vector<int>& list = engine.neighbor_list( this ); 
+		neighbors.reserve( list.size() ); 
+		for( unsigned int k=0; k < list.size() ; k++ )
+		{ neighbors.push_back( (*all_cells)[ list[k] ] ); }
+		return neighbors; 
+	}
+	
+	int voxel = get_current_mechanics_voxel_index(); 
+	std::vector<Cell*>& home = get_container()->cells_in_voxel(voxel); 
+	for( unsigned int k=0; k < home.size() ; k++ )
+	{
+		if( home[k] != this )
+		{ neighbors.push_back( home[k] ); }
+	}
+	int moore[26]; 
+	int number_of_neighbors = get_container()->moore_neighborhood( voxel , moore ); 
+	double center[3]; 
+	double other_center[3]; 
+	get_container()->underlying_mesh.voxel_center( voxel , center ); 
+	for( int m=0; m < number_of_neighbors ; m++ )
+	{
+		std::vector<Cell*>& other = get_container()->cells_in_voxel( moore[m] ); 
+		if( other.size() == 0 )
+		{ continue; }
+		get_container()->underlying_mesh.voxel_center( moore[m] , other_center ); 
+		if( !is_neighbor_voxel( this, center, other_center, moore[m] ) )
+		{ continue; }
+		neighbors.insert( neighbors.end() , other.begin() , other.end() ); 
+	}
+	return neighbors; 
 }
 
 void Cell::ingest_cell( Cell* pCell_to_eat )
@@ -135,6 +135,28 @@ class Cell_Definition
 
 extern Cell_Definition cell_defaults; 
 
+/* 
+ A reference to a cell that knows when the cell is gone (new in 1.7.2). Unlike 
+ a Cell* (which, once the cell is deleted, points to a reused cell) or an index 
+ (which changes as other cells are deleted), get() returns the cell as long as 
+ it lives, and NULL afterwards. A handle is the cell's slot in the cell_pool, 
+ and the number of times that slot had been released when the handle was made. 
+*/ 
+
+class Cell_Handle
+{
+ public:
+	int slot; 
+	unsigned int generation; 
+	
+	Cell_Handle(); // a handle to no cell 
+	
+	Cell* get( void ) const; // in O(1) 
+	bool is_stale( void ) const; 
+	
+	bool operator==( const Cell_Handle& other ) const; 
+}; 
+
 class Cell_State
 {
  public:
@@ -149,9 +171,17 @@ class Cell_State
 class Cell : public Basic_Agent 
 {
  private: 
+	friend class Cell_Container; // for the parallel rebuild of the agent grid 
+	
 	Cell_Container * container;
 	int current_mechanics_voxel_index;
 	int updated_current_mechanics_voxel_index; // keeps the updated voxel index for later adjusting of current voxel index
+	
+	friend class Cell_Pool; 
+	int pool_slot; // where this cell lives in the cell_pool -- 1.7.2 
+	
+	// the body of the constructor, shared with reset() 
+	void initialize_to_defaults( void ); 
 		
  public:
 	std::string type_name; 
@@ -173,6 +203,9 @@ class Cell : public Basic_Agent
 	
 	bool is_out_of_domain;
 	bool is_movable;
+	// the dt of the last update_position (0 before the first), for Adams-Bashforth 
+	// with variable steps -- 1.7.2 
+	double previous_mechanics_dt; 
 	
 	void flag_for_division( void ); // done 
 	void flag_for_removal( void ); // done 
@@ -181,13 +214,26 @@ class Cell : public Basic_Agent
 	void lyse_cell( void ); 
 
 	Cell* divide( void );
+	// the part of divide() that only changes this cell and the child: copies 
+	// the data, places the child along direction (a unit vector), and splits 
+	// the volume. The caller registers the child's position (assign_position) 
+	// and updates this cell's voxel. -- 1.7.2 
+	void divide_into( Cell* child , std::vector<double>& direction ); 
 	void die( void );
 	void step(double dt);
 	Cell();
+	// return a deleted cell to the state of a new one (see Cell_Pool) -- 1.7.2 
+	void reset( void ); 
+	// a handle that detects when this cell is deleted -- 1.7.2 
+	Cell_Handle get_handle( void ) const; 
 	
 	bool assign_position(std::vector<double> new_position);
 	bool assign_position(double, double, double);
 	void set_total_volume(double);
+	// the two halves of set_total_volume: the cell's own volumes and geometry, 
+	// and the container's interaction distance in the cell's voxel -- 1.7.2 
+	void set_total_volume_of_cell( double volume ); 
+	void update_interaction_distance_in_voxel( void ); 
 	
 	double& get_total_volume(void); // NEW
 	
@@ -220,20 +266,79 @@ class Cell : public Basic_Agent
 	Cell_Container * get_container();
 	
 	std::vector<Cell*>& cells_in_my_container( void ); 
+	// every other cell that may be in mechanical contact with this one: its Verlet 
+	// list during the mechanics step, the nearby mechanics voxels otherwise -- 1.7.2 
+	std::vector<Cell*> nearby_cells( void ); 
 	
 	void convert_to_cell_definition( Cell_Definition& cd ); 
 };
 
+/* 
+ The storage for all cells (new in 1.7.2). Cells are built in slabs of 
+ cells_per_slab, rather than allocated one by one, and deleted cells are kept 
+ for reuse (with the memory of all their vectors) rather than freed: 
+ allocate() resets a kept cell if there is one, and only builds a new cell 
+ in the next free slot otherwise. create_cell() and delete_cell() go 
+ through the global cell_pool; cells must not be created with new or freed 
+ with delete. 
+*/ 
+
+class Cell_Pool
+{
+ private:
+	int cells_per_slab; 
+	std::vector<Cell*> slabs; 
+	int used_in_last_slab; 
+	std::vector<Cell*> free_cells; 
+	int live; 
+	
+	// how many times each slot was released 
+	std::vector<unsigned int> generations; 
+	// the slots of the registered (live) cells, by ID 
+	std::unordered_map<int,int> slots_by_ID; 
+	
+ public:
+	Cell_Pool(); 
+	
+	// a cell in the state of a new Cell(). Safe to call from several threads. 
+	Cell* allocate( void ); 
+	// keep pCell for reuse. Any handles to it become stale. 
+	void release( Cell* pCell ); 
+	
+	// make pCell findable by its ID, once the ID is final. create_cell does 
+	// this; release undoes it. 
+	void register_ID( Cell* pCell ); 
+	// the live cell with this ID, or NULL 
+	Cell* find_cell_by_ID( int ID ) const; 
+	
+	Cell_Handle get_handle( const Cell* pCell ) const; 
+	// the cell of the handle, or NULL if it was released since 
+	Cell* resolve( const Cell_Handle& handle ) const; 
+	
+	// cells in use, and cells that can be in use without allocating 
+	// another slab 
+	int live_cells( void ) const; 
+	int reserved_cells( void ) const; 
+	// the memory of the slabs (not counting the cells' vectors) 
+	double reserved_megabytes( void ) const; 
+	void display( std::ostream& os ) const; 
+};
+
+extern Cell_Pool cell_pool; 
+
 Cell* create_cell( void );  
 Cell* create_cell( Cell_Definition& cd );  
 
 
 void delete_cell( int ); 
 void delete_cell( Cell* ); 
+// the live cell with this ID, or NULL, in O(1) (see Cell_Pool) -- 1.7.2 
+Cell* find_cell_by_ID( int ID ); 
 void save_all_cells_to_matlab( std::string filename ); 
 
 //function to check if a neighbor voxel contains any cell that can interact with me
-bool is_neighbor_voxel(Cell* pCell, std::vector<double> myVoxelCenter, std::vector<double> otherVoxelCenter, int otherVoxelIndex);  
+bool is_neighbor_voxel(Cell* pCell, const std::vector<double>& myVoxelCenter, const std::vector<double>& otherVoxelCenter, int otherVoxelIndex);  
+bool is_neighbor_voxel(Cell* pCell, const double* myVoxelCenter, const double* otherVoxelCenter, int otherVoxelIndex); // 1.7.2 
 
 
 extern std::unordered_map<std::string,Cell_Definition*> cell_definitions_by_name; 
@@ -65,6 +65,8 @@
 ###############################################################################
 */
 
+#include <algorithm>
+
 #include "../BioFVM/BioFVM_agent_container.h"
 #include "PhysiCell_constants.h"
 #include "../BioFVM/BioFVM_vector.h"
@@ -75,9 +77,20 @@ using namespace BioFVM;
 namespace PhysiCell{
 
 std::vector<Cell*> *all_cells;
+bool batched_divisions = false; 
+bool hashed_cell_container = false; 
+bool implicit_mechanics_mesh = false; 
+
+Occupied_Voxel::Occupied_Voxel()
+{
+	cells.resize(0); 
+	max_cell_interactive_distance = 0.0; 
+	return; 
+}
 
 Cell_Container::Cell_Container()
 {
+	hashed = false; 
 	all_cells = (std::vector<Cell*> *) &all_basic_agents;	
 	boundary_condition_for_pushed_out_agents= PhysiCell_constants::default_boundary_condition_for_pushed_out_agents;
 	std::vector<Cell*> cells_ready_to_divide;
@@ -100,9 +113,20 @@ void Cell_Container::initialize(double x_start, double x_end, double y_start, do
 	std::vector<Cell*> cells_ready_to_divide;
 	std::vector<Cell*> cells_ready_to_die;
 
+	// a hashed grid never stores anything per voxel, so neither does its mesh 
+	hashed = hashed_cell_container; 
+	underlying_mesh.implicit_voxels = hashed || implicit_mechanics_mesh; 
 	underlying_mesh.resize(x_start, x_end, y_start, y_end, z_start, z_end , dx, dy, dz);
-	agent_grid.resize(underlying_mesh.voxels.size());
-	max_cell_interactive_distance_in_voxel.resize(underlying_mesh.voxels.size(), 0.0);
+	if( hashed )
+	{
+		// the occupied voxels are added as cells arrive 
+		occupied_voxels.clear(); 
+	}
+	else
+	{
+		agent_grid.resize(underlying_mesh.number_of_voxels());
+		max_cell_interactive_distance_in_voxel.resize(underlying_mesh.number_of_voxels(), 0.0);
+	}
 	agents_in_outer_voxels.resize(6);
 	
 	return; 
@@ -145,7 +169,7 @@ void Cell_Container::update_all_cells(double t, double phenotype_dt_ , double me
 	{
 		// Reset the max_radius in each voxel. It will be filled in set_total_volume
 		// It might be better if we calculate it before mechanics each time 
-		std::fill(max_cell_interactive_distance_in_voxel.begin(), max_cell_interactive_distance_in_voxel.end(), 0.0);
+		reset_interaction_distances(); 
 		
 		if(!initialzed)
 		{
@@ -177,10 +201,7 @@ void Cell_Container::update_all_cells(double t, double phenotype_dt_ , double me
 		}
 		
 		// process divides / removes 
-		for( int i=0; i < cells_ready_to_divide.size(); i++ )
-		{
-			cells_ready_to_divide[i]->divide();
-		}
+		divide_flagged_cells(); 
 		for( int i=0; i < cells_ready_to_die.size(); i++ )
 		{	
 			cells_ready_to_die[i]->die();	
@@ -241,49 +262,84 @@ void Cell_Container::update_all_cells(double t, double phenotype_dt_ , double me
 	return;
 }
 
+void Cell_Container::register_stages( double phenotype_dt_ , double mechanics_dt_ , double diffusion_dt_ )
+{
+	// stages the settings registered first (with their offsets) are kept 
+	secretion_stage = step_scheduler.register_stage( "secretion" , diffusion_dt_ ); 
+	phenotype_stage = step_scheduler.register_stage( "phenotype" , phenotype_dt_ ); 
+	mechanics_stage = step_scheduler.register_stage( "mechanics" , mechanics_dt_ ); 
+	// gradients and custom rules run with the mechanics (same offset, and 
+	// update_all_cells gives them its period) 
+	double mechanics_offset = step_scheduler[mechanics_stage].offset; 
+	gradient_stage = step_scheduler.register_stage( "gradients" , mechanics_dt_ , mechanics_offset ); 
+	custom_rule_stage = step_scheduler.register_stage( "custom rules" , mechanics_dt_ , mechanics_offset ); 
+	
+	return; 
+}
+
 void Cell_Container::update_all_cells(double t, double phenotype_dt_ , double mechanics_dt_ , double diffusion_dt_ )
 {
+	// the stages run on integer ticks of diffusion_dt, so that round-off in t 
+	// cannot skip or repeat a step (replaces the 0.001*dt tolerances -- 1.7.2) 
+	step_scheduler.set_tick_length( diffusion_dt_ ); 
+	if( mechanics_stage < 0 )
+	{ register_stages( phenotype_dt_ , mechanics_dt_ , diffusion_dt_ ); }
+	
+	// the adaptive step can be longer than mechanics_dt -- 1.7.2 
+	if( current_mechanics_dt <= 0.0 || !default_mechanics_options.adaptive_mechanics_dt )
+	{ current_mechanics_dt = mechanics_dt_; }
+	step_scheduler.set_period( secretion_stage , diffusion_dt_ ); 
+	step_scheduler.set_period( phenotype_stage , phenotype_dt_ ); 
+	step_scheduler.set_period( mechanics_stage , current_mechanics_dt ); 
+	step_scheduler.set_period( gradient_stage , current_mechanics_dt ); 
+	step_scheduler.set_period( custom_rule_stage , current_mechanics_dt ); 
+	
 	// secretions and uptakes. Syncing with BioFVM is automated. 
-
-	#pragma omp parallel for 
-	for( int i=0; i < (*all_cells).size(); i++ )
+	if( step_scheduler.is_due( secretion_stage , t ) )
 	{
-		(*all_cells)[i]->phenotype.secretion.advance( (*all_cells)[i], (*all_cells)[i]->phenotype , diffusion_dt_ );
+		double secretion_dt = step_scheduler.start( secretion_stage , t ); 
+		#pragma omp parallel for 
+		for( int i=0; i < (*all_cells).size(); i++ )
+		{
+			(*all_cells)[i]->phenotype.secretion.advance( (*all_cells)[i], (*all_cells)[i]->phenotype , secretion_dt );
+		}
 	}
 	
 	//if it is the time for running cell cycle, do it!
-	double time_since_last_cycle= t- last_cell_cycle_time;
-
-	static double phenotype_dt_tolerance = 0.001 * phenotype_dt_; 
-	static double mechanics_dt_tolerance = 0.001 * mechanics_dt_; 
-	
-	if( fabs(time_since_last_cycle-phenotype_dt_ ) < phenotype_dt_tolerance || !initialzed)
+	if( step_scheduler.is_due( phenotype_stage , t ) )
 	{
+		double time_since_last_cycle = step_scheduler.start( phenotype_stage , t ); 
+		
 		// Reset the max_radius in each voxel. It will be filled in set_total_volume
 		// It might be better if we calculate it before mechanics each time 
-		std::fill(max_cell_interactive_distance_in_voxel.begin(), max_cell_interactive_distance_in_voxel.end(), 0.0);
-		
-		if(!initialzed)
-		{
-			time_since_last_cycle = phenotype_dt_;
-		}
+		reset_interaction_distances(); 
 		
 		// new as of 1.2.1 -- bundles cell phenotype parameter update, volume update, geometry update, 
 		// checking for death, and advancing the cell cycle. Not motility, though. (that's in mechanics)
+		// Each cell draws from its own random stream (1.7.2). 
+		advance_random_step(); 
 		#pragma omp parallel for 
 		for( int i=0; i < (*all_cells).size(); i++ )
 		{
 			if( (*all_cells)[i]->is_out_of_domain == false )
 			{
+				key_random_stream( (*all_cells)[i]->ID ); 
 				(*all_cells)[i]->advance_bundled_phenotype_functions( time_since_last_cycle ); 
 			}
 		}
 		
-		// process divides / removes 
-		for( int i=0; i < cells_ready_to_divide.size(); i++ )
+		// process divides / removes. The threads flag the cells in any order: 
+		// with counter-based random numbers, process them in the order of 
+		// all_cells, so that the new cells' IDs (which key their random streams) 
+		// do not depend on the threads -- 1.7.2 
+		if( counter_based_random_numbers )
 		{
-			cells_ready_to_divide[i]->divide();
+			std::sort( cells_ready_to_divide.begin() , cells_ready_to_divide.end() , 
+				[]( Cell* a , Cell* b ){ return a->index < b->index; } ); 
+			std::sort( cells_ready_to_die.begin() , cells_ready_to_die.end() , 
+				[]( Cell* a , Cell* b ){ return a->index < b->index; } ); 
 		}
+		divide_flagged_cells(); 
 		for( int i=0; i < cells_ready_to_die.size(); i++ )
 		{	
 			cells_ready_to_die[i]->die();	
@@ -295,24 +351,38 @@ void Cell_Container::update_all_cells(double t, double phenotype_dt_ , double me
 		cells_ready_to_divide.clear();
 		last_cell_cycle_time= t;
 	}
-		
-	double time_since_last_mechanics= t- last_mechanics_time;
 	
-	// if( time_since_last_mechanics>= mechanics_dt || !initialzed)
-	if( fabs(time_since_last_mechanics - mechanics_dt_) < mechanics_dt_tolerance || !initialzed)
+	// new February 2018 
+	// if we need gradients, compute them (on demand, for the voxels that 
+	// cells read them from -- 1.7.2) 
+	if( step_scheduler.is_due( gradient_stage , t ) )
 	{
-		if(!initialzed)
+		step_scheduler.start( gradient_stage , t ); 
+		if( default_microenvironment_options.calculate_gradients ) 
+		{ microenvironment.reset_all_gradient_vectors();  }
+	}
+	// end of new in Feb 2018 		
+	
+	bool mechanics_is_due = step_scheduler.is_due( mechanics_stage , t ); 
+	double time_since_last_mechanics = 0.0; 
+	if( mechanics_is_due )
+	{
+		time_since_last_mechanics = step_scheduler.start( mechanics_stage , t ); 
+		
+		// keep cells that are near in space near in memory -- 1.7.2 
+		if( default_mechanics_options.reorder_interval > 0 && 
+			++mechanics_steps_since_reorder >= default_mechanics_options.reorder_interval )
 		{
-			time_since_last_mechanics = mechanics_dt_;
+			reorder_all_cells(); 
+			mechanics_steps_since_reorder = 0; 
 		}
 		
-		// new February 2018 
-		// if we need gradients, compute them
-		if( default_microenvironment_options.calculate_gradients ) 
-		{ microenvironment.compute_all_gradient_vectors();  }
-		// end of new in Feb 2018 		
+		// pack the data for the cell-cell potentials -- 1.7.2 
+		if( default_mechanics_options.use_packed_mechanics )
+		{ mechanics_engine.pack( *this , *all_cells ); }
 		
 		// Compute velocities
+		advance_random_step(); 
 		#pragma omp parallel for 
 		for( int i=0; i < (*all_cells).size(); i++ )
 		{
@@ -321,14 +391,46 @@ void Cell_Container::update_all_cells(double t, double phenotype_dt_ , double me
 			{
 				// update_velocity already includes the motility update 
 				//(*all_cells)[i]->phenotype.motility.update_motility_vector( (*all_cells)[i] ,(*all_cells)[i]->phenotype , time_since_last_mechanics ); 
+				key_random_stream( (*all_cells)[i]->ID ); 
 				(*all_cells)[i]->functions.update_velocity( (*all_cells)[i], (*all_cells)[i]->phenotype, time_since_last_mechanics);
 			}
-
+		}
+	}
+	
+	// custom rules, after the velocities (their own stage -- 1.7.2). The 
+	// packed mechanics data is kept until after them, so that their neighbor 
+	// queries (Cell::nearby_cells) can use its interaction lists. 
+	if( step_scheduler.is_due( custom_rule_stage , t ) )
+	{
+		double custom_rule_dt = step_scheduler.start( custom_rule_stage , t ); 
+		advance_random_step(); 
+		#pragma omp parallel for 
+		for( int i=0; i < (*all_cells).size(); i++ )
+		{
 			if( (*all_cells)[i]->functions.custom_cell_rule )
 			{
-				(*all_cells)[i]->functions.custom_cell_rule((*all_cells)[i], (*all_cells)[i]->phenotype, time_since_last_mechanics);
+				key_random_stream( (*all_cells)[i]->ID ); 
+				(*all_cells)[i]->functions.custom_cell_rule((*all_cells)[i], (*all_cells)[i]->phenotype, custom_rule_dt);
 			}
 		}
+	}
+	
+	if( mechanics_is_due )
+	{
+		mechanics_engine.release(); 
+		
+		// record this step, and pick the next one from the new velocities -- 1.7.2 
+		if( mechanics_steps_in_interval == 0 )
+		{
+			min_mechanics_dt_in_interval = time_since_last_mechanics; 
+			max_mechanics_dt_in_interval = time_since_last_mechanics; 
+		}
+		min_mechanics_dt_in_interval = std::min( min_mechanics_dt_in_interval , time_since_last_mechanics ); 
+		max_mechanics_dt_in_interval = std::max( max_mechanics_dt_in_interval , time_since_last_mechanics ); 
+		mechanics_steps_in_interval++; 
+		if( default_mechanics_options.adaptive_mechanics_dt )
+		{ current_mechanics_dt = choose_mechanics_dt( time_since_last_mechanics , mechanics_dt_ , diffusion_dt_ ); }
+		
 		// Calculate new positions
 		#pragma omp parallel for 
 		for( int i=0; i < (*all_cells).size(); i++ )
@@ -339,22 +441,280 @@ void Cell_Container::update_all_cells(double t, double phenotype_dt_ , double me
 			}
 		}
 		
-		// When somebody reviews this code, let's add proper braces for clarity!!! 
-		
-		// Update cell indices in the container
-		for( int i=0; i < (*all_cells).size(); i++ )
-			if(!(*all_cells)[i]->is_out_of_domain && (*all_cells)[i]->is_movable)
-				(*all_cells)[i]->update_voxel_in_container();
+		// Update cell indices in the container (in parallel -- 1.7.2) 
+		rebuild_agent_grid(); 
 		last_mechanics_time=t;
 	}
 	
+	// stages that projects registered with a function -- 1.7.2 
+	step_scheduler.run_due_functions( t ); 
+	
 	initialzed=true;
 	return;
 }
 
+double Cell_Container::choose_mechanics_dt( double last_dt , double mechanics_dt_ , double diffusion_dt_ )
+{
+	// how fast the cells move, in radii per unit time 
+	double rate = 0.0; 
+	int n = (*all_cells).size(); 
+	#pragma omp parallel for reduction(max:rate)
+	for( int i=0; i < n ; i++ )
+	{
+		Cell* pCell = (*all_cells)[i]; 
+		double radius = pCell->phenotype.geometry.radius; 
+		if( pCell->is_out_of_domain || !pCell->is_movable || radius <= 0.0 )
+		{ continue; }
+		// (update_position drops the z velocity in 2-D) 
+		std::vector<double>& v = pCell->velocity; 
+		double speed_squared = v[0]*v[0] + v[1]*v[1]; 
+		if( default_microenvironment_options.simulate_2D == false )
+		{ speed_squared += v[2]*v[2]; }
+		rate = std::max( rate , sqrt( speed_squared ) / radius ); 
+	}
+	
+	double dt = std::min( default_mechanics_options.max_mechanics_dt , 2.0 * last_dt ); 
+	if( rate > 0.0 )
+	{ dt = std::min( dt , default_mechanics_options.max_relative_displacement / rate ); }
+	dt = diffusion_dt_ * floor( dt / diffusion_dt_ + 1e-6 ); 
+	
+	return std::max( dt , mechanics_dt_ ); 
+}
+
+void Cell_Container::rebuild_agent_grid( void )
+{
+	int n = (*all_cells).size(); 
+	old_voxel_indices.resize( n ); 
+	new_voxel_indices.resize( n ); 
+	leaving_domain.assign( n , 0 ); 
+	
+	// find the new voxels. Cells that left the domain are handled below, as before. 
+	#pragma omp parallel for 
+	for( int i=0; i < n ; i++ )
+	{
+		Cell* pCell = (*all_cells)[i]; 
+		old_voxel_indices[i] = pCell->current_mechanics_voxel_index; 
+		if( !pCell->is_out_of_domain && pCell->is_movable )
+		{
+			if( pCell->updated_current_mechanics_voxel_index == -1 )
+			{ leaving_domain[i] = 1; }
+			else
+			{
+				pCell->update_voxel_index(); 
+				pCell->current_mechanics_voxel_index = pCell->updated_current_mechanics_voxel_index; 
+			}
+		}
+		new_voxel_indices[i] = pCell->current_mechanics_voxel_index; 
+	}
+	
+	// the cells that changed voxels, sorted by their old and by their new voxels 
+	moved_from.clear(); 
+	moved_to.clear(); 
+	for( int i=0; i < n ; i++ )
+	{
+		if( leaving_domain[i] )
+		{
+			(*all_cells)[i]->update_voxel_in_container(); 
+			continue; 
+		}
+		if( new_voxel_indices[i] != old_voxel_indices[i] )
+		{
+			moved_from.push_back( std::make_pair( old_voxel_indices[i] , i ) ); 
+			moved_to.push_back( std::make_pair( new_voxel_indices[i] , i ) ); 
+		}
+	}
+	std::sort( moved_from.begin() , moved_from.end() ); 
+	std::sort( moved_to.begin() , moved_to.end() ); 
+	
+	// a hashed grid adds the newly occupied voxels first, so that the threads 
+	// below only change existing voxels 
+	int number_moved = moved_from.size(); 
+	if( hashed )
+	{
+		for( int k=0; k < number_moved ; k++ )
+		{ occupied_voxels[ moved_to[k].first ]; }
+	}
+	
+	// each voxel is changed by one thread: first drop the cells that left it ... 
+	#pragma omp parallel for schedule(dynamic,64)
+	for( int k=0; k < number_moved ; k++ )
+	{
+		int v = moved_from[k].first; 
+		if( k > 0 && moved_from[k-1].first == v )
+		{ continue; }
+		std::vector<Cell*>& voxel = cells_in_voxel(v); 
+		int kept = 0; 
+		for( unsigned int m=0; m < voxel.size() ; m++ )
+		{
+			if( voxel[m]->current_mechanics_voxel_index == v )
+			{ voxel[kept++] = voxel[m]; }
+		}
+		voxel.resize( kept ); 
+	}
+	// ... then add the cells that arrived 
+	#pragma omp parallel for schedule(dynamic,64)
+	for( int k=0; k < number_moved ; k++ )
+	{
+		int v = moved_to[k].first; 
+		if( k > 0 && moved_to[k-1].first == v )
+		{ continue; }
+		std::vector<Cell*>& voxel = cells_in_voxel(v); 
+		for( int m=k; m < number_moved && moved_to[m].first == v ; m++ )
+		{ voxel.push_back( (*all_cells)[ moved_to[m].second ] ); }
+	}
+	
+	// and forgets the voxels that were emptied 
+	if( hashed )
+	{
+		for( int k=0; k < number_moved ; k++ )
+		{
+			std::unordered_map<int,Occupied_Voxel>::iterator search = occupied_voxels.find( moved_from[k].first ); 
+			if( search != occupied_voxels.end() && search->second.cells.size() == 0 )
+			{ occupied_voxels.erase( search ); }
+		}
+	}
+	
+	return; 
+}
+
+// spread the lowest 21 bits of i so that there are two zero bits between each 
+static inline unsigned long long spread_bits_by_3( unsigned int i )
+{
+	unsigned long long x = i & 0x1fffff; 
+	x = ( x | x << 32 ) & 0x1f00000000ffffULL; 
+	x = ( x | x << 16 ) & 0x1f0000ff0000ffULL; 
+	x = ( x | x << 8 ) & 0x100f00f00f00f00fULL; 
+	x = ( x | x << 4 ) & 0x10c30c30c30c30c3ULL; 
+	x = ( x | x << 2 ) & 0x1249249249249249ULL; 
+	return x; 
+}
+
+void Cell_Container::divide_flagged_cells( void )
+{
+	int k = cells_ready_to_divide.size(); 
+	if( batched_divisions == false || k < 2 )
+	{
+		for( int i=0; i < k; i++ )
+		{
+			cells_ready_to_divide[i]->divide();
+		}
+		return; 
+	}
+	
+	// the cells are flagged in whatever order the threads got there; divide 
+	// them in the order of all_cells, so that the children's slots and IDs 
+	// do not depend on the threads 
+	std::sort( cells_ready_to_divide.begin() , cells_ready_to_divide.end() , 
+		[]( Cell* a , Cell* b ){ return a->index < b->index; } ); 
+	
+	prepare_thread_random_generators(); 
+	advance_random_step(); 
+	int n = (*all_cells).size(); 
+	(*all_cells).resize( n + k , NULL ); 
+	division_IDs.resize( k ); 
+	
+	Microenvironment* pMicroenvironment = BioFVM::get_default_microenvironment(); 
+	
+	// build the children. This only touches the parent and the child (and 
+	// the child's slot), not the agent grid. Static scheduling keeps the 
+	// random numbers of each division on the same thread from run to run 
+	// (and the counter-based streams key them by the parent). 
+	#pragma omp parallel for schedule(static) 
+	for( int i=0; i < k; i++ )
+	{
+		Cell* pParent = cells_ready_to_divide[i]; 
+		key_random_stream( pParent->ID ); 
+		
+		// as in create_cell() 
+		Cell* pChild = cell_pool.allocate(); 
+		(*all_cells)[n+i] = pChild; 
+		pChild->index = n+i; 
+		if( pMicroenvironment )
+		{ pChild->register_microenvironment( pMicroenvironment ); }
+		pChild->set_total_volume( pChild->phenotype.volume.total ); 
+		division_IDs[i] = pChild->ID; 
+		
+		std::vector<double> direction = cell_division_orientation(); 
+		pParent->divide_into( pChild , direction ); 
+		
+		pChild->update_voxel_index(); 
+		pChild->current_mechanics_voxel_index = 
+			underlying_mesh.nearest_voxel_index( pChild->position ); 
+	}
+	
+	// hand out the IDs in division order 
+	std::sort( division_IDs.begin() , division_IDs.end() ); 
+	for( int i=0; i < k; i++ )
+	{
+		(*all_cells)[n+i]->ID = division_IDs[i]; 
+		cell_pool.register_ID( (*all_cells)[n+i] ); 
+	}
+	
+	// register the children, and move the parents to their new voxels, as 
+	// Cell::divide() does 
+	for( int i=0; i < k; i++ )
+	{
+		Cell* pParent = cells_ready_to_divide[i]; 
+		Cell* pChild = (*all_cells)[n+i]; 
+		
+		register_agent( pChild ); 
+		if( !underlying_mesh.is_position_valid( pChild->position[0], pChild->position[1], pChild->position[2] ) )
+		{
+			pChild->is_out_of_domain = true; 
+			pChild->is_active = false; 
+			pChild->is_movable = false; 
+		}
+		pParent->update_voxel_in_container(); 
+		
+		pChild->update_interaction_distance_in_voxel(); 
+		pParent->update_interaction_distance_in_voxel(); 
+	}
+	
+	return; 
+}
+
+void Cell_Container::reorder_all_cells( void )
+{
+	int n = (*all_cells).size(); 
+	unsigned int nx = underlying_mesh.x_coordinates.size(); 
+	unsigned int ny = underlying_mesh.y_coordinates.size(); 
+	
+	// Morton keys of the mechanics voxels; cells outside the domain go last 
+	curve_keys.resize( n ); 
+	#pragma omp parallel for 
+	for( int i=0; i < n ; i++ )
+	{
+		int voxel = (*all_cells)[i]->current_mechanics_voxel_index; 
+		unsigned long long key = 0xffffffffffffffffULL; 
+		if( voxel >= 0 )
+		{
+			unsigned int vi = voxel % nx; 
+			unsigned int vj = ( voxel / nx ) % ny; 
+			unsigned int vk = voxel / ( nx * ny ); 
+			key = spread_bits_by_3( vi ) | ( spread_bits_by_3( vj ) << 1 ) | ( spread_bits_by_3( vk ) << 2 ); 
+		}
+		curve_keys[i] = std::make_pair( key , i ); 
+	}
+	// ties (cells in the same voxel) keep their current relative order 
+	std::sort( curve_keys.begin() , curve_keys.end() ); 
+	
+	reordered_cells.resize( n ); 
+	#pragma omp parallel for 
+	for( int i=0; i < n ; i++ )
+	{ reordered_cells[i] = (*all_cells)[ curve_keys[i].second ]; }
+	#pragma omp parallel for 
+	for( int i=0; i < n ; i++ )
+	{
+		(*all_cells)[i] = reordered_cells[i]; 
+		(*all_cells)[i]->index = i; 
+	}
+	
+	return; 
+}
+
 void Cell_Container::register_agent( Cell* agent )
 {
-	agent_grid[agent->get_current_mechanics_voxel_index()].push_back(agent);
+	add_agent_to_voxel( agent , agent->get_current_mechanics_voxel_index() ); 
 	return; 
 }
 
@@ -374,28 +734,144 @@ void Cell_Container::add_agent_to_outer_voxel(Cell* agent)
 
 void Cell_Container::remove_agent_from_voxel(Cell* agent, int voxel_index)
 {
+	std::vector<Cell*>& voxel = cells_in_voxel( voxel_index ); 
 	int delete_index = 0; 
-	while( agent_grid[voxel_index][ delete_index ] != agent )
+	while( voxel[ delete_index ] != agent )
 	{
 		delete_index++; 
 	}
 	// move last item to index location  
-	agent_grid[agent->get_current_mechanics_voxel_index()][delete_index] = agent_grid[agent->get_current_mechanics_voxel_index()][agent_grid[agent->get_current_mechanics_voxel_index()].size()-1 ]; 
+	voxel[delete_index] = voxel[voxel.size()-1 ]; 
 	// shrink the vector
-	agent_grid[agent->get_current_mechanics_voxel_index()].pop_back(); 
+	voxel.pop_back(); 
+	
+	// a hashed grid forgets empty voxels 
+	if( hashed && voxel.size() == 0 )
+	{ occupied_voxels.erase( voxel_index ); }
 	return; 
 }		
 
 void Cell_Container::add_agent_to_voxel(Cell* agent, int voxel_index)
 {
-	agent_grid[voxel_index].push_back(agent); 
+	if( hashed )
+	{ occupied_voxels[voxel_index].cells.push_back(agent); }
+	else
+	{ agent_grid[voxel_index].push_back(agent); }
 	return; 
 }	
 
 bool Cell_Container::contain_any_cell(int voxel_index)
 {
 	// Let's replace this with clearer statements. 
-	return agent_grid[voxel_index].size()==0?false:true;
+	return cells_in_voxel(voxel_index).size()==0?false:true;
+}
+
+bool Cell_Container::is_hashed( void ) const
+{ return hashed; }
+
+std::vector<Cell*>& Cell_Container::cells_in_voxel( int voxel_index )
+{
+	if( !hashed )
+	{ return agent_grid[voxel_index]; }
+	
+	std::unordered_map<int,Occupied_Voxel>::iterator search = occupied_voxels.find( voxel_index ); 
+	if( search == occupied_voxels.end() )
+	{ return no_cells; }
+	return search->second.cells; 
+}
+
+int Cell_Container::moore_neighborhood( int voxel_index , int* neighbors )
+{ return underlying_mesh.moore_neighbors( voxel_index , neighbors ); }
+
+void Cell_Container::get_occupied_voxels( std::vector<int>& voxels )
+{
+	voxels.clear(); 
+	if( hashed )
+	{
+		voxels.reserve( occupied_voxels.size() ); 
+		for( std::unordered_map<int,Occupied_Voxel>::iterator it = occupied_voxels.begin(); it != occupied_voxels.end() ; ++it )
+		{ voxels.push_back( it->first ); }
+		std::sort( voxels.begin() , voxels.end() ); 
+		return; 
+	}
+	for( unsigned int v=0; v < agent_grid.size() ; v++ )
+	{
+		if( agent_grid[v].size() > 0 )
+		{ voxels.push_back( v ); }
+	}
+	return; 
+}
+
+double Cell_Container::max_interaction_distance_in_voxel( int voxel_index )
+{
+	if( !hashed )
+	{ return max_cell_interactive_distance_in_voxel[voxel_index]; }
+	
+	std::unordered_map<int,Occupied_Voxel>::iterator search = occupied_voxels.find( voxel_index ); 
+	if( search == occupied_voxels.end() )
+	{ return 0.0; }
+	return search->second.max_cell_interactive_distance; 
+}
+
+void Cell_Container::record_interaction_distance( int voxel_index , double distance )
+{
+	double* pRecord = NULL; 
+	if( !hashed )
+	{ pRecord = &( max_cell_interactive_distance_in_voxel[voxel_index] ); }
+	else
+	{
+		std::unordered_map<int,Occupied_Voxel>::iterator search = occupied_voxels.find( voxel_index ); 
+		if( search == occupied_voxels.end() )
+		{ return; }
+		pRecord = &( search->second.max_cell_interactive_distance ); 
+	}
+	
+	if( *pRecord < distance )
+	{ *pRecord = distance; }
+	return; 
+}
+
+void Cell_Container::reset_interaction_distances( void )
+{
+	if( !hashed )
+	{
+		std::fill(max_cell_interactive_distance_in_voxel.begin(), max_cell_interactive_distance_in_voxel.end(), 0.0);
+		return; 
+	}
+	for( std::unordered_map<int,Occupied_Voxel>::iterator it = occupied_voxels.begin(); it != occupied_voxels.end() ; ++it )
+	{ it->second.max_cell_interactive_distance = 0.0; }
+	return; 
+}
+
+double Cell_Container::memory_footprint_megabytes( void )
+{
+	double bytes = 0.0; 
+	if( hashed )
+	{
+		// each entry is a node (with a pointer to the next, and its hash) 
+		bytes += occupied_voxels.bucket_count() * sizeof(void*); 
+		bytes += occupied_voxels.size() * ( sizeof( std::pair<const int,Occupied_Voxel> ) + 2*sizeof(void*) ); 
+		for( std::unordered_map<int,Occupied_Voxel>::iterator it = occupied_voxels.begin(); it != occupied_voxels.end() ; ++it )
+		{ bytes += it->second.cells.capacity() * sizeof(Cell*); }
+	}
+	else
+	{
+		bytes += agent_grid.capacity() * sizeof( std::vector<Cell*> ); 
+		for( unsigned int v=0; v < agent_grid.size() ; v++ )
+		{ bytes += agent_grid[v].capacity() * sizeof(Cell*); }
+		bytes += max_cell_interactive_distance_in_voxel.capacity() * sizeof(double); 
+	}
+	
+	return bytes / ( 1024.0 * 1024.0 ) + underlying_mesh.memory_footprint_megabytes(); 
+}
+
+void Cell_Container::display_memory_footprint( std::ostream& os )
+{
+	os << "cell container: " << ( hashed ? "hashed, " : "dense, " ); 
+	if( hashed )
+	{ os << occupied_voxels.size() << " of "; }
+	os << underlying_mesh.number_of_voxels() << " voxels, " << memory_footprint_megabytes() << " MB" << std::endl; 
+	return; 
 }
 
 int find_escaping_face_index(Cell* agent)
@@ -69,7 +69,10 @@
 #define __PhysiCell_cell_container_h__
 
 #include <vector>
+#include <unordered_map>
 #include "PhysiCell_cell.h"
+#include "PhysiCell_mechanics.h"
+#include "PhysiCell_scheduler.h"
 #include "../BioFVM/BioFVM_agent_container.h"
 #include "../BioFVM/BioFVM_mesh.h"
 #include "../BioFVM/BioFVM_microenvironment.h"
@@ -78,6 +81,31 @@ namespace PhysiCell{
 
 class Cell; 
 
+// a mechanics voxel that holds cells, in a hashed agent grid -- 1.7.2 
+class Occupied_Voxel
+{
+ public:
+	std::vector<Cell*> cells; 
+	double max_cell_interactive_distance; 
+	
+	Occupied_Voxel(); 
+};
+
+/* 
+ The agent grid lists the cells in each mechanics voxel. By default it is dense: 
+ agent_grid and max_cell_interactive_distance_in_voxel have one entry per voxel, 
+ and the Moore neighborhoods come from the mesh. For large, sparsely populated 
+ domains, a hashed container (see hashed_cell_container) only stores the 
+ occupied voxels, in a hash table keyed by voxel index, over an implicit mesh 
+ that computes the Moore neighborhoods from the voxels' (i,j,k) indices. 
+ (new in 1.7.2) 
+ 
+ Code that should work with both goes through cells_in_voxel, 
+ moore_neighborhood, and the interaction distance functions below. Only 
+ serial code may add or remove cells: in a hashed grid, that can add or erase 
+ voxels. 
+*/
+
 class Cell_Container : public BioFVM::Agent_Container
 {
  private:	
@@ -86,6 +114,35 @@ class Cell_Container : public BioFVM::Agent_Container
 	int boundary_condition_for_pushed_out_agents; 	// what to do with pushed out cells
 	bool initialzed = false;
 	
+	// scratch space for rebuild_agent_grid: each cell's old and new voxels, and 
+	// the (voxel, all_cells index) pairs of the cells that moved -- 1.7.2 
+	std::vector<int> old_voxel_indices; 
+	std::vector<int> new_voxel_indices; 
+	std::vector<char> leaving_domain; 
+	std::vector< std::pair<int,int> > moved_from; 
+	std::vector< std::pair<int,int> > moved_to; 
+	
+	// for reorder_all_cells -- 1.7.2 
+	std::vector< std::pair<unsigned long long,int> > curve_keys; 
+	std::vector<Cell*> reordered_cells; 
+	int mechanics_steps_since_reorder = 0; 
+	// scratch space for divide_flagged_cells 
+	std::vector<int> division_IDs; 
+	
+	// the hashed agent grid -- 1.7.2 
+	bool hashed; 
+	std::unordered_map<int,Occupied_Voxel> occupied_voxels; 
+	// what cells_in_voxel returns for empty voxels of a hashed grid 
+	std::vector<Cell*> no_cells; 
+	
+	// the stages of update_all_cells in step_scheduler -- 1.7.2 
+	int secretion_stage = -1; 
+	int phenotype_stage = -1; 
+	int gradient_stage = -1; 
+	int mechanics_stage = -1; 
+	int custom_rule_stage = -1; 
+	void register_stages( double phenotype_dt_ , double mechanics_dt_ , double diffusion_dt_ ); 
+	
  public:
 	BioFVM::Cartesian_Mesh underlying_mesh;
 	std::vector<double> max_cell_interactive_distance_in_voxel;
@@ -95,12 +152,24 @@ class Cell_Container : public BioFVM::Agent_Container
 	double last_diffusion_time  = 0.0; 
 	double last_cell_cycle_time = 0.0;
 	double last_mechanics_time  = 0.0;
+	
+	// the current mechanics step: mechanics_dt, or the last choice of 
+	// choose_mechanics_dt if the step is adaptive -- 1.7.2 
+	double current_mechanics_dt = 0.0; 
+	// the mechanics steps taken since the last status report, and their range 
+	int mechanics_steps_in_interval = 0; 
+	double min_mechanics_dt_in_interval = 0.0; 
+	double max_mechanics_dt_in_interval = 0.0; 
+	
 	Cell_Container();
  	void initialize(double x_start, double x_end, double y_start, double y_end, double z_start, double z_end , double voxel_size);
 	void initialize(double x_start, double x_end, double y_start, double y_end, double z_start, double z_end , double dx, double dy, double dz);
 	std::vector<std::vector<Cell*> > agent_grid;
 	std::vector<std::vector<Cell*> > agents_in_outer_voxels;
 	
+	// packed cell data for the cell-cell potentials -- 1.7.2 
+	Mechanics_Engine mechanics_engine; 
+	
 	void update_all_cells(double t);
 	void update_all_cells(double t, double dt);
 	void update_all_cells(double t, double phenotype_dt, double mechanics_dt);
@@ -112,13 +181,65 @@ class Cell_Container : public BioFVM::Agent_Container
 	void remove_agent_from_voxel(Cell* agent, int voxel_index);
 	void add_agent_to_voxel(Cell* agent, int voxel_index);
 	
+	// after update_position: move every cell to its new mechanics voxel. The 
+	// voxels are found in parallel, and the cells that changed voxels are 
+	// sorted by voxel, so that each voxel of agent_grid is updated by one 
+	// thread. Replaces calling update_voxel_in_container() on each cell. -- 1.7.2 
+	void rebuild_agent_grid( void ); 
+	
+	// sort all_cells by the Morton order of their mechanics voxels, and reset 
+	// each Basic_Agent::index. The cells themselves do not move, so Cell* 
+	// pointers stay valid. -- 1.7.2 
+	void reorder_all_cells( void ); 
+	
+	// divide every cell in cells_ready_to_divide. With batched_divisions, the 
+	// children are built in parallel (each thread drawing from its own random 
+	// generator) into slots reserved at the end of all_cells, and then 
+	// registered in the agent grid in one serial pass. -- 1.7.2 
+	void divide_flagged_cells( void ); 
+	
+	// after the velocities are computed: the next mechanics step, as long as 
+	// the fastest cell (relative to its radius) moves max_relative_displacement 
+	// of its radius, at most twice the last step, and bounded by mechanics_dt 
+	// and max_mechanics_dt. Rounded down to a multiple of diffusion_dt, since 
+	// update_all_cells runs once per diffusion step. -- 1.7.2 
+	double choose_mechanics_dt( double last_dt , double mechanics_dt_ , double diffusion_dt_ ); 
+	
 	void flag_cell_for_division( Cell* pCell ); 
 	void flag_cell_for_removal( Cell* pCell ); 
 	bool contain_any_cell(int voxel_index);
+	
+	// access to the agent grid, dense or hashed -- 1.7.2 
+	bool is_hashed( void ) const; 
+	// the cells in the voxel (an empty list, which must not be changed, if a 
+	// hashed grid does not hold the voxel) 
+	std::vector<Cell*>& cells_in_voxel( int voxel_index ); 
+	// writes the voxels in the Moore neighborhood of voxel_index (at most 26) 
+	// to neighbors, and returns how many there are 
+	int moore_neighborhood( int voxel_index , int* neighbors ); 
+	// the voxels that hold cells, in increasing order 
+	void get_occupied_voxels( std::vector<int>& voxels ); 
+	// the largest interaction distance of the cells in a voxel. The record can 
+	// be updated in parallel (it only changes voxels that hold cells). 
+	double max_interaction_distance_in_voxel( int voxel_index ); 
+	void record_interaction_distance( int voxel_index , double distance ); 
+	void reset_interaction_distances( void ); 
+	
+	// the memory of the agent grid and the mesh's neighborhood lists 
+	double memory_footprint_megabytes( void ); 
+	void display_memory_footprint( std::ostream& os ); 
 };
 
 int find_escaping_face_index(Cell* agent);
 extern std::vector<Cell*> *all_cells; 
+// divide the flagged cells in one parallel batch (see divide_flagged_cells), 
+// rather than one at a time -- 1.7.2 
+extern bool batched_divisions; 
+// new cell containers store a hashed agent grid (see Cell_Container) -- 1.7.2 
+extern bool hashed_cell_container; 
+// new cell containers derive their mesh's voxel centers and neighbors on the fly 
+// (see Cartesian_Mesh::implicit_voxels). Hashed containers always do. -- 1.7.2 
+extern bool implicit_mechanics_mesh; 
 
 Cell_Container* create_cell_container_for_microenvironment( BioFVM::Microenvironment& m , double mechanics_voxel_size );
 
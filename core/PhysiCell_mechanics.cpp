@@ -0,0 +1,576 @@
+/*
+###############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the version #
+# number, such as below:                                                      #
+#                                                                             #
+# We implemented and solved the model using PhysiCell (Version x.y.z) [1].    #
+#                                                                             #
+# [1] A Ghaffarizadeh, R Heiland, SH Friedman, SM Mumenthaler, and P Macklin, #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for Multicellu-  #
+#     lar Systems, PLoS Comput. Biol. 14(2): e1005991, 2018                   #
+#     DOI: 10.1371/journal.pcbi.1005991                                       #
+#                                                                             #
+# See VERSION.txt or call get_PhysiCell_version() to get the current version  #
+#     x.y.z. Call display_citations() to get detailed information on all cite-#
+#     able software used in your PhysiCell application.                       #
+#                                                                             #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite BioFVM  #
+#     as below:                                                               #
+#                                                                             #
+# We implemented and solved the model using PhysiCell (Version x.y.z) [1],    #
+# with BioFVM [2] to solve the transport equations.                           #
+#                                                                             #
+# [1] A Ghaffarizadeh, R Heiland, SH Friedman, SM Mumenthaler, and P Macklin, #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for Multicellu-  #
+#     lar Systems, PLoS Comput. Biol. 14(2): e1005991, 2018                   #
+#     DOI: 10.1371/journal.pcbi.1005991                                       #
+#                                                                             #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient para- #
+#     llelized diffusive transport solver for 3-D biological simulations,     #
+#     Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730  #
+#                                                                             #
+###############################################################################
+#                                                                             #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)     #
+#                                                                             #
+# Copyright (c) 2015-2018, Paul Macklin and the PhysiCell Project             #
+# All rights reserved.                                                        #
+#                                                                             #
+# Redistribution and use in source and binary forms, with or without          #
+# modification, are permitted provided that the following conditions are met: #
+#                                                                             #
+# 1. Redistributions of source code must retain the above copyright notice,   #
+# this list of conditions and the following disclaimer.                       #
+#                                                                             #
+# 2. Redistributions in binary form must reproduce the above copyright        #
+# notice, this list of conditions and the following disclaimer in the         #
+# documentation and/or other materials provided with the distribution.        #
+#                                                                             #
+# 3. Neither the name of the copyright holder nor the names of its            #
+# contributors may be used to endorse or promote products derived from this   #
+# software without specific prior written permission.                         #
+#                                                                             #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" #
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   #
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  #
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   #
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         #
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        #
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    #
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     #
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     #
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  #
+# POSSIBILITY OF SUCH DAMAGE.                                                 #
+#                                                                             #
+###############################################################################
+*/
+
+
+#include <cmath>
+#include <algorithm>
+
+#include "./PhysiCell_mechanics.h"
+#include "./PhysiCell_cell.h"
+
+namespace PhysiCell{
+
+Mechanics_Options default_mechanics_options; 
+
+Mechanics_Options::Mechanics_Options()
+{
+	use_packed_mechanics = true; 
+	verlet_skin = 2.0; 
+	reorder_interval = 0; 
+	symmetric_forces = false; 
+	
+	adaptive_mechanics_dt = false; 
+	max_mechanics_dt = 1.0; 
+	max_relative_displacement = 0.05; 
+	
+	return; 
+}
+
+// the test of is_neighbor_voxel on packed data: can a cell at position, reaching 
+// out to reach, interact with a cell in the other voxel? Compares the distance to 
+// the face, edge, or corner that the two voxels share. 
+static inline bool voxel_within_reach( const double* position , const double* my_center , 
+	const double* other_center , double reach )
+{
+	double distance_squared = 0.0; 
+	for( int d=0; d < 3 ; d++ )
+	{
+		if( my_center[d] != other_center[d] )
+		{
+			double boundary = position[d] - 0.5*( my_center[d] + other_center[d] ); 
+			distance_squared += boundary * boundary; 
+		}
+	}
+	return distance_squared <= reach * reach; 
+}
+
+Mechanics_Engine::Mechanics_Engine()
+{
+	pCells = NULL; 
+	packed = false; 
+	hashed_slots = false; 
+	
+	built_skin = 0.0; 
+	built_symmetric = false; 
+	list_builds = 0; 
+	packed_steps = 0; 
+	
+	return; 
+}
+
+void Mechanics_Engine::pack( Cell_Container& container, std::vector<Cell*>& cells )
+{
+	pCells = &cells; 
+	int n = cells.size(); 
+	
+	x.resize( n ); 
+	y.resize( n ); 
+	z.resize( n ); 
+	radius.resize( n ); 
+	sqrt_repulsion.resize( n ); 
+	sqrt_adhesion.resize( n ); 
+	adhesion_distance.resize( n ); 
+	
+	#pragma omp parallel for 
+	for( int i=0; i < n ; i++ )
+	{
+		Cell* pC = cells[i]; 
+		x[i] = pC->position[0]; 
+		y[i] = pC->position[1]; 
+		z[i] = pC->position[2]; 
+		radius[i] = pC->phenotype.geometry.radius; 
+		sqrt_repulsion[i] = sqrt( pC->phenotype.mechanics.cell_cell_repulsion_strength ); 
+		sqrt_adhesion[i] = sqrt( pC->phenotype.mechanics.cell_cell_adhesion_strength ); 
+		adhesion_distance[i] = pC->phenotype.mechanics.relative_maximum_adhesion_distance * radius[i]; 
+	}
+	
+	if( !lists_are_valid( cells ) )
+	{ build_neighbor_lists( container, cells ); }
+	if( built_symmetric )
+	{ accumulate_symmetric_forces(); }
+	
+	packed_steps++; 
+	packed = true; 
+	return; 
+}
+
+bool Mechanics_Engine::lists_are_valid( std::vector<Cell*>& cells )
+{
+	int n = cells.size(); 
+	if( default_mechanics_options.verlet_skin <= 0.0 || built_skin != default_mechanics_options.verlet_skin || 
+		built_symmetric != default_mechanics_options.symmetric_forces || n != (int) built_cells.size() )
+	{ return false; }
+	
+	// a pair can only come into range if the two cells together moved and 
+	// grew by more than the skin 
+	double max_change = 0.0; 
+	int changed_cells = 0; 
+	#pragma omp parallel for reduction(max:max_change) reduction(+:changed_cells)
+	for( int i=0; i < n ; i++ )
+	{
+		changed_cells += ( cells[i] != built_cells[i] || 
+			(char) cells[i]->is_out_of_domain != built_out_of_domain[i] ); 
+		
+		double dx = x[i] - built_x[i]; 
+		double dy = y[i] - built_y[i]; 
+		double dz = z[i] - built_z[i]; 
+		double growth = std::max( radius[i] , adhesion_distance[i] ) - built_reach[i]; 
+		double change = sqrt( dx*dx + dy*dy + dz*dz ) + std::max( growth , 0.0 ); 
+		max_change = std::max( max_change , change ); 
+	}
+	
+	return changed_cells == 0 && 2.0 * max_change <= built_skin; 
+}
+
+void Mechanics_Engine::build_neighbor_lists( Cell_Container& container, std::vector<Cell*>& cells )
+{
+	int n = cells.size(); 
+	double skin = std::max( default_mechanics_options.verlet_skin , 0.0 ); 
+	
+	neighbor_lists.resize( n ); 
+	built_cells = cells; 
+	built_out_of_domain.resize( n ); 
+	built_x = x; 
+	built_y = y; 
+	built_z = z; 
+	built_reach.resize( n ); 
+	built_skin = skin; 
+	built_symmetric = default_mechanics_options.symmetric_forces; 
+	bool half = built_symmetric; 
+	
+	#pragma omp parallel for 
+	for( int i=0; i < n ; i++ )
+	{ built_reach[i] = std::max( radius[i] , adhesion_distance[i] ); }
+	
+	// number the voxels: a hashed grid only gets slots for its occupied voxels 
+	hashed_slots = container.is_hashed(); 
+	int number_of_voxels = container.agent_grid.size(); 
+	if( hashed_slots )
+	{
+		container.get_occupied_voxels( slot_voxels ); 
+		number_of_voxels = slot_voxels.size(); 
+		voxel_slots.clear(); 
+		for( int s=0; s < number_of_voxels ; s++ )
+		{ voxel_slots[ slot_voxels[s] ] = s; }
+	}
+	
+	// index the voxel lists by packed index, and find how far the cells in each 
+	// voxel reach. (The lists outlive max_cell_interactive_distance_in_voxel, 
+	// which is only refreshed in the phenotype steps.) 
+	voxel_start.resize( number_of_voxels + 1 ); 
+	voxel_start[0] = 0; 
+	for( int v=0; v < number_of_voxels ; v++ )
+	{ voxel_start[v+1] = voxel_start[v] + container.cells_in_voxel( voxel_of_slot(v) ).size(); }
+	voxel_cells.resize( voxel_start[number_of_voxels] ); 
+	voxel_reach.resize( number_of_voxels ); 
+	
+	#pragma omp parallel for 
+	for( int v=0; v < number_of_voxels ; v++ )
+	{
+		std::vector<Cell*>& voxel = container.cells_in_voxel( voxel_of_slot(v) ); 
+		int* pOut = voxel_cells.data() + voxel_start[v]; 
+		double reach = 0.0; 
+		for( unsigned int k=0; k < voxel.size() ; k++ )
+		{
+			pOut[k] = voxel[k]->index; 
+			reach = std::max( reach , built_reach[ pOut[k] ] ); 
+		}
+		voxel_reach[v] = reach; 
+	}
+	
+	Cartesian_Mesh& mesh = container.underlying_mesh; 
+	
+	// color the non-empty voxels by their (i,j,k) indices mod 3 (counting sort) 
+	if( half )
+	{
+		unsigned int nx = mesh.x_coordinates.size(); 
+		unsigned int ny = mesh.y_coordinates.size(); 
+		std::vector<int> colors( number_of_voxels , -1 ); 
+		color_start.assign( 28 , 0 ); 
+		for( int v=0; v < number_of_voxels ; v++ )
+		{
+			if( voxel_start[v] == voxel_start[v+1] )
+			{ continue; }
+			unsigned int voxel = voxel_of_slot( v ); 
+			unsigned int vi = voxel % nx; 
+			unsigned int vj = ( voxel / nx ) % ny; 
+			unsigned int vk = voxel / ( nx * ny ); 
+			colors[v] = ( vi % 3 ) + 3*( vj % 3 ) + 9*( vk % 3 ); 
+			color_start[ colors[v]+1 ]++; 
+		}
+		for( int c=0; c < 27 ; c++ )
+		{ color_start[c+1] += color_start[c]; }
+		color_voxels.resize( color_start[27] ); 
+		std::vector<int> next( color_start.begin() , color_start.end() - 1 ); 
+		for( int v=0; v < number_of_voxels ; v++ )
+		{
+			if( colors[v] >= 0 )
+			{ color_voxels[ next[ colors[v] ]++ ] = v; }
+		}
+	}
+	
+	#pragma omp parallel for 
+	for( int i=0; i < n ; i++ )
+	{
+		Cell* pCell = cells[i]; 
+		std::vector<int>& list = neighbor_lists[i]; 
+		list.clear(); 
+		
+		built_out_of_domain[i] = (char) pCell->is_out_of_domain; 
+		if( pCell->is_out_of_domain )
+		{ continue; }
+		
+		double position[3] = { x[i] , y[i] , z[i] }; 
+		double ri = radius[i]; 
+		double S_i = adhesion_distance[i]; 
+		
+		// keep the cells within reach (the larger of R and S) plus the skin. 
+		// Half lists keep a pair with the cell that comes first in (voxel, index) 
+		// order; voxel indices increase with (k,j,i), so later voxels are the 
+		// forward half of the Moore neighborhood. 
+		int voxel = pCell->get_current_mechanics_voxel_index(); 
+		int slot = slot_of_voxel( voxel ); 
+		for( int k=voxel_start[slot]; k < voxel_start[slot+1] ; k++ )
+		{
+			int j = voxel_cells[k]; 
+			if( half && j < i )
+			{ continue; }
+			double dx = position[0] - x[j]; 
+			double dy = position[1] - y[j]; 
+			double dz = position[2] - z[j]; 
+			double reach = std::max( ri + radius[j] , S_i + adhesion_distance[j] ) + skin; 
+			if( j != i && dx*dx + dy*dy + dz*dz <= reach*reach )
+			{ list.push_back( j ); }
+		}
+		
+		// and the same in the Moore neighbors that are close enough (as in is_neighbor_voxel) 
+		int moore[26]; 
+		int number_of_neighbors = container.moore_neighborhood( voxel , moore ); 
+		double center[3]; 
+		double other_center[3]; 
+		mesh.voxel_center( voxel , center ); 
+		for( int m=0; m < number_of_neighbors ; m++ )
+		{
+			int other = moore[m]; 
+			int other_slot = slot_of_voxel( other ); 
+			if( ( half && other < voxel ) || other_slot < 0 || voxel_start[other_slot] == voxel_start[other_slot+1] )
+			{ continue; }
+			mesh.voxel_center( other , other_center ); 
+			if( !voxel_within_reach( position, center, other_center, built_reach[i] + voxel_reach[other_slot] + skin ) )
+			{ continue; }
+			for( int k=voxel_start[other_slot]; k < voxel_start[other_slot+1] ; k++ )
+			{
+				int j = voxel_cells[k]; 
+				double dx = position[0] - x[j]; 
+				double dy = position[1] - y[j]; 
+				double dz = position[2] - z[j]; 
+				double reach = std::max( ri + radius[j] , S_i + adhesion_distance[j] ) + skin; 
+				if( dx*dx + dy*dy + dz*dz <= reach*reach )
+				{ list.push_back( j ); }
+			}
+		}
+	}
+	
+	list_builds++; 
+	return; 
+}
+
+int Mechanics_Engine::slot_of_voxel( int voxel ) const
+{
+	if( !hashed_slots )
+	{ return voxel; }
+	std::unordered_map<int,int>::const_iterator search = voxel_slots.find( voxel ); 
+	if( search == voxel_slots.end() )
+	{ return -1; }
+	return search->second; 
+}
+
+int Mechanics_Engine::voxel_of_slot( int slot ) const
+{
+	if( !hashed_slots )
+	{ return slot; }
+	return slot_voxels[slot]; 
+}
+
+void Mechanics_Engine::release( void )
+{
+	packed = false; 
+	return; 
+}
+
+bool Mechanics_Engine::is_packed( Cell* pCell ) const
+{
+	if( packed == false || pCell->index < 0 || pCell->index >= (int) x.size() )
+	{ return false; }
+	return (*pCells)[pCell->index] == pCell; 
+}
+
+int Mechanics_Engine::size( void ) const
+{ return x.size(); }
+
+const std::vector<int>& Mechanics_Engine::neighbor_list( Cell* pCell ) const
+{ return neighbor_lists[pCell->index]; }
+
+bool Mechanics_Engine::has_full_neighbor_lists( void ) const
+{ return !built_symmetric; }
+
+int Mechanics_Engine::number_of_list_builds( void ) const
+{ return list_builds; }
+
+int Mechanics_Engine::number_of_packed_steps( void ) const
+{ return packed_steps; }
+
+// 12 uniform neighbors at a close packing distance (see Cell::add_potentials) 
+static const double simple_pressure_scale = 0.027288820670331; 
+
+// the potentials of Cell::add_potentials for a pair at (dx,dy,dz) apart: writes 
+// the velocity factor (multiply by the displacement) and the pressure term 
+static inline void pair_potential( double dx , double dy , double dz , double ri , double rep_i , double adh_i , double S_i , 
+	double rj , double rep_j , double adh_j , double S_j , double& factor , double& pressure )
+{
+	double distance = sqrt( dx*dx + dy*dy + dz*dz ); 
+	distance = ( distance > 0.00001 ) ? distance : 0.00001; 
+	
+	// repulsion: (1-d/R)^2 for d <= R 
+	double R = ri + rj; 
+	double temp_r = 1.0 - distance / R; 
+	temp_r = ( distance > R ) ? 0.0 : temp_r * temp_r; 
+	pressure = temp_r; 
+	temp_r *= rep_i * rep_j; 
+	
+	// adhesion: (1-d/S)^2 for d < S 
+	double S = S_i + S_j; 
+	double temp_a = 1.0 - distance / S; 
+	temp_a = ( distance < S ) ? temp_a * temp_a * adh_i * adh_j : 0.0; 
+	
+	temp_r -= temp_a; 
+	factor = ( fabs( temp_r ) < 1e-16 ) ? 0.0 : temp_r / distance; 
+	return; 
+}
+
+void Mechanics_Engine::accumulate_symmetric_forces( void )
+{
+	int n = x.size(); 
+	pair_forces.assign( 4*n , 0.0 ); 
+	double* pForces = pair_forces.data(); 
+	
+	const double* px = x.data(); 
+	const double* py = y.data(); 
+	const double* pz = z.data(); 
+	const double* pr = radius.data(); 
+	const double* prep = sqrt_repulsion.data(); 
+	const double* padh = sqrt_adhesion.data(); 
+	const double* pS = adhesion_distance.data(); 
+	
+	#pragma omp parallel 
+	{
+		std::vector<double> factors; 
+		std::vector<double> pressures; 
+		
+		// one color at a time: the voxels of a color write to disjoint cells 
+		for( int c=0; c < 27 ; c++ )
+		{
+			#pragma omp for schedule(dynamic,8) 
+			for( int m=color_start[c]; m < color_start[c+1] ; m++ )
+			{
+				int voxel = color_voxels[m]; 
+				for( int v=voxel_start[voxel]; v < voxel_start[voxel+1] ; v++ )
+				{
+					int i = voxel_cells[v]; 
+					const int* pIndex = neighbor_lists[i].data(); 
+					int count = neighbor_lists[i].size(); 
+					if( count == 0 )
+					{ continue; }
+					
+					double xi = px[i]; 
+					double yi = py[i]; 
+					double zi = pz[i]; 
+					double ri = pr[i]; 
+					double rep_i = prep[i]; 
+					double adh_i = padh[i]; 
+					double S_i = pS[i]; 
+					
+					// evaluate each pair once (vectorized), summing the forces on cell i ... 
+					factors.resize( count ); 
+					pressures.resize( count ); 
+					double* pf = factors.data(); 
+					double* pp = pressures.data(); 
+					double vx = 0.0; 
+					double vy = 0.0; 
+					double vz = 0.0; 
+					double pressure = 0.0; 
+					#pragma omp simd reduction(+:vx,vy,vz,pressure) 
+					for( int k=0; k < count ; k++ )
+					{
+						int j = pIndex[k]; 
+						double dx = xi - px[j]; 
+						double dy = yi - py[j]; 
+						double dz = zi - pz[j]; 
+						double factor; 
+						double pair_pressure; 
+						pair_potential( dx , dy , dz , ri , rep_i , adh_i , S_i , pr[j] , prep[j] , padh[j] , pS[j] , 
+							factor , pair_pressure ); 
+						
+						pf[k] = factor; 
+						pp[k] = pair_pressure; 
+						pressure += pair_pressure; 
+						vx += dx * factor; 
+						vy += dy * factor; 
+						vz += dz * factor; 
+					}
+					
+					// ... then apply the opposite forces to the neighbors 
+					for( int k=0; k < count ; k++ )
+					{
+						int j = pIndex[k]; 
+						double* pF = pForces + 4*j; 
+						pF[0] -= ( xi - px[j] ) * pf[k]; 
+						pF[1] -= ( yi - py[j] ) * pf[k]; 
+						pF[2] -= ( zi - pz[j] ) * pf[k]; 
+						pF[3] += pp[k]; 
+					}
+					double* pF = pForces + 4*i; 
+					pF[0] += vx; 
+					pF[1] += vy; 
+					pF[2] += vz; 
+					pF[3] += pressure; 
+				}
+			}
+		}
+	}
+	
+	return; 
+}
+
+void Mechanics_Engine::add_cell_cell_forces( Cell* pCell )
+{
+	int i = pCell->index; 
+	
+	// already summed over all the pairs in pack 
+	if( built_symmetric )
+	{
+		const double* pF = pair_forces.data() + 4*i; 
+		pCell->state.simple_pressure += pF[3] / simple_pressure_scale; 
+		pCell->velocity[0] += pF[0]; 
+		pCell->velocity[1] += pF[1]; 
+		pCell->velocity[2] += pF[2]; 
+		return; 
+	}
+	
+	const int* pIndex = neighbor_lists[i].data(); 
+	int count = neighbor_lists[i].size(); 
+	
+	const double* px = x.data(); 
+	const double* py = y.data(); 
+	const double* pz = z.data(); 
+	const double* pr = radius.data(); 
+	const double* prep = sqrt_repulsion.data(); 
+	const double* padh = sqrt_adhesion.data(); 
+	const double* pS = adhesion_distance.data(); 
+	
+	double xi = px[i]; 
+	double yi = py[i]; 
+	double zi = pz[i]; 
+	double ri = pr[i]; 
+	double rep_i = prep[i]; 
+	double adh_i = padh[i]; 
+	double S_i = pS[i]; 
+	
+	// the kernel: same potentials as Cell::add_potentials, with branches as selects 
+	double vx = 0.0; 
+	double vy = 0.0; 
+	double vz = 0.0; 
+	double pressure = 0.0; 
+	
+	#pragma omp simd reduction(+:vx,vy,vz,pressure) 
+	for( int k=0; k < count ; k++ )
+	{
+		int j = pIndex[k]; 
+		double dx = xi - px[j]; 
+		double dy = yi - py[j]; 
+		double dz = zi - pz[j]; 
+		double factor; 
+		double pair_pressure; 
+		pair_potential( dx , dy , dz , ri , rep_i , adh_i , S_i , pr[j] , prep[j] , padh[j] , pS[j] , 
+			factor , pair_pressure ); 
+		
+		pressure += pair_pressure; 
+		vx += dx * factor; 
+		vy += dy * factor; 
+		vz += dz * factor; 
+	}
+	
+	// scatter back to the cell 
+	pCell->state.simple_pressure += pressure / simple_pressure_scale; 
+	pCell->velocity[0] += vx; 
+	pCell->velocity[1] += vy; 
+	pCell->velocity[2] += vz; 
+	
+	return; 
+}
+
+};
@@ -0,0 +1,227 @@
+/*
+###############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the version #
+# number, such as below:                                                      #
+#                                                                             #
+# We implemented and solved the model using PhysiCell (Version x.y.z) [1].    #
+#                                                                             #
+# [1] A Ghaffarizadeh, R Heiland, SH Friedman, SM Mumenthaler, and P Macklin, #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for Multicellu-  #
+#     lar Systems, PLoS Comput. Biol. 14(2): e1005991, 2018                   #
+#     DOI: 10.1371/journal.pcbi.1005991                                       #
+#                                                                             #
+# See VERSION.txt or call get_PhysiCell_version() to get the current version  #
+#     x.y.z. Call display_citations() to get detailed information on all cite-#
+#     able software used in your PhysiCell application.                       #
+#                                                                             #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite BioFVM  #
+#     as below:                                                               #
+#                                                                             #
+# We implemented and solved the model using PhysiCell (Version x.y.z) [1],    #
+# with BioFVM [2] to solve the transport equations.                           #
+#                                                                             #
+# [1] A Ghaffarizadeh, R Heiland, SH Friedman, SM Mumenthaler, and P Macklin, #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for Multicellu-  #
+#     lar Systems, PLoS Comput. Biol. 14(2): e1005991, 2018                   #
+#     DOI: 10.1371/journal.pcbi.1005991                                       #
+#                                                                             #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient para- #
+#     llelized diffusive transport solver for 3-D biological simulations,     #
+#     Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730  #
+#                                                                             #
+###############################################################################
+#                                                                             #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)     #
+#                                                                             #
+# Copyright (c) 2015-2018, Paul Macklin and the PhysiCell Project             #
+# All rights reserved.                                                        #
+#                                                                             #
+# Redistribution and use in source and binary forms, with or without          #
+# modification, are permitted provided that the following conditions are met: #
+#                                                                             #
+# 1. Redistributions of source code must retain the above copyright notice,   #
+# this list of conditions and the following disclaimer.                       #
+#                                                                             #
+# 2. Redistributions in binary form must reproduce the above copyright        #
+# notice, this list of conditions and the following disclaimer in the         #
+# documentation and/or other materials provided with the distribution.        #
+#                                                                             #
+# 3. Neither the name of the copyright holder nor the names of its            #
+# contributors may be used to endorse or promote products derived from this   #
+# software without specific prior written permission.                         #
+#                                                                             #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" #
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   #
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  #
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   #
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         #
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        #
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    #
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     #
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     #
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  #
+# POSSIBILITY OF SUCH DAMAGE.                                                 #
+#                                                                             #
+###############################################################################
+*/
+
+
+#ifndef __PhysiCell_mechanics_h__
+#define __PhysiCell_mechanics_h__
+
+#include <vector>
+#include <unordered_map>
+
+namespace PhysiCell{
+
+class Cell; 
+class Cell_Container; 
+
+class Mechanics_Options
+{
+ private:
+ public:
+	// evaluate cell-cell potentials from packed (structure-of-arrays) data -- 1.7.2 
+	bool use_packed_mechanics; 
+	
+	// extra distance (in space units) kept in the neighbor lists, so that they 
+	// only need to be rebuilt once a cell has moved (or grown) by half of it. 
+	// 0 rebuilds the lists every mechanics step. -- 1.7.2 
+	double verlet_skin; 
+	
+	// sort all_cells along a space-filling (Morton) curve every this many 
+	// mechanics steps, so that cells near in space are near in memory. 
+	// 0 never sorts. -- 1.7.2 
+	int reorder_interval; 
+	
+	// evaluate every cell-cell pair once and apply equal and opposite forces 
+	// to both cells (Newton's third law), rather than once from each side. 
+	// The neighbor lists then only hold half of the pairs. -- 1.7.2 
+	bool symmetric_forces; 
+	
+	// choose each mechanics step between mechanics_dt and max_mechanics_dt, 
+	// so that no cell moves by more than max_relative_displacement of its 
+	// radius in one step (see Cell_Container::choose_mechanics_dt) -- 1.7.2 
+	bool adaptive_mechanics_dt; 
+	double max_mechanics_dt; 
+	double max_relative_displacement; 
+	
+	Mechanics_Options(); 
+};
+
+extern Mechanics_Options default_mechanics_options; 
+
+/* 
+ The mechanics engine copies everything the cell-cell potentials read (positions, 
+ radii, interaction strengths, and maximum adhesion distances) into contiguous 
+ arrays once per mechanics step. The arrays are indexed like all_cells, so that 
+ neighbor j of a cell lives at index (*all_cells)[j]->index. 
+ 
+ While the engine is packed, standard_update_cell_velocity evaluates the 
+ forces with a vectorized kernel over these arrays rather than calling 
+ Cell::add_potentials on every neighbor. (new in 1.7.2) 
+ 
+ The neighbors come from Verlet lists: every cell within interaction distance 
+ plus verlet_skin at the last build. The lists stay valid (and are reused) 
+ until some cell has moved and grown by more than half the skin since then, 
+ or cells were created, deleted, or reordered. 
+ 
+ With symmetric_forces, each list only holds the pairs that its cell "owns": 
+ later cells in the same voxel, and the cells in the forward half of the Moore 
+ neighborhood. pack then evaluates every pair once, and accumulates the force 
+ on both cells. To do so in parallel without races, the voxels are colored by 
+ their (i,j,k) indices mod 3: a pair only writes to cells within one voxel of 
+ its owner's voxel, so voxels of the same color never write to the same cells. 
+*/
+
+class Mechanics_Engine
+{
+ private:
+	std::vector<Cell*>* pCells; 
+	bool packed; 
+	
+	// the voxel lists below are indexed by slot: the mechanics voxel itself for 
+	// a dense agent grid, or the position among the occupied voxels (listed in 
+	// slot_voxels, and found through voxel_slots) for a hashed one 
+	bool hashed_slots; 
+	std::vector<int> slot_voxels; 
+	std::unordered_map<int,int> voxel_slots; 
+	int slot_of_voxel( int voxel ) const; // -1 for empty voxels of a hashed grid 
+	int voxel_of_slot( int slot ) const; 
+	
+	// the packed indices of the cells in each mechanics voxel (slot s holds 
+	// voxel_cells[ voxel_start[s] ] ... voxel_cells[ voxel_start[s+1]-1 ]), so that 
+	// gathering neighbors does not dereference the neighbor cells 
+	std::vector<int> voxel_start; 
+	std::vector<int> voxel_cells; 
+	// the largest reach (radius or maximum adhesion distance) in each voxel 
+	std::vector<double> voxel_reach; 
+	
+	// the Verlet lists (packed indices), and the state they were built for 
+	std::vector< std::vector<int> > neighbor_lists; 
+	std::vector<Cell*> built_cells; 
+	std::vector<char> built_out_of_domain; 
+	std::vector<double> built_x; 
+	std::vector<double> built_y; 
+	std::vector<double> built_z; 
+	std::vector<double> built_reach; 
+	double built_skin; 
+	bool built_symmetric; 
+	
+	// the non-empty voxel slots of each of the 27 colors (color c holds 
+	// color_voxels[ color_start[c] ] ... color_voxels[ color_start[c+1]-1 ]) 
+	std::vector<int> color_start; 
+	std::vector<int> color_voxels; 
+	
+	// the summed cell-cell velocity and pressure of each cell in the symmetric 
+	// pass, interleaved (x,y,z,pressure) so that a pair touches one cache line 
+	std::vector<double> pair_forces; 
+	
+	int list_builds; 
+	int packed_steps; 
+	
+	bool lists_are_valid( std::vector<Cell*>& cells ); 
+	void build_neighbor_lists( Cell_Container& container, std::vector<Cell*>& cells ); 
+	void accumulate_symmetric_forces( void ); 
+	
+ public:
+	std::vector<double> x; 
+	std::vector<double> y; 
+	std::vector<double> z; 
+	std::vector<double> radius; 
+	// square roots of the cell-cell strengths, so that the effective 
+	// strength of a pair is a product 
+	std::vector<double> sqrt_repulsion; 
+	std::vector<double> sqrt_adhesion; 
+	// relative_maximum_adhesion_distance * radius 
+	std::vector<double> adhesion_distance; 
+	
+	Mechanics_Engine(); 
+	
+	// copy the mechanics data of all the cells (and the container's voxel 
+	// lists) into the arrays 
+	void pack( Cell_Container& container, std::vector<Cell*>& cells ); 
+	// mark the arrays as stale (after the velocities are computed) 
+	void release( void ); 
+	// true if pCell was packed in the current mechanics step 
+	bool is_packed( Cell* pCell ) const; 
+	int size( void ) const; 
+	
+	// add the cell-cell potentials of all neighbors to pCell's velocity and 
+	// set its simple pressure. Requires is_packed( pCell ). 
+	void add_cell_cell_forces( Cell* pCell ); 
+	
+	// the Verlet list of pCell: every other cell that may interact with it. 
+	// Requires is_packed( pCell ) and has_full_neighbor_lists(). 
+	const std::vector<int>& neighbor_list( Cell* pCell ) const; 
+	// false if the lists only hold half of the pairs (symmetric_forces) 
+	bool has_full_neighbor_lists( void ) const; 
+	
+	// how many times the lists were built, out of how many packed steps 
+	int number_of_list_builds( void ) const; 
+	int number_of_packed_steps( void ) const; 
+};
+
+};
+
+#endif
@@ -74,6 +74,28 @@
 using namespace BioFVM; 
 
 namespace PhysiCell{
+
+bool event_driven_transitions = false; 
+
+// an Exp(1) waiting "time", in units of accumulated hazard 
+static double draw_hazard_threshold( void )
+{ return -std::log( 1.0 - UniformRandom() ); }
+
+// pick one of several competing rates (in turn) with probability proportional 
+// to its rate, from one uniform random number u: returns true if this rate 
+// replaces the previous pick, and rescales u to stay uniform for the next one 
+static bool pick_competing_rate( double rate , double& total_rate , double& u )
+{
+	total_rate += rate; 
+	double p = rate / total_rate; 
+	if( u < p )
+	{
+		u /= p; 
+		return true; 
+	}
+	u = ( u - p ) / ( 1.0 - p ); 
+	return false; 
+}
 	
 Phase::Phase()
 {
@@ -102,8 +124,6 @@ Phase_Link::Phase_Link()
 
 Cycle_Data::Cycle_Data()
 {
-	inverse_index_maps.resize(0); 
-	
 	pCycle_Model = NULL; 
 
 	time_units = "min"; 
@@ -112,48 +132,45 @@ Cycle_Data::Cycle_Data()
 
 	current_phase_index = 0; 
 	elapsed_time_in_phase = 0.0; 
+	
+	reset_transition_clock(); 
+	return; 
+}
+
+void Cycle_Data::reset_transition_clock( void )
+{
+	clock_phase_index = -1; 
+	accumulated_hazard = 0.0; 
+	hazard_threshold = 0.0; 
+	link_choice = 0.0; 
+	clock_rate = -1.0; 
 	return; 
 }
 
 void Cycle_Data::sync_to_cycle_model( void )
 {
-	// make sure the inverse map is the right size 
-	int n = pCycle_Model->phases.size(); 
-	inverse_index_maps.resize( n );
+	reset_transition_clock(); 
 	
-	// sync the inverse map to the cell cycle model by 
-	// querying the phase_links 
-
-	transition_rates.resize( n );
-	
-	// also make sure the transition_rates[] are the right size 
-	
-	for( int i=0 ; i < pCycle_Model->phase_links.size() ; i++ )
-	{
-		inverse_index_maps[i].clear(); 
-		for( int j=0 ; j < pCycle_Model->phase_links[i].size() ; j++ )
-		{
-			inverse_index_maps[i][ pCycle_Model->phase_links[i][j].end_phase_index ] = j;
-			transition_rates[i].resize( pCycle_Model->phase_links[i].size() ); 
-		}
-	}
+	// make sure there is a transition rate for every phase link 
+	transition_rates.resize( pCycle_Model->number_of_links() ); 
 
 	return; 
 }
 
 double& Cycle_Data::transition_rate( int start_phase_index , int end_phase_index )
 {
-	return transition_rates[ start_phase_index ][ inverse_index_maps[start_phase_index][end_phase_index] ]; 
+	return transition_rates[ pCycle_Model->find_link_index( start_phase_index , end_phase_index ) ]; 
 }
 
 double& Cycle_Data::exit_rate(int phase_index )
 {
-	return transition_rates[phase_index][0]; 
+	return transition_rates[ pCycle_Model->link_index( phase_index , 0 ) ]; 
 }
 	
 Cycle_Model::Cycle_Model()
 {
 	inverse_index_maps.resize( 0 );
+	link_offsets.assign( 1 , 0 ); 
 	
 	name = "unnamed";
 	
@@ -167,6 +184,31 @@ Cycle_Model::Cycle_Model()
 	
 	return; 
 }	
+
+Cycle_Model::Cycle_Model( const Cycle_Model& copy_me )
+{
+	*this = copy_me; 
+	return; 
+}
+
+Cycle_Model& Cycle_Model::operator=( const Cycle_Model& copy_me )
+{
+	inverse_index_maps = copy_me.inverse_index_maps; 
+	link_offsets = copy_me.link_offsets; 
+	
+	name = copy_me.name; 
+	code = copy_me.code; 
+	
+	phases = copy_me.phases; 
+	phase_links = copy_me.phase_links; 
+	
+	default_phase_index = copy_me.default_phase_index; 
+	
+	data = copy_me.data; 
+	data.pCycle_Model = this; 
+	
+	return *this; 
+}
 	
 int Cycle_Model::add_phase( int code, std::string name )
 {
@@ -180,6 +222,9 @@ int Cycle_Model::add_phase( int code, std::string name )
 	inverse_index_maps.resize( n+1 );
 	inverse_index_maps[n].clear(); 
 	
+	// the new phase has no links yet 
+	link_offsets.push_back( link_offsets.back() ); 
+	
 	// update phase n
 	phases[n].code = code; 
 	phases[n].index = n; 
@@ -208,6 +253,11 @@ int Cycle_Model::add_phase_link( int start_index, int end_index ,
 	// now, update the inverse index map 
 	inverse_index_maps[start_index][end_index] = n; 
 	
+	// make room for its rate after the other links of its phase 
+	data.transition_rates.insert( data.transition_rates.begin() + link_offsets[start_index] + n , 0.0 ); 
+	for( int i=start_index+1 ; i < link_offsets.size() ; i++ )
+	{ link_offsets[i]++; }
+	
 	// lastly, make sure the transition rates are the right size;
 	
 	data.sync_to_cycle_model(); 
@@ -274,85 +324,182 @@ Phase_Link& Cycle_Model::phase_link( int start_index, int end_index )
 {
 	return phase_links[start_index][ inverse_index_maps[start_index][end_index] ]; 
 }
+
+int Cycle_Model::link_index( int start_index , int link ) const
+{
+	return link_offsets[start_index] + link; 
+}
+
+int Cycle_Model::number_of_links( void ) const
+{
+	return link_offsets.back(); 
+}
+
+int Cycle_Model::find_link_index( int start_index , int end_index )
+{
+	return link_offsets[start_index] + inverse_index_maps[start_index][end_index]; 
+}
 	
 void Cycle_Model::advance_model( Cell* pCell, Phenotype& phenotype, double dt )
 {
-	int i = phenotype.cycle.data.current_phase_index; 
+	Cycle_Data& cycle_data = phenotype.cycle.data; 
+	int i = cycle_data.current_phase_index; 
+	
+	cycle_data.elapsed_time_in_phase += dt; 
 	
-	phenotype.cycle.data.elapsed_time_in_phase += dt; 
+	// draw the clock for this phase if we have just entered it 
+	if( event_driven_transitions && cycle_data.clock_phase_index != i )
+	{
+		cycle_data.clock_phase_index = i; 
+		cycle_data.accumulated_hazard = 0.0; 
+		cycle_data.hazard_threshold = draw_hazard_threshold(); 
+		cycle_data.link_choice = UniformRandom(); 
+		cycle_data.clock_rate = -1.0; 
+	}
+	
+	// skip the step if the links out of this phase are all stochastic and 
+	// unarrestable, their rates still sum to those of the last step, and the 
+	// clock does not ring in this step 
+	if( event_driven_transitions && cycle_data.clock_rate >= 0.0 )
+	{
+		double total_rate = 0.0; 
+		bool skip = true; 
+		for( int k=0 ; k < phase_links[i].size() ; k++ )
+		{
+			if( phase_links[i][k].arrest_function || phase_links[i][k].fixed_duration )
+			{
+				skip = false; 
+				break; 
+			}
+			double rate = cycle_data.transition_rates[ link_offsets[i] + k ]; 
+			if( rate > 0.0 )
+			{ total_rate += rate; }
+		}
+		double hazard = total_rate * dt; 
+		if( skip && total_rate == cycle_data.clock_rate && 
+			cycle_data.accumulated_hazard + hazard < cycle_data.hazard_threshold )
+		{
+			cycle_data.accumulated_hazard += hazard; 
+			return; 
+		}
+	}
 
 	// Evaluate each linked phase: 
 	// advance to that phase IF probabiltiy is in the range, 
 	// and if the arrest function (if any) is false 
 	
-	int j; 
+	// the link to follow, and (with event_driven_transitions) the fraction 
+	// of the step at which it was completed 
+	int k_transition = -1; 
+	double transition_fraction = 2.0; 
+	
+	// with event_driven_transitions: the summed rate of the stochastic links 
+	// that are not arrested, and the link the clock picks if it rings 
+	double total_rate = 0.0; 
+	double u = cycle_data.link_choice; 
+	int k_stochastic = -1; 
+	
 	for( int k=0 ; k < phase_links[i].size() ; k++ )
 	{
-		j = phase_links[i][k].end_phase_index; 
-		
 		// check for arrest. If arrested, skip to the next transition
 		bool transition_arrested = false; 
 		if( phase_links[i][k].arrest_function )
 		{
 			transition_arrested = phase_links[i][k].arrest_function( pCell,phenotype,dt ); 
 		}
-		if( !transition_arrested )
+		if( transition_arrested )
+		{ continue; }
+		
+		double rate = cycle_data.transition_rates[ link_offsets[i] + k ]; 
+		
+		if( event_driven_transitions )
 		{
-			// check to see if we should transition 
-			bool continue_transition = false; 
 			if( phase_links[i][k].fixed_duration )
 			{
-				if( phenotype.cycle.data.elapsed_time_in_phase > 1.0/phenotype.cycle.data.transition_rates[i][k] )
+				double fraction = ( 1.0/rate - cycle_data.elapsed_time_in_phase )/dt + 1.0; 
+				if( cycle_data.elapsed_time_in_phase > 1.0/rate && fraction < transition_fraction )
 				{
-					continue_transition = true; 
+					k_transition = k; 
+					transition_fraction = fraction; 
 				}
 			}
-			else
+			else if( rate > 0.0 && pick_competing_rate( rate, total_rate, u ) )
+			{ k_stochastic = k; }
+			continue; 
+		}
+		
+		// check to see if we should transition 
+		bool continue_transition = false; 
+		if( phase_links[i][k].fixed_duration )
+		{
+			if( cycle_data.elapsed_time_in_phase > 1.0/rate )
 			{
-				double prob = phenotype.cycle.data.transition_rates[i][k]*dt; 
-				if( UniformRandom() <= prob )
-				{
-					continue_transition = true; 
-				}
+				continue_transition = true; 
 			}
-			
-			// if we should transition, check if we're not supposed to divide or die 
-			
-			if( continue_transition )
+		}
+		else
+		{
+			double prob = rate*dt; 
+			if( UniformRandom() <= prob )
 			{
-				// if the phase transition has an exit function, execute it
-				if( phase_links[i][k].exit_function )
-				{
-					phase_links[i][k].exit_function( pCell,phenotype,dt ); 
-				}
-				
-				// check if division or removal are required 
-				if( phases[i].division_at_phase_exit )
-				{
-					// pCell->flag_for_division();
-					phenotype.flagged_for_division = true; 
-				}
-				if( phases[i].removal_at_phase_exit )
-				{
-					// pCell->flag_for_removal(); 
-					phenotype.flagged_for_removal = true; 
-					return; 
-				}
-				// move to the next phase, and reset the elapsed time 
-				phenotype.cycle.data.current_phase_index = j; 
-				phenotype.cycle.data.elapsed_time_in_phase = 0.0; 
-				
-				// if the new phase has an entry function, execute it 
-				if( phases[j].entry_function )
-				{
-					phases[j].entry_function( pCell,phenotype,dt );  
-				}
-				
-				return; 
+				continue_transition = true; 
 			}
-			
 		}
 		
+		if( continue_transition )
+		{
+			k_transition = k; 
+			break; 
+		}
+	}
+	
+	// advance the clock, and see if it rang before any fixed-duration transition 
+	cycle_data.clock_rate = total_rate; 
+	if( total_rate > 0.0 )
+	{
+		double hazard = total_rate * dt; 
+		double hazard_before = cycle_data.accumulated_hazard; 
+		cycle_data.accumulated_hazard += hazard; 
+		if( cycle_data.accumulated_hazard >= cycle_data.hazard_threshold && 
+			( cycle_data.hazard_threshold - hazard_before ) / hazard < transition_fraction )
+		{ k_transition = k_stochastic; }
+	}
+	
+	if( k_transition < 0 )
+	{ return; }
+	
+	// if we should transition, check if we're not supposed to divide or die 
+	
+	int k = k_transition; 
+	int j = phase_links[i][k].end_phase_index; 
+	
+	// if the phase transition has an exit function, execute it
+	if( phase_links[i][k].exit_function )
+	{
+		phase_links[i][k].exit_function( pCell,phenotype,dt ); 
+	}
+	
+	// check if division or removal are required 
+	if( phases[i].division_at_phase_exit )
+	{
+		// pCell->flag_for_division();
+		phenotype.flagged_for_division = true; 
+	}
+	if( phases[i].removal_at_phase_exit )
+	{
+		// pCell->flag_for_removal(); 
+		phenotype.flagged_for_removal = true; 
+		return; 
+	}
+	// move to the next phase, and reset the elapsed time (and the clock) 
+	cycle_data.current_phase_index = j; 
+	cycle_data.elapsed_time_in_phase = 0.0; 
+	cycle_data.reset_transition_clock(); 
+	
+	// if the new phase has an entry function, execute it 
+	if( phases[j].entry_function )
+	{
+		phases[j].entry_function( pCell,phenotype,dt );  
 	}
 	
 	return; 
@@ -390,6 +537,17 @@ Death::Death()
 	dead = false; 
 	current_death_model_index = 0;
 	
+	reset_death_clock(); 
+	
+	return; 
+}
+
+void Death::reset_death_clock( void )
+{
+	accumulated_hazard = 0.0; 
+	hazard_threshold = -1.0; 
+	model_choice = 0.0; 
+	clock_rate = -1.0; 
 	return; 
 }
 
@@ -440,6 +598,52 @@ bool Death::check_for_death( double dt )
 		return false;
 	} 
 	
+	if( event_driven_transitions )
+	{
+		if( hazard_threshold < 0.0 )
+		{
+			accumulated_hazard = 0.0; 
+			hazard_threshold = draw_hazard_threshold(); 
+			model_choice = UniformRandom(); 
+		}
+		
+		// skip the step if the rates still sum to those of the last step, and 
+		// the clock does not ring in this step 
+		if( clock_rate >= 0.0 )
+		{
+			double total_rate = 0.0; 
+			for( int i=0 ; i < rates.size() ; i++ )
+			{
+				if( rates[i] > 0.0 )
+				{ total_rate += rates[i]; }
+			}
+			double hazard = total_rate * dt; 
+			if( total_rate == clock_rate && accumulated_hazard + hazard < hazard_threshold )
+			{
+				accumulated_hazard += hazard; 
+				return false; 
+			}
+		}
+		
+		double total_rate = 0.0; 
+		double u = model_choice; 
+		int i_death = -1; 
+		for( int i=0 ; i < rates.size() ; i++ )
+		{
+			if( rates[i] > 0.0 && pick_competing_rate( rates[i], total_rate, u ) )
+			{ i_death = i; }
+		}
+		
+		clock_rate = total_rate; 
+		accumulated_hazard += total_rate * dt; 
+		if( total_rate > 0.0 && accumulated_hazard >= hazard_threshold )
+		{
+			dead = true; 
+			current_death_model_index = i_death; 
+		}
+		return dead; 
+	}
+	
 	// If the cell is alive, evaluate all the 
 	// death rates for each registered death type. 
 	int i = 0; 
@@ -526,6 +730,7 @@ void Cycle::sync_to_cycle_model( Cycle_Model& cm )
 {
 	pCycle_Model = &cm; 
 	data = cm.data; 
+	data.pCycle_Model = &cm; 
 	return; 
 }	
 
@@ -952,6 +1157,10 @@ void Molecular::sync_to_microenvironment( Microenvironment* pNew_Microenvironmen
 
 void Molecular::sync_to_cell( Basic_Agent* pCell )
 {
+	// a reused cell (see Cell_Pool) is already synced 
+	if( pCell->internalized_substrates == &internalized_total_substrates )
+	{ return; }
+	
 	delete pCell->internalized_substrates;
 	pCell->internalized_substrates = &internalized_total_substrates;
 	
@@ -1039,6 +1248,40 @@ Cell_Functions::Cell_Functions()
 	return; 
 }
 
+Shared_Cycle_Model::Shared_Cycle_Model()
+{
+	pModel.reset(); 
+	return; 
+}
+
+Shared_Cycle_Model& Shared_Cycle_Model::operator=( const Cycle_Model& model )
+{
+	pModel = std::make_shared<Cycle_Model>( model ); 
+	return *this; 
+}
+
+Cycle_Model& Shared_Cycle_Model::model( void )
+{
+	if( !pModel )
+	{ pModel = std::make_shared<Cycle_Model>(); }
+	return *pModel; 
+}
+
+Shared_Cycle_Model::operator Cycle_Model&( void )
+{
+	return model(); 
+}
+
+Cycle_Model* Shared_Cycle_Model::operator->( void )
+{
+	return &model(); 
+}
+
+long Shared_Cycle_Model::use_count( void ) const
+{
+	return pModel.use_count(); 
+}
+
 void Phenotype::sync_to_functions( Cell_Functions& functions )
 {
 	cycle.sync_to_cycle_model( functions.cycle_model );  
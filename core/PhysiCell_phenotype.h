@@ -72,6 +72,7 @@
 #include <string>
 #include <unordered_map>
 #include <map> 
+#include <memory>
 
 #include "../BioFVM/BioFVM.h" 
 
@@ -84,6 +85,31 @@ class Cell;
 class Cycle_Model; 
 class Phenotype; 
 
+/* 
+ With event_driven_transitions, the stochastic cycle transitions and death 
+ models no longer draw a random number every phenotype step. Instead, the 
+ links out of a cell's current phase share one exponential clock (and its 
+ death models share another): an Exp(1) threshold drawn once, when the cell 
+ enters the phase (or, for death, once per cell), and the total hazard 
+ (sum of the rates)*dt accumulated every step since then. The event happens 
+ in the step where the hazard reaches the threshold, and follows each link 
+ (death model) with probability proportional to its rate in that step. 
+ 
+ This samples the exact continuous-time waiting times for rates that are 
+ constant over each step, and since the hazard is accumulated from the 
+ current rates, any change to the rates (e.g., by update_phenotype) takes 
+ effect from the next step without rescheduling. Arrested transitions do 
+ not accumulate hazard, and fixed-duration transitions are unchanged. 
+ 
+ Between events, a cell whose rates still sum to those of its last step 
+ (and whose phase has no arrest functions or fixed durations) only adds 
+ rate*dt to its hazard: the links are not evaluated, and no link is picked, 
+ until the step in which the clock rings or the rates change. 
+ (new in 1.7.2) 
+*/
+
+extern bool event_driven_transitions; 
+
 /*
 // future use?
 class BM_Point
@@ -136,25 +162,38 @@ class Cycle_Data
 {
  private:
  
-	// this maps the end_phase_index to the link index in each 
-	// phase_links[i]
-	// So, index_inverse_map[i][j] = k, corresponds to 
-	// phases[i], phase_links[i][k] (which links from phase i to phase j)
-	// transition_rates[i][k] (the transition rate from phase i to phase j) 
-	std::vector< std::unordered_map<int,int> > inverse_index_maps; 
-	
  public:
 	Cycle_Model* pCycle_Model; 
 
 	std::string time_units; 
 	
-	std::vector< std::vector<double> > transition_rates; 
+	// the transition rates of all the phase links, phase by phase, so that the 
+	// rate of phase_links[i][k] is transition_rates[ pCycle_Model->link_index(i,k) ]. 
+	// (One flat vector since 1.7.2: the mapping from end phases to links 
+	// is only stored in the cycle model, rather than copied into every cell.) 
+	std::vector<double> transition_rates; 
 	
 	int current_phase_index; 
 	double elapsed_time_in_phase; 
 	
+	// the clock of the links out of the current phase, for 
+	// event_driven_transitions: the phase it was drawn for (-1 if none), 
+	// the accumulated hazard, its threshold, and a uniform random number 
+	// that picks the link once it rings. clock_rate is the summed rate at 
+	// the last full evaluation (negative if none): while the rates still sum 
+	// to it and the clock cannot ring in the step, the step is skipped 
+	// (new in 1.7.2) 
+	int clock_phase_index; 
+	double accumulated_hazard; 
+	double hazard_threshold; 
+	double link_choice; 
+	double clock_rate; 
+	
 	Cycle_Data(); // done 
 	
+	// discard the clock, so that a new one is drawn at the next step 
+	void reset_transition_clock( void ); 
+	
 	// return current phase (by reference)
 	Phase& current_phase( void ); // done 
 	
@@ -177,8 +216,12 @@ class Cycle_Model
 	// phase_links[i]
 	// So, index_inverse_map[i][j] = k, corresponds to 
 	// phases[i], phase_links[i][k] (which links from phase i to phase j)
-	// transition_rates[i][k] (the transition rate from phase i to phase j)
+	// data.transition_rates[ link_index(i,k) ] (the transition rate from phase i to phase j)
 	std::vector< std::unordered_map<int,int> > inverse_index_maps; 
+	
+	// the position of phase_links[i][0] among all the links (and the number 
+	// of links at the end), to index Cycle_Data::transition_rates -- 1.7.2 
+	std::vector<int> link_offsets; 
  
  public:
 	std::string name; 
@@ -192,6 +235,9 @@ class Cycle_Model
 	Cycle_Data data; // this will be copied to individual cell agents 
 
 	Cycle_Model(); 
+	// copies point their data to themselves (new in 1.7.2) 
+	Cycle_Model( const Cycle_Model& copy_me ); 
+	Cycle_Model& operator=( const Cycle_Model& copy_me ); 
 	
 	void advance_model( Cell* pCell, Phenotype& phenotype, double dt ); // done 
 	
@@ -208,6 +254,13 @@ class Cycle_Model
 	double& transition_rate( int start_index , int end_index ); // done 
 	Phase_Link& phase_link(int start_index,int end_index ); // done 
 	
+	// the position of phase_links[i][k] in Cycle_Data::transition_rates, 
+	// and the number of links (new in 1.7.2) 
+	int link_index( int start_index , int link ) const; 
+	int number_of_links( void ) const; 
+	// the position of the link from phase i to phase j 
+	int find_link_index( int start_index , int end_index ); 
+	
 	std::ostream& display( std::ostream& os ); // done 
 };
 
@@ -259,6 +312,14 @@ class Death
 	bool dead; 
 	int current_death_model_index;
 	
+	// the clock of the death models, for event_driven_transitions (a 
+	// negative threshold if none has been drawn), as in Cycle_Data 
+	// (new in 1.7.2) 
+	double accumulated_hazard; 
+	double hazard_threshold; 
+	double model_choice; 
+	double clock_rate; 
+	
 	Death(); // done 
 	
 	int add_death_model( double rate, Cycle_Model* pModel );  // done
@@ -270,6 +331,9 @@ class Death
 	bool check_for_death( double dt ); // done
 	void trigger_death( int death_model_index ); // done 
 	
+	// discard the clock, so that a new one is drawn at the next step 
+	void reset_death_clock( void ); 
+	
 	Cycle_Model& current_model( void ); // done
 	Death_Parameters& current_parameters( void ); // done 
 };
@@ -429,11 +493,42 @@ class Secretion
 	void scale_all_uptake_by_factor( double factor ); // NEW
 };
 
+/* 
+ The cycle model of a cell definition, shared (and reference counted) by all 
+ of its cells: copying Cell_Functions copies a pointer, rather than all of the 
+ model's phases and links. Assigning a Cycle_Model makes one shared copy of 
+ it, so that 
+ 
+	pCD->functions.cycle_model = Ki67_advanced; 
+ 
+ works as before. Treat the shared model as read-only once cells use it; to 
+ change the model of a definition, assign a new one. Cells already using the 
+ old model keep it alive. (new in 1.7.2) 
+*/
+
+class Shared_Cycle_Model
+{
+ private:
+	std::shared_ptr<Cycle_Model> pModel; 
+	
+ public:
+	Shared_Cycle_Model(); 
+	Shared_Cycle_Model& operator=( const Cycle_Model& model ); 
+	
+	// the model (an empty one is created on first use) 
+	Cycle_Model& model( void ); 
+	operator Cycle_Model&( void ); 
+	Cycle_Model* operator->( void ); 
+	
+	// how many copies of Cell_Functions share the model 
+	long use_count( void ) const; 
+};
+
 class Cell_Functions
 {
  private:
  public:
-	Cycle_Model cycle_model; 
+	Shared_Cycle_Model cycle_model; 
 
 	void (*volume_update_function)( Cell* pCell, Phenotype& phenotype , double dt ); // used in cell 
 	void (*update_migration_bias)( Cell* pCell, Phenotype& phenotype, double dt ); 
@@ -0,0 +1,210 @@
+/*
+###############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the version #
+# number, such as below:                                                      #
+#                                                                             #
+# We implemented and solved the model using PhysiCell (Version x.y.z) [1].    #
+#                                                                             #
+# [1] A Ghaffarizadeh, R Heiland, SH Friedman, SM Mumenthaler, and P Macklin, #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for Multicellu-  #
+#     lar Systems, PLoS Comput. Biol. 14(2): e1005991, 2018                   #
+#     DOI: 10.1371/journal.pcbi.1005991                                       #
+#                                                                             #
+# See VERSION.txt or call get_PhysiCell_version() to get the current version  #
+#     x.y.z. Call display_citations() to get detailed information on all cite-#
+#     able software used in your PhysiCell application.                       #
+#                                                                             #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite BioFVM  #
+#     as below:                                                               #
+#                                                                             #
+# We implemented and solved the model using PhysiCell (Version x.y.z) [1],    #
+# with BioFVM [2] to solve the transport equations.                           #
+#                                                                             #
+# [1] A Ghaffarizadeh, R Heiland, SH Friedman, SM Mumenthaler, and P Macklin, #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for Multicellu-  #
+#     lar Systems, PLoS Comput. Biol. 14(2): e1005991, 2018                   #
+#     DOI: 10.1371/journal.pcbi.1005991                                       #
+#                                                                             #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient para- #
+#     llelized diffusive transport solver for 3-D biological simulations,     #
+#     Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730  #
+#                                                                             #
+###############################################################################
+#                                                                             #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)     #
+#                                                                             #
+# Copyright (c) 2015-2018, Paul Macklin and the PhysiCell Project             #
+# All rights reserved.                                                        #
+#                                                                             #
+# Redistribution and use in source and binary forms, with or without          #
+# modification, are permitted provided that the following conditions are met: #
+#                                                                             #
+# 1. Redistributions of source code must retain the above copyright notice,   #
+# this list of conditions and the following disclaimer.                       #
+#                                                                             #
+# 2. Redistributions in binary form must reproduce the above copyright        #
+# notice, this list of conditions and the following disclaimer in the         #
+# documentation and/or other materials provided with the distribution.        #
+#                                                                             #
+# 3. Neither the name of the copyright holder nor the names of its            #
+# contributors may be used to endorse or promote products derived from this   #
+# software without specific prior written permission.                         #
+#                                                                             #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" #
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   #
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  #
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   #
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         #
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        #
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    #
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     #
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     #
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  #
+# POSSIBILITY OF SUCH DAMAGE.                                                 #
+#                                                                             #
+###############################################################################
+*/
+
+
+#include <cmath>
+
+#include "./PhysiCell_scheduler.h"
+
+namespace PhysiCell{
+
+Step_Scheduler step_scheduler; 
+
+Scheduled_Stage::Scheduled_Stage()
+{
+	name = "unnamed"; 
+	period = 1.0; 
+	offset = 0.0; 
+	
+	has_run = false; 
+	last_tick = 0; 
+	
+	function = NULL; 
+	return; 
+}
+
+Step_Scheduler::Step_Scheduler()
+{
+	tick_length = 0.01; 
+	return; 
+}
+
+void Step_Scheduler::set_tick_length( double dt )
+{
+	tick_length = dt; 
+	return; 
+}
+
+double Step_Scheduler::get_tick_length( void ) const
+{ return tick_length; }
+
+long long Step_Scheduler::tick( double t ) const
+{ return llround( t / tick_length ); }
+
+long long Step_Scheduler::period_in_ticks( int stage ) const
+{
+	long long ticks = llround( stages[stage].period / tick_length ); 
+	if( ticks < 1 )
+	{ return 1; }
+	return ticks; 
+}
+
+int Step_Scheduler::register_stage( std::string name , double period , double offset , 
+	void (*function)( double , double ) )
+{
+	int stage = find_stage( name ); 
+	if( stage >= 0 )
+	{ return stage; }
+	
+	Scheduled_Stage new_stage; 
+	new_stage.name = name; 
+	new_stage.period = period; 
+	new_stage.offset = offset; 
+	new_stage.function = function; 
+	stages.push_back( new_stage ); 
+	
+	return stages.size() - 1; 
+}
+
+int Step_Scheduler::find_stage( std::string name ) const
+{
+	for( unsigned int i=0; i < stages.size() ; i++ )
+	{
+		if( stages[i].name == name )
+		{ return i; }
+	}
+	return -1; 
+}
+
+int Step_Scheduler::number_of_stages( void ) const
+{ return stages.size(); }
+
+Scheduled_Stage& Step_Scheduler::operator[]( int stage )
+{ return stages[stage]; }
+
+void Step_Scheduler::set_period( int stage , double period )
+{
+	stages[stage].period = period; 
+	return; 
+}
+
+void Step_Scheduler::restart( int stage , double t )
+{
+	stages[stage].offset = t; 
+	stages[stage].has_run = false; 
+	return; 
+}
+
+bool Step_Scheduler::is_due( int stage , double t ) const
+{
+	const Scheduled_Stage& S = stages[stage]; 
+	long long now = tick( t ); 
+	if( S.has_run == false )
+	{ return now >= tick( S.offset ); }
+	return now - S.last_tick >= period_in_ticks( stage ); 
+}
+
+double Step_Scheduler::start( int stage , double t )
+{
+	Scheduled_Stage& S = stages[stage]; 
+	long long now = tick( t ); 
+	long long elapsed = period_in_ticks( stage ); 
+	if( S.has_run )
+	{ elapsed = now - S.last_tick; }
+	
+	S.has_run = true; 
+	S.last_tick = now; 
+	return elapsed * tick_length; 
+}
+
+void Step_Scheduler::run_due_functions( double t )
+{
+	for( unsigned int i=0; i < stages.size() ; i++ )
+	{
+		if( stages[i].function && is_due( i , t ) )
+		{
+			double dt = start( i , t ); 
+			stages[i].function( t , dt ); 
+		}
+	}
+	return; 
+}
+
+void Step_Scheduler::display( std::ostream& os ) const
+{
+	os << "Scheduled stages (ticks of " << tick_length << "):" << std::endl; 
+	for( unsigned int i=0; i < stages.size() ; i++ )
+	{
+		os << "\t" << stages[i].name << ": every " << period_in_ticks( i ) << " ticks"; 
+		if( stages[i].offset != 0.0 )
+		{ os << ", from tick " << tick( stages[i].offset ); }
+		os << std::endl; 
+	}
+	return; 
+}
+
+};
@@ -0,0 +1,158 @@
+/*
+###############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the version #
+# number, such as below:                                                      #
+#                                                                             #
+# We implemented and solved the model using PhysiCell (Version x.y.z) [1].    #
+#                                                                             #
+# [1] A Ghaffarizadeh, R Heiland, SH Friedman, SM Mumenthaler, and P Macklin, #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for Multicellu-  #
+#     lar Systems, PLoS Comput. Biol. 14(2): e1005991, 2018                   #
+#     DOI: 10.1371/journal.pcbi.1005991                                       #
+#                                                                             #
+# See VERSION.txt or call get_PhysiCell_version() to get the current version  #
+#     x.y.z. Call display_citations() to get detailed information on all cite-#
+#     able software used in your PhysiCell application.                       #
+#                                                                             #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite BioFVM  #
+#     as below:                                                               #
+#                                                                             #
+# We implemented and solved the model using PhysiCell (Version x.y.z) [1],    #
+# with BioFVM [2] to solve the transport equations.                           #
+#                                                                             #
+# [1] A Ghaffarizadeh, R Heiland, SH Friedman, SM Mumenthaler, and P Macklin, #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for Multicellu-  #
+#     lar Systems, PLoS Comput. Biol. 14(2): e1005991, 2018                   #
+#     DOI: 10.1371/journal.pcbi.1005991                                       #
+#                                                                             #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient para- #
+#     llelized diffusive transport solver for 3-D biological simulations,     #
+#     Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730  #
+#                                                                             #
+###############################################################################
+#                                                                             #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)     #
+#                                                                             #
+# Copyright (c) 2015-2018, Paul Macklin and the PhysiCell Project             #
+# All rights reserved.                                                        #
+#                                                                             #
+# Redistribution and use in source and binary forms, with or without          #
+# modification, are permitted provided that the following conditions are met: #
+#                                                                             #
+# 1. Redistributions of source code must retain the above copyright notice,   #
+# this list of conditions and the following disclaimer.                       #
+#                                                                             #
+# 2. Redistributions in binary form must reproduce the above copyright        #
+# notice, this list of conditions and the following disclaimer in the         #
+# documentation and/or other materials provided with the distribution.        #
+#                                                                             #
+# 3. Neither the name of the copyright holder nor the names of its            #
+# contributors may be used to endorse or promote products derived from this   #
+# software without specific prior written permission.                         #
+#                                                                             #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" #
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE   #
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE  #
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE   #
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR         #
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF        #
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS    #
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN     #
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)     #
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE  #
+# POSSIBILITY OF SUCH DAMAGE.                                                 #
+#                                                                             #
+###############################################################################
+*/
+
+
+#ifndef __PhysiCell_scheduler_h__
+#define __PhysiCell_scheduler_h__
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+namespace PhysiCell{
+
+/* 
+ The step scheduler decides when each stage of a simulation step (secretion, 
+ phenotype, gradients, mechanics, custom rules, outputs, ...) runs. Simulated 
+ time is counted in integer ticks of tick_length (the diffusion step), and a 
+ stage runs once every period, starting at its offset. Since times are rounded 
+ to ticks before they are compared, round-off in the simulated time does not 
+ accumulate into skipped or repeated steps. (new in 1.7.2) 
+ 
+ Offsets stagger stages with equal periods (e.g., phenotype and mechanics) so 
+ that their costs fall into different diffusion steps. Stages registered with 
+ a function are run by run_due_functions, which update_all_cells calls after 
+ the built-in stages; projects can add stages this way without editing the 
+ main loop. 
+*/
+
+class Scheduled_Stage
+{
+ private:
+ public:
+	std::string name; 
+	// in time units; rounded to ticks when compared 
+	double period; 
+	double offset; 
+	
+	bool has_run; 
+	long long last_tick; 
+	
+	// optional: called with ( t , time since the last run ) 
+	void (*function)( double , double ); 
+	
+	Scheduled_Stage(); 
+};
+
+class Step_Scheduler
+{
+ private:
+	double tick_length; 
+	std::vector<Scheduled_Stage> stages; 
+	
+	long long period_in_ticks( int stage ) const; 
+	
+ public:
+	Step_Scheduler(); 
+	
+	void set_tick_length( double dt ); 
+	double get_tick_length( void ) const; 
+	// the tick nearest to time t 
+	long long tick( double t ) const; 
+	
+	// add a stage, or return the index of the stage that already has this name 
+	// (so that settings can register a stage with its offset before the code 
+	// that runs it does) 
+	int register_stage( std::string name , double period , double offset = 0.0 , 
+		void (*function)( double , double ) = NULL ); 
+	// -1 if there is no stage of this name 
+	int find_stage( std::string name ) const; 
+	int number_of_stages( void ) const; 
+	Scheduled_Stage& operator[]( int stage ); 
+	
+	void set_period( int stage , double period ); 
+	// make the stage due at time t, and every period after 
+	void restart( int stage , double t ); 
+	
+	// true if the stage should run at time t: it never ran and t is past its 
+	// offset, or a period has passed since it last ran 
+	bool is_due( int stage , double t ) const; 
+	// record that the stage runs at time t, and return the time since it last 
+	// ran (one period for its first run) 
+	double start( int stage , double t ); 
+	
+	// start and call the functions of all registered stages that are due 
+	void run_due_functions( double t ); 
+	
+	void display( std::ostream& os ) const; 
+};
+
+extern Step_Scheduler step_scheduler; 
+
+};
+
+#endif
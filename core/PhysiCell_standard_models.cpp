@@ -581,26 +581,43 @@ void standard_update_cell_velocity( Cell* pCell, Phenotype& phenotype, double dt
 	
 	pCell->state.simple_pressure = 0.0; 
 	
+	// use the packed mechanics data if this step has it -- 1.7.2 
+	Mechanics_Engine& engine = pCell->get_container()->mechanics_engine; 
+	if( engine.is_packed( pCell ) )
+	{
+		engine.add_cell_cell_forces( pCell ); 
+		
+		pCell->update_motility_vector(dt); 
+		pCell->velocity += phenotype.motility.motility_vector; 
+		return; 
+	}
+	
 	//First check the neighbors in my current voxel
+	// (through the container, which may hash its voxels -- 1.7.2) 
+	Cell_Container* pContainer = pCell->get_container(); 
+	int voxel = pCell->get_current_mechanics_voxel_index(); 
 	std::vector<Cell*>::iterator neighbor;
-	std::vector<Cell*>::iterator end = pCell->get_container()->agent_grid[pCell->get_current_mechanics_voxel_index()].end();
-	for(neighbor = pCell->get_container()->agent_grid[pCell->get_current_mechanics_voxel_index()].begin(); neighbor != end; ++neighbor)
+	std::vector<Cell*>::iterator end = pContainer->cells_in_voxel(voxel).end();
+	for(neighbor = pContainer->cells_in_voxel(voxel).begin(); neighbor != end; ++neighbor)
 	{
 		pCell->add_potentials(*neighbor);
 	}
-	std::vector<int>::iterator neighbor_voxel_index;
-	std::vector<int>::iterator neighbor_voxel_index_end = 
-		pCell->get_container()->underlying_mesh.moore_connected_voxel_indices[pCell->get_current_mechanics_voxel_index()].end();
-
-	for( neighbor_voxel_index = 
-		pCell->get_container()->underlying_mesh.moore_connected_voxel_indices[pCell->get_current_mechanics_voxel_index()].begin();
-		neighbor_voxel_index != neighbor_voxel_index_end; 
-		++neighbor_voxel_index )
+	int moore[26]; 
+	int number_of_neighbors = pContainer->moore_neighborhood( voxel , moore ); 
+	double center[3]; 
+	double other_center[3]; 
+	pContainer->underlying_mesh.voxel_center( voxel , center ); 
+
+	for( int m=0; m < number_of_neighbors ; m++ )
 	{
-		if(!is_neighbor_voxel(pCell, pCell->get_container()->underlying_mesh.voxels[pCell->get_current_mechanics_voxel_index()].center, pCell->get_container()->underlying_mesh.voxels[*neighbor_voxel_index].center, *neighbor_voxel_index))
+		std::vector<Cell*>& other = pContainer->cells_in_voxel( moore[m] ); 
+		if( other.size() == 0 )
+			continue; 
+		pContainer->underlying_mesh.voxel_center( moore[m] , other_center ); 
+		if(!is_neighbor_voxel(pCell, center, other_center, moore[m]))
 			continue;
-		end = pCell->get_container()->agent_grid[*neighbor_voxel_index].end();
-		for(neighbor = pCell->get_container()->agent_grid[*neighbor_voxel_index].begin();neighbor != end; ++neighbor)
+		end = other.end();
+		for(neighbor = other.begin();neighbor != end; ++neighbor)
 		{
 			pCell->add_potentials(*neighbor);
 		}
@@ -72,15 +72,264 @@
 
 #include <iostream>
 #include <fstream>
+#include <omp.h>
 
 namespace PhysiCell{
 
 std::random_device rd;
 std::mt19937 gen(rd());
 
+// one generator per OpenMP thread, for random numbers drawn in parallel regions. 
+// They are seeded from the seed and the thread number, so that they do not 
+// draw from gen. -- 1.7.2 
+std::vector<std::mt19937> thread_generators; 
+static unsigned long thread_generator_seed = rd(); 
+// and one counter-based stream per thread (see Random_Stream) 
+std::vector<Random_Stream> thread_random_streams; 
+
+void prepare_thread_random_generators( void )
+{
+	int threads = omp_get_max_threads(); 
+	while( (int) thread_generators.size() < threads )
+	{
+		std::seed_seq seeds{ thread_generator_seed , (unsigned long) thread_generators.size() }; 
+		thread_generators.push_back( std::mt19937( seeds ) ); 
+	}
+	if( (int) thread_random_streams.size() < threads )
+	{ thread_random_streams.resize( threads ); }
+	return; 
+}
+
+// counter-based streams -- 1.7.2 
+bool counter_based_random_numbers = false; 
+static unsigned long long counter_random_seed = thread_generator_seed; 
+static unsigned int random_step = 0; 
+static Random_Stream serial_random_stream; 
+// the keys of the unkeyed streams (cell IDs are far below them) 
+static const unsigned int serial_stream_key = 0xFFFFFFFF; 
+
+void philox4x32( const unsigned int* counter , const unsigned int* key , unsigned int* output )
+{
+	unsigned int c0 = counter[0]; 
+	unsigned int c1 = counter[1]; 
+	unsigned int c2 = counter[2]; 
+	unsigned int c3 = counter[3]; 
+	unsigned int k0 = key[0]; 
+	unsigned int k1 = key[1]; 
+	for( int r=0; r < 10 ; r++ )
+	{
+		unsigned long long p0 = 0xD2511F53ull * c0; 
+		unsigned long long p1 = 0xCD9E8D57ull * c2; 
+		c0 = (unsigned int)( p1 >> 32 ) ^ c1 ^ k0; 
+		c1 = (unsigned int) p1; 
+		c2 = (unsigned int)( p0 >> 32 ) ^ c3 ^ k1; 
+		c3 = (unsigned int) p0; 
+		k0 += 0x9E3779B9; 
+		k1 += 0xBB67AE85; 
+	}
+	output[0] = c0; 
+	output[1] = c1; 
+	output[2] = c2; 
+	output[3] = c3; 
+	return; 
+}
+
+// 53 random bits in [0,1) 
+static inline double uniform_from_bits( unsigned int a , unsigned int b )
+{ return ( ( a >> 5 ) * 67108864.0 + ( b >> 6 ) ) * ( 1.0 / 9007199254740992.0 ); }
+
+Random_Stream::Random_Stream()
+{
+	key[0] = 0; 
+	key[1] = 0; 
+	counter[0] = 0; 
+	counter[1] = 0; 
+	counter[2] = 0; 
+	counter[3] = 0; 
+	used = 4; 
+	has_spare_normal = false; 
+	spare_normal = 0.0; 
+	
+	// not set yet 
+	step = 0xFFFFFFFF; 
+	stream_key = 0; 
+}
+
+void Random_Stream::set( unsigned long long seed , unsigned int stream_key_ , unsigned int step_ )
+{
+	key[0] = (unsigned int) seed; 
+	key[1] = (unsigned int)( seed >> 32 ); 
+	counter[0] = 0; 
+	counter[1] = 0; 
+	counter[2] = stream_key_; 
+	counter[3] = step_; 
+	used = 4; 
+	has_spare_normal = false; 
+	
+	step = step_; 
+	stream_key = stream_key_; 
+	return; 
+}
+
+unsigned int Random_Stream::next_uint32( void )
+{
+	if( used == 4 )
+	{
+		philox4x32( counter , key , block ); 
+		if( ++counter[0] == 0 )
+		{ counter[1]++; }
+		used = 0; 
+	}
+	return block[used++]; 
+}
+
+double Random_Stream::uniform( void )
+{
+	// each double takes an aligned pair of the block 
+	if( used > 2 )
+	{ used = 4; }
+	unsigned int a = next_uint32(); 
+	unsigned int b = next_uint32(); 
+	return uniform_from_bits( a , b ); 
+}
+
+double Random_Stream::normal( double mean , double standard_deviation )
+{
+	if( has_spare_normal )
+	{
+		has_spare_normal = false; 
+		return mean + standard_deviation * spare_normal; 
+	}
+	
+	// Box-Muller, keeping the second number 
+	static double two_pi = 6.283185307179586476925286766559; 
+	double r = sqrt( -2.0 * log( 1.0 - uniform() ) ); 
+	double theta = two_pi * uniform(); 
+	spare_normal = r * sin( theta ); 
+	has_spare_normal = true; 
+	return mean + standard_deviation * r * cos( theta ); 
+}
+
+void Random_Stream::uniform( double* values , int n )
+{
+	// finish the current block, so that the rest starts at a fresh counter 
+	int i = 0; 
+	while( i < n && used < 4 )
+	{ values[i++] = uniform(); }
+	
+	// then whole blocks (two numbers each), independent of each other. This 
+	// gives the same numbers as calling uniform() n times. 
+	int blocks = ( n - i ) / 2; 
+	unsigned long long draw = counter[0] + ( (unsigned long long) counter[1] << 32 ); 
+	double* pOut = values + i; 
+	for( int k=0; k < blocks ; k++ )
+	{
+		unsigned long long this_draw = draw + k; 
+		unsigned int this_counter[4] = { (unsigned int) this_draw , (unsigned int)( this_draw >> 32 ) , counter[2] , counter[3] }; 
+		unsigned int output[4]; 
+		philox4x32( this_counter , key , output ); 
+		pOut[2*k] = uniform_from_bits( output[0] , output[1] ); 
+		pOut[2*k+1] = uniform_from_bits( output[2] , output[3] ); 
+	}
+	draw += blocks; 
+	counter[0] = (unsigned int) draw; 
+	counter[1] = (unsigned int)( draw >> 32 ); 
+	i += 2*blocks; 
+	
+	while( i < n )
+	{ values[i++] = uniform(); }
+	return; 
+}
+
+void Random_Stream::normal( double* values , int n , double mean , double standard_deviation )
+{
+	int i = 0; 
+	if( n > 0 && has_spare_normal )
+	{ values[i++] = normal( mean , standard_deviation ); }
+	
+	// uniforms for whole pairs, transformed in place (Box-Muller) 
+	static double two_pi = 6.283185307179586476925286766559; 
+	int pairs = ( n - i ) / 2; 
+	double* pOut = values + i; 
+	uniform( pOut , 2*pairs ); 
+	for( int k=0; k < pairs ; k++ )
+	{
+		double r = sqrt( -2.0 * log( 1.0 - pOut[2*k] ) ); 
+		double theta = two_pi * pOut[2*k+1]; 
+		pOut[2*k] = mean + standard_deviation * r * cos( theta ); 
+		pOut[2*k+1] = mean + standard_deviation * r * sin( theta ); 
+	}
+	i += 2*pairs; 
+	
+	if( i < n )
+	{ values[i++] = normal( mean , standard_deviation ); }
+	return; 
+}
+
+// the stream that the calling thread draws from, and the key it has when unkeyed. 
+// (omp_get_level, unlike omp_in_parallel, also counts parallel regions with 
+// one thread, so that serial code never continues a cell's stream.) 
+static Random_Stream& thread_random_stream( unsigned int& unkeyed_key )
+{
+	unkeyed_key = serial_stream_key; 
+	if( omp_get_level() > 0 )
+	{
+		unsigned int thread = omp_get_thread_num(); 
+		if( thread < thread_random_streams.size() )
+		{
+			unkeyed_key = serial_stream_key - 1 - thread; 
+			return thread_random_streams[thread]; 
+		}
+	}
+	return serial_random_stream; 
+}
+
+// the calling thread's stream, moved to the current step if needed 
+static Random_Stream& random_stream( void )
+{
+	unsigned int unkeyed_key; 
+	Random_Stream& stream = thread_random_stream( unkeyed_key ); 
+	if( stream.step != random_step )
+	{ stream.set( counter_random_seed , unkeyed_key , random_step ); }
+	return stream; 
+}
+
+unsigned int advance_random_step( void )
+{
+	prepare_thread_random_generators(); 
+	return ++random_step; 
+}
+
+void key_random_stream( int key )
+{
+	unsigned int unkeyed_key; 
+	thread_random_stream( unkeyed_key ).set( counter_random_seed , (unsigned int) key , random_step ); 
+	return; 
+}
+
+// gen outside of parallel regions (so that serial runs are unchanged), the 
+// thread's own generator inside of them 
+static std::mt19937& random_generator( void )
+{
+	if( omp_in_parallel() )
+	{
+		unsigned int thread = omp_get_thread_num(); 
+		if( thread < thread_generators.size() )
+		{ return thread_generators[thread]; }
+	}
+	return gen; 
+}
+
 long SeedRandom( long input )
 {
 	gen.seed(input);
+	thread_generator_seed = input; 
+	thread_generators.clear(); 
+	counter_random_seed = input; 
+	random_step = 0; 
+	serial_random_stream = Random_Stream(); 
+	thread_random_streams.clear(); 
+	prepare_thread_random_generators(); 
 	return input;
 }
 
@@ -89,18 +338,53 @@ long SeedRandom( void )
 { 
 	unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
 	gen.seed(seed);
+	thread_generator_seed = seed; 
+	thread_generators.clear(); 
+	counter_random_seed = seed; 
+	random_step = 0; 
+	serial_random_stream = Random_Stream(); 
+	thread_random_streams.clear(); 
+	prepare_thread_random_generators(); 
 	return seed;
 }
 
 double UniformRandom()
 {
-	return std::generate_canonical<double, 10>(gen);
+	if( counter_based_random_numbers )
+	{ return random_stream().uniform(); }
+	return std::generate_canonical<double, 10>( random_generator() );
 }
 
 double NormalRandom( double mean, double standard_deviation )
 {
+	if( counter_based_random_numbers )
+	{ return random_stream().normal( mean , standard_deviation ); }
 	std::normal_distribution<> d(mean,standard_deviation);
-	return d(gen); 
+	return d( random_generator() ); 
+}
+
+void UniformRandom( double* values , int n )
+{
+	if( counter_based_random_numbers )
+	{
+		random_stream().uniform( values , n ); 
+		return; 
+	}
+	for( int i=0; i < n ; i++ )
+	{ values[i] = UniformRandom(); }
+	return; 
+}
+
+void NormalRandom( double* values , int n , double mean, double standard_deviation )
+{
+	if( counter_based_random_numbers )
+	{
+		random_stream().normal( values , n , mean , standard_deviation ); 
+		return; 
+	}
+	for( int i=0; i < n ; i++ )
+	{ values[i] = NormalRandom( mean , standard_deviation ); }
+	return; 
 }
 
 std::vector<double> UniformOnUnitSphere( void )
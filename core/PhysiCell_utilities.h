@@ -83,6 +83,73 @@ long SeedRandom( void );
 
 double UniformRandom( void );
 double NormalRandom( double mean, double standard_deviation );
+
+// make sure each OpenMP thread has its own generator (seeded from the main 
+// one), so that UniformRandom and NormalRandom can be called in parallel 
+// regions. SeedRandom reseeds all of them. -- 1.7.2 
+void prepare_thread_random_generators( void ); 
+
+// fill values with n draws at once (from the same generator as above) -- 1.7.2 
+void UniformRandom( double* values , int n ); 
+void NormalRandom( double* values , int n , double mean, double standard_deviation ); 
+
+/* 
+ Counter-based random numbers (new in 1.7.2). Philox4x32-10 (Salmon et al., 
+ SC 2011) turns a 128-bit counter and a 64-bit key into 128 random bits, with 
+ no state in between. A Random_Stream keys it with the seed, and counts 
+ (draw number, stream key, step), so every draw is a function of those alone: 
+ a cell's numbers do not depend on which thread handles it, or how many 
+ threads there are. 
+ 
+ With counter_based_random_numbers, UniformRandom and NormalRandom draw from 
+ such streams. Each OpenMP thread has its own. A parallel loop over cells 
+ calls advance_random_step once (before the loop), then key_random_stream( 
+ pCell->ID ) before working on each cell. Unkeyed draws come from a stream of 
+ the thread (or of the serial code) for the current step. 
+*/
+
+void philox4x32( const unsigned int* counter , const unsigned int* key , unsigned int* output ); 
+
+class Random_Stream
+{
+ private:
+	unsigned int key[2]; 
+	// draw number (two words), stream key, and step 
+	unsigned int counter[4]; 
+	// the outputs for the current counter, and how many of them are used 
+	unsigned int block[4]; 
+	int used; 
+	
+	bool has_spare_normal; 
+	double spare_normal; 
+	
+ public:
+	// the step and key the stream was last set to 
+	unsigned int step; 
+	unsigned int stream_key; 
+	
+	Random_Stream(); 
+	void set( unsigned long long seed , unsigned int stream_key , unsigned int step ); 
+	
+	unsigned int next_uint32( void ); 
+	// uniform on [0,1), with 53 random bits 
+	double uniform( void ); 
+	double normal( double mean , double standard_deviation ); 
+	
+	// n draws at once: whole counter blocks are generated in one loop 
+	void uniform( double* values , int n ); 
+	void normal( double* values , int n , double mean , double standard_deviation ); 
+	
+	// keeps the streams of different threads on different cache lines 
+	char padding[64]; 
+};
+
+extern bool counter_based_random_numbers; 
+// start a new step of the counter-based streams (serial code only) 
+unsigned int advance_random_step( void ); 
+// draw from the stream of key (usually a cell ID) in the current step, until 
+// keyed again or the step advances 
+void key_random_stream( int key ); 
 std::vector<double> UniformOnUnitSphere( void ); 
 std::vector<double> UniformOnUnitCircle( void ); 
 
@@ -66,6 +66,7 @@
 */
  
 #include "./PhysiCell_settings.h"
+#include "../core/PhysiCell_cell_container.h"
 
 using namespace BioFVM; 
 
@@ -163,6 +164,27 @@ void PhysiCell_Settings::read_from_pugixml( void )
 	if( search_result )
 	{ phenotype_dt = xml_get_my_double_value( search_result ); }
 	
+	// the step scheduler counts in diffusion steps, and can stagger the 
+	// phenotype and mechanics steps by these offsets -- 1.7.2 
+	step_scheduler.set_tick_length( diffusion_dt ); 
+	search_result = node.child( "phenotype_offset" ); 
+	if( search_result )
+	{ step_scheduler.register_stage( "phenotype" , phenotype_dt , xml_get_my_double_value( search_result ) ); }
+	search_result = node.child( "mechanics_offset" ); 
+	if( search_result )
+	{ step_scheduler.register_stage( "mechanics" , mechanics_dt , xml_get_my_double_value( search_result ) ); }
+	
+	// adaptive mechanics steps -- 1.7.2 
+	search_result = node.child( "adaptive_dt_mechanics" ); 
+	if( search_result )
+	{ default_mechanics_options.adaptive_mechanics_dt = xml_get_my_bool_value( search_result ); }
+	search_result = node.child( "max_dt_mechanics" ); 
+	if( search_result )
+	{ default_mechanics_options.max_mechanics_dt = xml_get_my_double_value( search_result ); }
+	search_result = node.child( "max_relative_displacement" ); 
+	if( search_result )
+	{ default_mechanics_options.max_relative_displacement = xml_get_my_double_value( search_result ); }
+	
 	node = node.parent(); 
 	
 	// save options 
@@ -212,6 +234,45 @@ void PhysiCell_Settings::read_from_pugixml( void )
 			cell_division_orientation = LegacyRandomOnUnitSphere; 
 		}
 	
+		// packed (structure-of-arrays) cell-cell mechanics -- 1.7.2 
+		pugi::xml_node node_mechanics = node_options.child( "packed_mechanics" ); 
+		if( node_mechanics )
+		{ default_mechanics_options.use_packed_mechanics = xml_get_my_bool_value( node_mechanics ); }
+		node_mechanics = node_options.child( "verlet_skin" ); 
+		if( node_mechanics )
+		{ default_mechanics_options.verlet_skin = xml_get_my_double_value( node_mechanics ); }
+		node_mechanics = node_options.child( "reorder_interval" ); 
+		if( node_mechanics )
+		{ default_mechanics_options.reorder_interval = xml_get_my_int_value( node_mechanics ); }
+		node_mechanics = node_options.child( "symmetric_forces" ); 
+		if( node_mechanics )
+		{ default_mechanics_options.symmetric_forces = xml_get_my_bool_value( node_mechanics ); }
+		
+		// divide the flagged cells in one parallel batch -- 1.7.2 
+		pugi::xml_node node_divisions = node_options.child( "batched_divisions" ); 
+		if( node_divisions )
+		{ batched_divisions = xml_get_my_bool_value( node_divisions ); }
+		
+		// store only the occupied mechanics voxels -- 1.7.2 
+		pugi::xml_node node_container = node_options.child( "hashed_cell_container" ); 
+		if( node_container )
+		{ hashed_cell_container = xml_get_my_bool_value( node_container ); }
+		
+		// derive the mechanics voxels from their indices -- 1.7.2 
+		pugi::xml_node node_mesh = node_options.child( "implicit_mechanics_mesh" ); 
+		if( node_mesh )
+		{ implicit_mechanics_mesh = xml_get_my_bool_value( node_mesh ); }
+		
+		// per-cell counter-based random streams -- 1.7.2 
+		pugi::xml_node node_random = node_options.child( "counter_based_random_numbers" ); 
+		if( node_random )
+		{ counter_based_random_numbers = xml_get_my_bool_value( node_random ); }
+		
+		// exponential clocks for stochastic transitions -- 1.7.2 
+		pugi::xml_node node_events = node_options.child( "event_driven_transitions" ); 
+		if( node_events )
+		{ event_driven_transitions = xml_get_my_bool_value( node_events ); }
+	
 		// other options can go here, eventually 
 	}
 	
@@ -633,6 +694,14 @@ bool setup_microenvironment_from_XML( pugi::xml_node root_node )
 			xml_get_double_value( node1, "diffusion_coefficient" ); 
 		microenvironment.decay_rates[i] = 
 			xml_get_double_value( node1, "decay_rate" ); 
+		
+		// optional (new in 1.7.2): advance this substrate once every 
+		// diffusion_step_multiple diffusion steps 
+		if( node1.child( "diffusion_step_multiple" ) )
+		{
+			microenvironment.set_diffusion_step_multiple( i , 
+				xml_get_int_value( node1, "diffusion_step_multiple" ) ); 
+		}
 			
 		// now, get the initial value  
 		node1 = xml_find_node( node, "initial_condition" ); 
@@ -858,6 +927,31 @@ bool setup_microenvironment_from_XML( pugi::xml_node root_node )
 	default_microenvironment_options.track_internalized_substrates_in_each_agent 
 		= xml_get_bool_value( node, "track_internalized_substrates_in_each_agent" ); 
 	
+	// new in 1.7.2 (optional): solve for the steady state with multigrid, 
+	// rather than time-stepping 
+	if( node.child( "steady_state_diffusion" ) )
+	{
+		default_microenvironment_options.steady_state_diffusion 
+			= xml_get_bool_value( node, "steady_state_diffusion" ); 
+	}
+	if( node.child( "steady_state_tolerance" ) )
+	{
+		default_microenvironment_options.steady_state_tolerance 
+			= xml_get_double_value( node, "steady_state_tolerance" ); 
+	}
+	if( node.child( "steady_state_max_cycles" ) )
+	{
+		default_microenvironment_options.steady_state_max_cycles 
+			= xml_get_int_value( node, "steady_state_max_cycles" ); 
+	}
+	
+	// new in 1.7.2 (optional): skip quiescent tiles of the mesh in the LOD solvers 
+	if( node.child( "active_region_tolerance" ) )
+	{
+		default_microenvironment_options.active_region_tolerance 
+			= xml_get_double_value( node, "active_region_tolerance" ); 
+	}
+	
 	// not yet supported : read initial conditions 
 	/*
 	// read in initial conditions from an external file 
@@ -82,6 +82,8 @@
 
 #include "../core/PhysiCell_constants.h" 
 #include "../core/PhysiCell_utilities.h"
+#include "../core/PhysiCell_mechanics.h"
+#include "../core/PhysiCell_scheduler.h"
 
 using namespace BioFVM; 
 
@@ -125,6 +127,8 @@ class PhysiCell_Globals
  private:
  public:
 	double current_time = 0.0; 
+	// not used by the sample projects, which schedule their saves as 
+	// step_scheduler stages (1.7.2); kept for older main loops 
 	double next_full_save_time = 0.0; 
 	double next_SVG_save_time = 0.0; 
 	int full_output_index = 0; 
@@ -151,6 +151,23 @@ void display_simulation_status( std::ostream& os )
 		PhysiCell_settings.time_units << ")" << std::endl; 
 		
 	os << "total agents: " << all_cells->size() << std::endl; 
+	cell_pool.display( os ); 
+	
+	// the steps chosen by the adaptive mechanics controller -- 1.7.2 
+	Cell_Container* pContainer = (Cell_Container*) get_default_microenvironment()->agent_container; 
+	if( pContainer )
+	{ pContainer->display_memory_footprint( os ); }
+	if( default_mechanics_options.adaptive_mechanics_dt && pContainer )
+	{
+		os << "mechanics steps: " << pContainer->mechanics_steps_in_interval; 
+		if( pContainer->mechanics_steps_in_interval > 0 )
+		{
+			os << " (dt " << pContainer->min_mechanics_dt_in_interval << " to " 
+				<< pContainer->max_mechanics_dt_in_interval << " " << PhysiCell_settings.time_units << ")"; 
+		}
+		os << std::endl; 
+		pContainer->mechanics_steps_in_interval = 0; 
+	}
 	
 	os << "interval wall time: ";
 	BioFVM::TOC();
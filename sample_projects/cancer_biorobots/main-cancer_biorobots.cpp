@@ -164,6 +164,10 @@ int main( int argc, char* argv[] )
 		report_file<<"simulated time\tnum cells\tnum division\tnum death\twall time"<<std::endl;
 	}	
 	
+	// the output stages of the step scheduler (1.7.2) 
+	int full_save_stage = step_scheduler.register_stage( "full save" , PhysiCell_settings.full_save_interval ); 
+	int SVG_save_stage = step_scheduler.register_stage( "SVG save" , PhysiCell_settings.SVG_save_interval ); 
+	
 	// main loop 
 	
 	try 
@@ -178,15 +182,18 @@ int main( int argc, char* argv[] )
 				PhysiCell_settings.full_save_interval = parameters.doubles("save_interval_after_therapy_start"); // 3.0; 
 				PhysiCell_settings.SVG_save_interval = parameters.doubles("save_interval_after_therapy_start"); // 3.0; 
 				
-				PhysiCell_globals.next_full_save_time = PhysiCell_globals.current_time; 
-				PhysiCell_globals.next_SVG_save_time = PhysiCell_globals.current_time; 
+				step_scheduler.set_period( full_save_stage , PhysiCell_settings.full_save_interval ); 
+				step_scheduler.set_period( SVG_save_stage , PhysiCell_settings.SVG_save_interval ); 
+				step_scheduler.restart( full_save_stage , PhysiCell_globals.current_time ); 
+				step_scheduler.restart( SVG_save_stage , PhysiCell_globals.current_time ); 
 				
 				introduce_biorobots();
 			} 	
 
 			// save data if it's time. 
-			if( fabs( PhysiCell_globals.current_time - PhysiCell_globals.next_full_save_time ) < 0.01 * diffusion_dt )
+			if( step_scheduler.is_due( full_save_stage , PhysiCell_globals.current_time ) )
 			{
+				step_scheduler.start( full_save_stage , PhysiCell_globals.current_time ); 
 				display_simulation_status( std::cout ); 
 				if( PhysiCell_settings.enable_legacy_saves == true )
 				{	
@@ -201,19 +208,18 @@ int main( int argc, char* argv[] )
 				}
 				
 				PhysiCell_globals.full_output_index++; 
-				PhysiCell_globals.next_full_save_time += PhysiCell_settings.full_save_interval;
 			}
 			
 			// save SVG plot if it's time
-			if( fabs( PhysiCell_globals.current_time - PhysiCell_globals.next_SVG_save_time  ) < 0.01 * diffusion_dt )
+			if( step_scheduler.is_due( SVG_save_stage , PhysiCell_globals.current_time ) )
 			{
+				step_scheduler.start( SVG_save_stage , PhysiCell_globals.current_time ); 
 				if( PhysiCell_settings.enable_SVG_saves == true )
 				{	
 					sprintf( filename , "%s/snapshot%08u.svg" , PhysiCell_settings.folder.c_str() , PhysiCell_globals.SVG_output_index ); 
 					SVG_plot( filename , microenvironment, 0.0 , PhysiCell_globals.current_time, cell_coloring_function );
 					
 					PhysiCell_globals.SVG_output_index++; 
-					PhysiCell_globals.next_SVG_save_time  += PhysiCell_settings.SVG_save_interval;
 				}
 			}
 
@@ -163,6 +163,10 @@ int main( int argc, char* argv[] )
 		report_file<<"simulated time\tnum cells\tnum division\tnum death\twall time"<<std::endl;
 	}
 	
+	// the output stages of the step scheduler (1.7.2) 
+	int full_save_stage = step_scheduler.register_stage( "full save" , PhysiCell_settings.full_save_interval ); 
+	int SVG_save_stage = step_scheduler.register_stage( "SVG save" , PhysiCell_settings.SVG_save_interval ); 
+	
 	// main loop 
 	
 	try 
@@ -170,8 +174,9 @@ int main( int argc, char* argv[] )
 		while( PhysiCell_globals.current_time < PhysiCell_settings.max_time + 0.1*diffusion_dt )
 		{
 			// save data if it's time. 
-			if( fabs( PhysiCell_globals.current_time - PhysiCell_globals.next_full_save_time ) < 0.01 * diffusion_dt )
+			if( step_scheduler.is_due( full_save_stage , PhysiCell_globals.current_time ) )
 			{
+				step_scheduler.start( full_save_stage , PhysiCell_globals.current_time ); 
 				display_simulation_status( std::cout ); 
 				if( PhysiCell_settings.enable_legacy_saves == true )
 				{	
@@ -186,19 +191,18 @@ int main( int argc, char* argv[] )
 				}
 				
 				PhysiCell_globals.full_output_index++; 
-				PhysiCell_globals.next_full_save_time += PhysiCell_settings.full_save_interval;
 			}
 			
 			// save SVG plot if it's time
-			if( fabs( PhysiCell_globals.current_time - PhysiCell_globals.next_SVG_save_time  ) < 0.01 * diffusion_dt )
+			if( step_scheduler.is_due( SVG_save_stage , PhysiCell_globals.current_time ) )
 			{
+				step_scheduler.start( SVG_save_stage , PhysiCell_globals.current_time ); 
 				if( PhysiCell_settings.enable_SVG_saves == true )
 				{	
 					sprintf( filename , "%s/snapshot%08u.svg" , PhysiCell_settings.folder.c_str() , PhysiCell_globals.SVG_output_index ); 
 					SVG_plot( filename , microenvironment, 0.0 , PhysiCell_globals.current_time, cell_coloring_function );
 					
 					PhysiCell_globals.SVG_output_index++; 
-					PhysiCell_globals.next_SVG_save_time  += PhysiCell_settings.SVG_save_interval;
 				}
 			}
 			
@@ -69,9 +69,12 @@
 #include <string>
 #include <random>
 #include <chrono>
+#include <algorithm>
+#include <omp.h>
 
 #include "PhysiCell_standard_models.h" 
 #include "PhysiCell_cell.h" 
+#include "../../BioFVM/BioFVM_solvers.h" 
 
 //using namespace PhysiCell;   // bad practice
 
@@ -79,6 +82,16 @@ static PhysiCell::Cell_Definition mycell;
 
 int ncells = 1000000;
 
+// mesh for the diffusion sweep timing: sweep_nodes^3 voxels (we use 400 for production-sized comparisons) 
+int sweep_nodes = 128; 
+int sweep_substrates = 4; 
+int sweep_repeats = 5; 
+
+// cells for the mechanics timing: a ball on a lattice of this spacing (microns) and radius (in lattice sites) 
+double mechanics_spacing = 15.0; 
+int mechanics_sites = 30; 
+int mechanics_repeats = 5; 
+
 int time_custom_vars1()
 {
     std::random_device rd;  //Will be used to obtain a seed for the random number engine
@@ -130,9 +143,998 @@ int time_custom_vars1()
     return 1;
 }
 
+// time each direction of the 3D LOD diffusion solver separately, reported per voxel 
+int time_diffusion_sweeps()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    BioFVM::Microenvironment M; 
+    double width = 10.0 * sweep_nodes; 
+    M.resize_space_uniform( 0.0, width, 0.0, width, 0.0, width, 10.0 ); 
+    M.set_density( 0 , "substrate0" , "dimensionless" , 1e5 , 0.1 ); 
+    for( int q=1; q < sweep_substrates ; q++ )
+    { M.add_density( "substrate" + std::to_string(q) , "dimensionless" , 1e3 * q , 0.01 ); }
+    for( unsigned int n=0; n < M.number_of_voxels() ; n++ )
+    {
+        for( int q=0; q < sweep_substrates ; q++ )
+        { M(n)[q] = (n % 101) * 0.01; }
+    }
+    std::cout << "mesh: " << sweep_nodes << "^3 voxels, " << sweep_substrates << " substrates" << std::endl;
+
+    double dt = 0.01; 
+    const char* names[3] = { "x" , "y" , "z" }; 
+    for( int blocked=0; blocked <= 1 ; blocked++ )
+    {
+        M.blocked_diffusion_sweeps = (bool) blocked; 
+        for( int direction=0; direction < 3 ; direction++ )
+        {
+            // warm up (and set up the solver) 
+            BioFVM::diffusion_decay_solver__constant_coefficients_LOD_3D_sweep( M , dt , direction ); 
+
+            auto start = std::chrono::steady_clock::now();
+            for( int r=0; r < sweep_repeats ; r++ )
+            { BioFVM::diffusion_decay_solver__constant_coefficients_LOD_3D_sweep( M , dt , direction ); }
+            auto end = std::chrono::steady_clock::now();
+
+            double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(); 
+            std::cout << names[direction] << "-sweep (blocked=" << blocked << "): " 
+                << ns / ( (double) sweep_repeats * M.number_of_voxels() ) << " ns per voxel" << std::endl;
+        }
+    }
+    return 1;
+}
+
+int time_variable_coefficient_diffusion()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    // two copies of the same problem: one for each solver 
+    BioFVM::Microenvironment M[2]; 
+    double width = 10.0 * sweep_nodes; 
+    for( int s=0; s < 2 ; s++ )
+    {
+        M[s].resize_space_uniform( 0.0, width, 0.0, width, 0.0, width, 10.0 ); 
+        M[s].set_density( 0 , "substrate0" , "dimensionless" , 1e5 , 0.1 ); 
+        for( int q=1; q < sweep_substrates ; q++ )
+        { M[s].add_density( "substrate" + std::to_string(q) , "dimensionless" , 1e3 * q , 0.01 ); }
+        for( unsigned int n=0; n < M[s].number_of_voxels() ; n++ )
+        {
+            for( int q=0; q < sweep_substrates ; q++ )
+            { M[s](n)[q] = (n % 101) * 0.01; }
+        }
+    }
+    M[1].diffusion_decay_solver = BioFVM::diffusion_decay_solver__variable_coefficients_LOD_3D; 
+    std::cout << "mesh: " << sweep_nodes << "^3 voxels, " << sweep_substrates << " substrates (uniform coefficients)" << std::endl;
+
+    double dt = 0.01; 
+    double seconds[2]; 
+    const char* names[2] = { "constant" , "variable" }; 
+    for( int s=0; s < 2 ; s++ )
+    {
+        // warm up (set up or factor) 
+        M[s].simulate_diffusion_decay( dt ); 
+
+        auto start = std::chrono::steady_clock::now();
+        for( int r=0; r < sweep_repeats ; r++ )
+        { M[s].simulate_diffusion_decay( dt ); }
+        auto end = std::chrono::steady_clock::now();
+
+        seconds[s] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9 / sweep_repeats; 
+        std::cout << names[s] << " coefficients: " << seconds[s] << " seconds per step" << std::endl;
+    }
+    
+    double max_difference = 0.0; 
+    for( unsigned int n=0; n < M[0].number_of_voxels() ; n++ )
+    {
+        for( int q=0; q < sweep_substrates ; q++ )
+        { max_difference = std::max( max_difference , fabs( M[0](n)[q] - M[1](n)[q] ) ); }
+    }
+    std::cout << "variable / constant time: " << seconds[1] / seconds[0] 
+        << " (max difference " << max_difference << ")" << std::endl;
+    return 1;
+}
+
+int time_multirate_diffusion()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    // one fast substrate and five slow ones; the slow ones take 10x larger steps in M[1] 
+    int number_of_substrates = 6; 
+    BioFVM::Microenvironment M[2]; 
+    double width = 10.0 * sweep_nodes; 
+    for( int s=0; s < 2 ; s++ )
+    {
+        M[s].resize_space_uniform( 0.0, width, 0.0, width, 0.0, width, 10.0 ); 
+        M[s].set_density( 0 , "substrate0" , "dimensionless" , 1e5 , 0.1 ); 
+        for( int q=1; q < number_of_substrates ; q++ )
+        { M[s].add_density( "substrate" + std::to_string(q) , "dimensionless" , 10.0 * q , 0.01 ); }
+        M[s].set_density_layout( BioFVM::density_layout_substrate_major ); 
+    }
+    for( int q=1; q < number_of_substrates ; q++ )
+    { M[1].set_diffusion_step_multiple( q , 10 ); }
+    std::cout << "mesh: " << sweep_nodes << "^3 voxels, " << number_of_substrates << " substrates" << std::endl;
+
+    double dt = 0.01; 
+    int steps = 10; 
+    double seconds[2]; 
+    const char* names[2] = { "single rate" , "multirate" }; 
+    for( int s=0; s < 2 ; s++ )
+    {
+        M[s].simulate_diffusion_decay( dt ); 
+        
+        auto start = std::chrono::steady_clock::now();
+        for( int r=0; r < steps ; r++ )
+        { M[s].simulate_diffusion_decay( dt ); }
+        auto end = std::chrono::steady_clock::now();
+
+        seconds[s] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9 / steps; 
+        std::cout << names[s] << ": " << seconds[s] << " seconds per step" << std::endl;
+    }
+    std::cout << "speedup: " << seconds[0] / seconds[1] << std::endl;
+    return 1;
+}
+
+int time_active_region_diffusion()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    // a small blob in an otherwise empty domain; M[1] skips the quiescent tiles 
+    BioFVM::Microenvironment M[2]; 
+    double width = 10.0 * sweep_nodes; 
+    for( int s=0; s < 2 ; s++ )
+    {
+        M[s].resize_space_uniform( 0.0, width, 0.0, width, 0.0, width, 10.0 ); 
+        M[s].set_density( 0 , "substrate0" , "dimensionless" , 1e3 , 0.1 ); 
+        for( int q=1; q < sweep_substrates ; q++ )
+        { M[s].add_density( "substrate" + std::to_string(q) , "dimensionless" , 1e2 * q , 0.01 ); }
+        for( unsigned int n=0; n < M[s].number_of_voxels() ; n++ )
+        {
+            std::vector<double>& center = M[s].mesh.voxels[n].center; 
+            double r2 = 0.0; 
+            for( int d=0; d < 3 ; d++ )
+            { r2 += (center[d] - 0.25*width) * (center[d] - 0.25*width); }
+            for( int q=0; q < sweep_substrates ; q++ )
+            { M[s](n)[q] = exp( -r2 / 2500.0 ); }
+        }
+    }
+    M[1].active_region_tolerance = 1e-8; 
+    std::cout << "mesh: " << sweep_nodes << "^3 voxels, " << sweep_substrates << " substrates, tolerance " 
+        << M[1].active_region_tolerance << std::endl;
+
+    double dt = 0.01; 
+    int steps = 20; 
+    double seconds[2]; 
+    const char* names[2] = { "every voxel" , "active region" }; 
+    for( int s=0; s < 2 ; s++ )
+    {
+        M[s].simulate_diffusion_decay( dt ); 
+        
+        auto start = std::chrono::steady_clock::now();
+        for( int r=0; r < steps ; r++ )
+        { M[s].simulate_diffusion_decay( dt ); }
+        auto end = std::chrono::steady_clock::now();
+
+        seconds[s] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9 / steps; 
+        std::cout << names[s] << ": " << seconds[s] << " seconds per step" << std::endl;
+    }
+    
+    double max_difference = 0.0; 
+    for( unsigned int n=0; n < M[0].number_of_voxels() ; n++ )
+    {
+        for( int q=0; q < sweep_substrates ; q++ )
+        { max_difference = std::max( max_difference , fabs( M[0](n)[q] - M[1](n)[q] ) ); }
+    }
+    std::cout << "voxels skipped: " << M[1].mean_skipped_voxel_fraction() << " on average, " 
+        << M[1].skipped_voxel_fraction() << " on the last step" << std::endl; 
+    std::cout << "speedup: " << seconds[0] / seconds[1] << " (max difference " << max_difference << ")" << std::endl;
+    return 1;
+}
+
+// one step of the LOD solver and of the two DCT solvers, on meshes of 64^3, 
+// 100^3 (not a power of two) and sweep_nodes^3 voxels 
+int time_dct_diffusion()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    int sizes[3] = { 64 , 100 , sweep_nodes }; 
+    int steps = 3; 
+    double dt = 0.01; 
+    void (*solvers[3])( BioFVM::Microenvironment& , double ) = { 
+        BioFVM::diffusion_decay_solver__constant_coefficients_LOD_3D , 
+        BioFVM::diffusion_decay_solver__constant_coefficients_DCT , 
+        BioFVM::diffusion_decay_solver__constant_coefficients_DCT_exponential }; 
+    const char* names[3] = { "LOD" , "DCT" , "DCT exponential" }; 
+    for( int m=0; m < 3 ; m++ )
+    {
+        std::cout << "mesh: " << sizes[m] << "^3 voxels, " << sweep_substrates << " substrates" << std::endl;
+        double seconds[3]; 
+        for( int s=0; s < 3 ; s++ )
+        {
+            BioFVM::Microenvironment M; 
+            double width = 10.0 * sizes[m]; 
+            M.resize_space_uniform( 0.0, width, 0.0, width, 0.0, width, 10.0 ); 
+            M.set_density( 0 , "substrate0" , "dimensionless" , 1e5 , 0.1 ); 
+            for( int q=1; q < sweep_substrates ; q++ )
+            { M.add_density( "substrate" + std::to_string(q) , "dimensionless" , 1e3 * q , 0.01 ); }
+            for( unsigned int n=0; n < M.number_of_voxels() ; n++ )
+            {
+                for( int q=0; q < sweep_substrates ; q++ )
+                { M(n)[q] = (n % 101) * 0.01; }
+            }
+            M.diffusion_decay_solver = solvers[s]; 
+            M.simulate_diffusion_decay( dt ); 
+            
+            auto start = std::chrono::steady_clock::now();
+            for( int r=0; r < steps ; r++ )
+            { M.simulate_diffusion_decay( dt ); }
+            auto end = std::chrono::steady_clock::now();
+            seconds[s] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9 / steps; 
+            std::cout << names[s] << ": " << seconds[s] << " seconds per step" << std::endl;
+        }
+        std::cout << "DCT / LOD: " << seconds[1] / seconds[0] << ", exponential / LOD: " << seconds[2] / seconds[0] << std::endl; 
+    }
+    return 1;
+}
+
+// a dense ball of cells on a jittered lattice, in its own microenvironment 
+// (by default just large enough for the ball, with 20 micron voxels) 
+PhysiCell::Cell_Container* create_mechanics_ball( BioFVM::Microenvironment& M , double width = 0.0 , double dx = 20.0 )
+{
+    if( width <= 0.0 )
+    { width = mechanics_spacing * ( mechanics_sites + 2 ); }
+    M.resize_space_uniform( -width, width, -width, width, -width, width, dx ); 
+    BioFVM::set_default_microenvironment( &M ); 
+    PhysiCell::Cell_Container* cell_container = PhysiCell::create_cell_container_for_microenvironment( M, 30.0 );
+    
+    std::vector< std::vector<double> > sites; 
+    for( int i=-mechanics_sites; i <= mechanics_sites ; i++ )
+    {
+        for( int j=-mechanics_sites; j <= mechanics_sites ; j++ )
+        {
+            for( int k=-mechanics_sites; k <= mechanics_sites ; k++ )
+            {
+                if( i*i + j*j + k*k > mechanics_sites*mechanics_sites )
+                { continue; }
+                // jitter the lattice a little so that the distances differ 
+                sites.push_back( { mechanics_spacing * ( i + 0.01 * (j % 7) ) , 
+                    mechanics_spacing * ( j + 0.01 * (k % 5) ) , mechanics_spacing * ( k + 0.01 * (i % 3) ) } ); 
+            }
+        }
+    }
+    // cells that are neighbors in space are usually not neighbors in memory 
+    std::mt19937 gen( 42 ); 
+    std::shuffle( sites.begin() , sites.end() , gen ); 
+    for( unsigned int n=0; n < sites.size() ; n++ )
+    {
+        PhysiCell::Cell* pCell = PhysiCell::create_cell(); 
+        pCell->assign_position( sites[n] ); 
+        // record the interaction distance in the new voxel, as the phenotype step does 
+        pCell->set_total_volume( pCell->phenotype.volume.total ); 
+    }
+    std::cout << "ncells = " << sites.size() << std::endl;
+    return cell_container; 
+}
+
+void delete_mechanics_ball( PhysiCell::Cell_Container* cell_container )
+{
+    std::vector<PhysiCell::Cell*>& cells = *PhysiCell::all_cells; 
+    while( cells.size() > 0 )
+    { PhysiCell::delete_cell( cells.back() ); }
+    BioFVM::set_default_microenvironment( NULL ); 
+}
+
+// one mechanics step as in update_all_cells: velocities, positions, and the voxel lists 
+void mechanics_step( PhysiCell::Cell_Container* cell_container , bool packed , double dt )
+{
+    std::vector<PhysiCell::Cell*>& cells = *PhysiCell::all_cells; 
+    int n = cells.size(); 
+    if( packed )
+    { cell_container->mechanics_engine.pack( *cell_container , cells ); }
+    #pragma omp parallel for 
+    for( int i=0; i < n ; i++ )
+    {
+        cells[i]->velocity.assign( 3 , 0.0 ); 
+        PhysiCell::standard_update_cell_velocity( cells[i] , cells[i]->phenotype , dt ); 
+    }
+    cell_container->mechanics_engine.release(); 
+    
+    if( dt == 0.0 )
+    { return; }
+    #pragma omp parallel for 
+    for( int i=0; i < n ; i++ )
+    { cells[i]->update_position( dt ); }
+    cell_container->rebuild_agent_grid(); 
+}
+
+// cell-cell forces for a dense ball of cells, with and without the packed mechanics kernel 
+int time_packed_mechanics()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    static BioFVM::Microenvironment M; 
+    PhysiCell::Cell_Container* cell_container = create_mechanics_ball( M ); 
+    std::vector<PhysiCell::Cell*>& cells = *PhysiCell::all_cells; 
+    int n = cells.size(); 
+    // build the neighbor lists every step, as a fresh step would 
+    double skin = PhysiCell::default_mechanics_options.verlet_skin; 
+    PhysiCell::default_mechanics_options.verlet_skin = 0.0; 
+
+    double seconds[2]; 
+    std::vector<double> velocities[2]; 
+    const char* names[2] = { "add_potentials" , "packed" }; 
+    for( int packed=0; packed <= 1 ; packed++ )
+    {
+        auto start = std::chrono::steady_clock::now();
+        for( int r=0; r < mechanics_repeats ; r++ )
+        { mechanics_step( cell_container , packed , 0.0 ); }
+        auto end = std::chrono::steady_clock::now();
+        
+        seconds[packed] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9 / mechanics_repeats; 
+        std::cout << names[packed] << ": " << seconds[packed] << " seconds per step" << std::endl;
+        for( int i=0; i < n ; i++ )
+        {
+            velocities[packed].insert( velocities[packed].end() , cells[i]->velocity.begin() , cells[i]->velocity.end() ); 
+            velocities[packed].push_back( cells[i]->state.simple_pressure ); 
+        }
+    }
+    PhysiCell::default_mechanics_options.verlet_skin = skin; 
+    
+    double max_difference = 0.0; 
+    double max_value = 0.0; 
+    for( unsigned int i=0; i < velocities[0].size() ; i++ )
+    {
+        max_difference = std::max( max_difference , fabs( velocities[0][i] - velocities[1][i] ) ); 
+        max_value = std::max( max_value , fabs( velocities[0][i] ) ); 
+    }
+    std::cout << "speedup: " << seconds[0] / seconds[1] << " (max difference " << max_difference 
+        << " in velocities and pressures up to " << max_value << ")" << std::endl;
+
+    delete_mechanics_ball( cell_container ); 
+    return 1;
+}
+
+// relax the ball for a while, rebuilding the neighbor lists every step or only as needed 
+int time_verlet_lists()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    double dt = 0.1; 
+    double skins[2] = { 0.0 , PhysiCell::default_mechanics_options.verlet_skin }; 
+    double seconds[2]; 
+    std::vector<double> positions[2]; 
+    for( int s=0; s < 2 ; s++ )
+    {
+        static BioFVM::Microenvironment M; 
+        PhysiCell::Cell_Container* cell_container = create_mechanics_ball( M ); 
+        PhysiCell::default_mechanics_options.verlet_skin = skins[s]; 
+        
+        auto start = std::chrono::steady_clock::now();
+        for( int r=0; r < 10*mechanics_repeats ; r++ )
+        { mechanics_step( cell_container , true , dt ); }
+        auto end = std::chrono::steady_clock::now();
+        
+        seconds[s] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9 / ( 10*mechanics_repeats ); 
+        std::cout << "skin " << skins[s] << ": " << seconds[s] << " seconds per step, lists built " 
+            << cell_container->mechanics_engine.number_of_list_builds() << " times in " 
+            << cell_container->mechanics_engine.number_of_packed_steps() << " steps" << std::endl;
+        
+        // compare by ID, since both runs create the cells in the same order 
+        std::vector<PhysiCell::Cell*>& cells = *PhysiCell::all_cells; 
+        positions[s].resize( 3*cells.size() ); 
+        int first_ID = cells[0]->ID; 
+        for( unsigned int i=0; i < cells.size() ; i++ )
+        {
+            for( int d=0; d < 3 ; d++ )
+            { positions[s][ 3*(cells[i]->ID - first_ID) + d ] = cells[i]->position[d]; }
+        }
+        delete_mechanics_ball( cell_container ); 
+    }
+    PhysiCell::default_mechanics_options.verlet_skin = skins[1]; 
+    
+    double max_difference = 0.0; 
+    for( unsigned int i=0; i < positions[0].size() ; i++ )
+    { max_difference = std::max( max_difference , fabs( positions[0][i] - positions[1][i] ) ); }
+    std::cout << "speedup: " << seconds[0] / seconds[1] << " (max position difference " << max_difference << ")" << std::endl;
+    return 1;
+}
+
+// move the cells to their new mechanics voxels: one by one, or with the parallel rebuild. 
+// The two alternate on the same cells, so that both see the same memory layout. 
+int time_agent_grid_rebuild()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    static BioFVM::Microenvironment M; 
+    PhysiCell::Cell_Container* cell_container = create_mechanics_ball( M ); 
+    std::vector<PhysiCell::Cell*>& cells = *PhysiCell::all_cells; 
+    int n = cells.size(); 
+
+    double dt = 0.1; 
+    double seconds[2] = { 0.0 , 0.0 }; 
+    int misplaced[2] = { 0 , 0 }; 
+    const char* names[2] = { "update_voxel_in_container" , "rebuild_agent_grid" }; 
+    for( int r=0; r < 20*mechanics_repeats ; r++ )
+    {
+        int s = r % 2; 
+        mechanics_step( cell_container , true , 0.0 ); 
+        // larger steps, so that more cells change voxels 
+        #pragma omp parallel for 
+        for( int i=0; i < n ; i++ )
+        { cells[i]->update_position( 10.0 * dt ); }
+        
+        auto start = std::chrono::steady_clock::now();
+        if( s == 0 )
+        {
+            for( int i=0; i < n ; i++ )
+            { cells[i]->update_voxel_in_container(); }
+        }
+        else
+        { cell_container->rebuild_agent_grid(); }
+        auto end = std::chrono::steady_clock::now();
+        seconds[s] += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9 / ( 10*mechanics_repeats ); 
+        
+        // every cell should be listed once, in the voxel it is in 
+        int listed = 0; 
+        for( unsigned int v=0; v < cell_container->agent_grid.size() ; v++ )
+        {
+            for( unsigned int k=0; k < cell_container->agent_grid[v].size() ; k++ )
+            {
+                PhysiCell::Cell* pCell = cell_container->agent_grid[v][k]; 
+                misplaced[s] += ( pCell->get_current_mechanics_voxel_index() != (int) v || 
+                    cell_container->underlying_mesh.nearest_voxel_index( pCell->position ) != (int) v ); 
+                listed++; 
+            }
+        }
+        misplaced[s] += abs( listed - n ); 
+    }
+    for( int s=0; s < 2 ; s++ )
+    { std::cout << names[s] << ": " << seconds[s] << " seconds per step (" << misplaced[s] << " misplaced cells)" << std::endl; }
+    std::cout << "speedup: " << seconds[0] / seconds[1] << " on " << omp_get_max_threads() << " threads" << std::endl;
+    
+    delete_mechanics_ball( cell_container ); 
+    return 1;
+}
+
+// loop throughput over all_cells before and after sorting the cells along a space-filling curve 
+int time_space_filling_curve_order()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    static BioFVM::Microenvironment M; 
+    PhysiCell::Cell_Container* cell_container = create_mechanics_ball( M ); 
+    std::vector<PhysiCell::Cell*>& cells = *PhysiCell::all_cells; 
+    int n = cells.size(); 
+    double skin = PhysiCell::default_mechanics_options.verlet_skin; 
+    PhysiCell::default_mechanics_options.verlet_skin = 0.0; 
+
+    double seconds[2]; 
+    std::vector<double> velocities[2]; 
+    const char* names[2] = { "creation order" , "Morton order" }; 
+    for( int sorted=0; sorted <= 1 ; sorted++ )
+    {
+        double sort_seconds = 0.0; 
+        if( sorted )
+        {
+            auto start = std::chrono::steady_clock::now();
+            cell_container->reorder_all_cells(); 
+            auto end = std::chrono::steady_clock::now();
+            sort_seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9; 
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        for( int r=0; r < mechanics_repeats ; r++ )
+        { mechanics_step( cell_container , true , 0.0 ); }
+        auto end = std::chrono::steady_clock::now();
+        
+        seconds[sorted] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9 / mechanics_repeats; 
+        std::cout << names[sorted] << ": " << n / seconds[sorted] << " cells per second in the mechanics loop"; 
+        if( sorted )
+        { std::cout << " (sorting took " << sort_seconds << " seconds)"; }
+        std::cout << std::endl; 
+        
+        // compare by ID, since the sort changed the order 
+        velocities[sorted].resize( 3*n ); 
+        int first_ID = cells[0]->ID; 
+        for( int i=0; i < n ; i++ )
+        { first_ID = std::min( first_ID , cells[i]->ID ); }
+        for( int i=0; i < n ; i++ )
+        {
+            for( int d=0; d < 3 ; d++ )
+            { velocities[sorted][ 3*(cells[i]->ID - first_ID) + d ] = cells[i]->velocity[d]; }
+        }
+    }
+    PhysiCell::default_mechanics_options.verlet_skin = skin; 
+    
+    int wrong_indices = 0; 
+    for( int i=0; i < n ; i++ )
+    { wrong_indices += ( cells[i]->index != i ); }
+    double max_difference = 0.0; 
+    for( unsigned int i=0; i < velocities[0].size() ; i++ )
+    { max_difference = std::max( max_difference , fabs( velocities[0][i] - velocities[1][i] ) ); }
+    std::cout << "speedup: " << seconds[0] / seconds[1] << " (max velocity difference " << max_difference 
+        << ", " << wrong_indices << " wrong indices)" << std::endl;
+
+    delete_mechanics_ball( cell_container ); 
+    return 1;
+}
+
+// cell-cell forces evaluated from both sides of every pair, or once per pair (Newton's third law) 
+int time_symmetric_forces()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    static BioFVM::Microenvironment M; 
+    PhysiCell::Cell_Container* cell_container = create_mechanics_ball( M ); 
+    std::vector<PhysiCell::Cell*>& cells = *PhysiCell::all_cells; 
+    int n = cells.size(); 
+
+    double seconds[2]; 
+    std::vector<double> velocities[2]; 
+    const char* names[2] = { "full lists" , "symmetric pairs" }; 
+    // the symmetric pass writes to the neighbors, which is only cheap when they are near in memory 
+    cell_container->reorder_all_cells(); 
+    for( int symmetric=0; symmetric <= 1 ; symmetric++ )
+    {
+        PhysiCell::default_mechanics_options.symmetric_forces = symmetric; 
+        // the first step builds the lists; time the steps that reuse them 
+        mechanics_step( cell_container , true , 0.0 ); 
+        auto start = std::chrono::steady_clock::now();
+        for( int r=0; r < mechanics_repeats ; r++ )
+        { mechanics_step( cell_container , true , 0.0 ); }
+        auto end = std::chrono::steady_clock::now();
+        
+        seconds[symmetric] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9 / mechanics_repeats; 
+        std::cout << names[symmetric] << ": " << seconds[symmetric] << " seconds per step" << std::endl;
+        for( int i=0; i < n ; i++ )
+        {
+            velocities[symmetric].insert( velocities[symmetric].end() , cells[i]->velocity.begin() , cells[i]->velocity.end() ); 
+            velocities[symmetric].push_back( cells[i]->state.simple_pressure ); 
+        }
+    }
+    PhysiCell::default_mechanics_options.symmetric_forces = false; 
+    
+    double max_difference = 0.0; 
+    double max_value = 0.0; 
+    for( unsigned int i=0; i < velocities[0].size() ; i++ )
+    {
+        max_difference = std::max( max_difference , fabs( velocities[0][i] - velocities[1][i] ) ); 
+        max_value = std::max( max_value , fabs( velocities[0][i] ) ); 
+    }
+    std::cout << "speedup: " << seconds[0] / seconds[1] << " (max difference " << max_difference 
+        << " in velocities and pressures up to " << max_value << ")" << std::endl;
+
+    delete_mechanics_ball( cell_container ); 
+    return 1;
+}
+
+// relax the compressed ball for a while with the fixed mechanics step, or with the adaptive one 
+int time_adaptive_mechanics_dt()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    double mechanics_dt = 0.1; 
+    double diffusion_dt = 0.01; 
+    double max_time = 10.0; 
+    double seconds[2]; 
+    int steps[2]; 
+    std::vector<double> positions[2]; 
+    const char* names[2] = { "fixed" , "adaptive" }; 
+    for( int adaptive=0; adaptive <= 1 ; adaptive++ )
+    {
+        static BioFVM::Microenvironment M; 
+        PhysiCell::Cell_Container* cell_container = create_mechanics_ball( M ); 
+        std::vector<PhysiCell::Cell*>& cells = *PhysiCell::all_cells; 
+        int n = cells.size(); 
+        
+        double t = 0.0; 
+        double dt = mechanics_dt; 
+        double min_dt = max_time; 
+        double max_dt = 0.0; 
+        steps[adaptive] = 0; 
+        auto start = std::chrono::steady_clock::now();
+        while( t < max_time - 1e-9 )
+        {
+            if( adaptive == 0 )
+            {
+                mechanics_step( cell_container , true , dt ); 
+                t += dt; 
+            }
+            else
+            {
+                // as in update_all_cells: the next step comes from the new velocities 
+                cell_container->mechanics_engine.pack( *cell_container , cells ); 
+                #pragma omp parallel for 
+                for( int i=0; i < n ; i++ )
+                {
+                    cells[i]->velocity.assign( 3 , 0.0 ); 
+                    PhysiCell::standard_update_cell_velocity( cells[i] , cells[i]->phenotype , dt ); 
+                }
+                cell_container->mechanics_engine.release(); 
+                double next_dt = cell_container->choose_mechanics_dt( dt , mechanics_dt , diffusion_dt ); 
+                #pragma omp parallel for 
+                for( int i=0; i < n ; i++ )
+                { cells[i]->update_position( dt ); }
+                cell_container->rebuild_agent_grid(); 
+                min_dt = std::min( min_dt , dt ); 
+                max_dt = std::max( max_dt , dt ); 
+                t += dt; 
+                // end on max_time 
+                dt = std::min( next_dt , max_time - t ); 
+            }
+            steps[adaptive]++; 
+        }
+        auto end = std::chrono::steady_clock::now();
+        seconds[adaptive] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9; 
+        
+        std::cout << names[adaptive] << ": " << steps[adaptive] << " steps in " << seconds[adaptive] << " seconds"; 
+        if( adaptive )
+        { std::cout << " (dt from " << min_dt << " to " << max_dt << ")"; }
+        std::cout << std::endl; 
+        
+        positions[adaptive].resize( 3*n ); 
+        int first_ID = cells[0]->ID; 
+        for( int i=0; i < n ; i++ )
+        {
+            for( int d=0; d < 3 ; d++ )
+            { positions[adaptive][ 3*(cells[i]->ID - first_ID) + d ] = cells[i]->position[d]; }
+        }
+        delete_mechanics_ball( cell_container ); 
+    }
+    
+    double max_difference = 0.0; 
+    for( unsigned int i=0; i < positions[0].size() ; i++ )
+    { max_difference = std::max( max_difference , fabs( positions[0][i] - positions[1][i] ) ); }
+    std::cout << "speedup: " << seconds[0] / seconds[1] << " (max position difference " << max_difference << ")" << std::endl;
+    return 1;
+}
+
+// one round of divisions of every cell in the ball, one at a time and in one parallel batch 
+int time_batched_divisions()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    double seconds[2]; 
+    double volumes[2]; 
+    const char* names[2] = { "serial" , "batched" }; 
+    bool batched = PhysiCell::batched_divisions; 
+    for( int b=0; b <= 1 ; b++ )
+    {
+        static BioFVM::Microenvironment M; 
+        PhysiCell::Cell_Container* cell_container = create_mechanics_ball( M ); 
+        std::vector<PhysiCell::Cell*>& cells = *PhysiCell::all_cells; 
+        int n = cells.size(); 
+        for( int i=0; i < n ; i++ )
+        { cells[i]->flag_for_division(); }
+        
+        PhysiCell::batched_divisions = ( b == 1 ); 
+        auto start = std::chrono::steady_clock::now();
+        cell_container->divide_flagged_cells(); 
+        auto end = std::chrono::steady_clock::now();
+        seconds[b] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9; 
+        
+        // every cell should be in the agent grid once 
+        unsigned int registered = 0; 
+        for( unsigned int v=0; v < cell_container->agent_grid.size() ; v++ )
+        { registered += cell_container->agent_grid[v].size(); }
+        volumes[b] = 0.0; 
+        for( unsigned int i=0; i < cells.size() ; i++ )
+        { volumes[b] += cells[i]->phenotype.volume.total; }
+        std::cout << names[b] << ": " << cells.size() << " cells (" << registered << " in the agent grid) in " 
+            << seconds[b] << " seconds" << std::endl; 
+        delete_mechanics_ball( cell_container ); 
+    }
+    PhysiCell::batched_divisions = batched; 
+    
+    std::cout << "speedup: " << seconds[0] / seconds[1] << " (total volume difference " 
+        << fabs( volumes[0] - volumes[1] ) << ")" << std::endl;
+    return 1;
+}
+
+// cells that are created and deleted in rounds, with new/delete and with the cell pool 
+int time_cell_pool()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    static BioFVM::Microenvironment M; 
+    M.resize_space_uniform( -100, 100, -100, 100, -100, 100, 20.0 ); 
+    BioFVM::set_default_microenvironment( &M ); 
+    int n = 100000; 
+    int rounds = 5; 
+    std::vector<PhysiCell::Cell*> cells( n ); 
+    
+    double seconds[2]; 
+    const char* names[2] = { "new/delete" , "pool" }; 
+    for( int pooled=0; pooled <= 1 ; pooled++ )
+    {
+        auto start = std::chrono::steady_clock::now();
+        for( int r=0; r < rounds ; r++ )
+        {
+            for( int i=0; i < n ; i++ )
+            { cells[i] = pooled ? PhysiCell::cell_pool.allocate() : new PhysiCell::Cell; }
+            for( int i=0; i < n ; i++ )
+            {
+                if( pooled )
+                { PhysiCell::cell_pool.release( cells[i] ); }
+                else
+                { delete cells[i]; }
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        seconds[pooled] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9; 
+        std::cout << names[pooled] << ": " << rounds << " rounds of " << n << " cells in " << seconds[pooled] << " seconds" << std::endl; 
+    }
+    PhysiCell::cell_pool.display( std::cout ); 
+    BioFVM::set_default_microenvironment( NULL ); 
+    
+    std::cout << "speedup: " << seconds[0] / seconds[1] << std::endl;
+    return 1;
+}
+
+// the ball in a domain four times as wide, with a dense and with a hashed agent grid 
+int time_hashed_cell_container()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    double width = 4.0 * mechanics_spacing * ( mechanics_sites + 2 ); 
+    double skin = PhysiCell::default_mechanics_options.verlet_skin; 
+    PhysiCell::default_mechanics_options.verlet_skin = 0.0; 
+    bool hashed = PhysiCell::hashed_cell_container; 
+    
+    double seconds[2]; 
+    double setup_seconds[2]; 
+    std::vector<double> positions[2]; 
+    const char* names[2] = { "dense" , "hashed" }; 
+    // hashed first: the dense grid (and its mesh) leave the heap fragmented 
+    for( int h=1; h >= 0 ; h-- )
+    {
+        PhysiCell::hashed_cell_container = ( h == 1 ); 
+        static BioFVM::Microenvironment M; 
+        auto setup = std::chrono::steady_clock::now();
+        PhysiCell::Cell_Container* cell_container = create_mechanics_ball( M , width , 100.0 ); 
+        std::vector<PhysiCell::Cell*>& cells = *PhysiCell::all_cells; 
+        int n = cells.size(); 
+        
+        auto start = std::chrono::steady_clock::now();
+        for( int r=0; r < mechanics_repeats ; r++ )
+        { mechanics_step( cell_container , true , 0.1 ); }
+        auto end = std::chrono::steady_clock::now();
+        setup_seconds[h] = std::chrono::duration_cast<std::chrono::nanoseconds>(start - setup).count() * 1e-9; 
+        seconds[h] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9; 
+        
+        std::cout << names[h] << ": setup in " << setup_seconds[h] << " seconds, " << mechanics_repeats 
+            << " mechanics steps in " << seconds[h] << " seconds" << std::endl; 
+        cell_container->display_memory_footprint( std::cout ); 
+        
+        positions[h].resize( 3*n ); 
+        int first_ID = cells[0]->ID; 
+        for( int i=0; i < n ; i++ )
+        {
+            for( int d=0; d < 3 ; d++ )
+            { positions[h][ 3*(cells[i]->ID - first_ID) + d ] = cells[i]->position[d]; }
+        }
+        delete_mechanics_ball( cell_container ); 
+    }
+    PhysiCell::hashed_cell_container = hashed; 
+    PhysiCell::default_mechanics_options.verlet_skin = skin; 
+    
+    double max_difference = 0.0; 
+    for( unsigned int i=0; i < positions[0].size() ; i++ )
+    { max_difference = std::max( max_difference , fabs( positions[0][i] - positions[1][i] ) ); }
+    std::cout << "speedup: " << seconds[0] / seconds[1] << " (max position difference " << max_difference << ")" << std::endl;
+    return 1;
+}
+
+// set up a 128^3 Cartesian mesh with stored and with implicit voxels, 
+// then visit every voxel's center and Moore neighbors 
+int time_implicit_mesh()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    int nodes = 128; 
+    double dx = 20.0; 
+    const char* names[2] = { "stored" , "implicit" }; 
+    double checksums[2]; 
+    for( int m=0; m <= 1 ; m++ )
+    {
+        auto setup = std::chrono::steady_clock::now();
+        BioFVM::Cartesian_Mesh mesh; 
+        mesh.implicit_voxels = ( m == 1 ); 
+        mesh.resize_uniform( 0.0 , nodes*dx , 0.0 , nodes*dx , 0.0 , nodes*dx , dx ); 
+        auto start = std::chrono::steady_clock::now();
+        
+        // sum something of every center and neighbor, so that the loop is not optimized away 
+        double checksum = 0.0; 
+        double center[3]; 
+        int moore[26]; 
+        int n_voxels = mesh.number_of_voxels(); 
+        for( int n=0; n < n_voxels ; n++ )
+        {
+            mesh.voxel_center( n , center ); 
+            int number_of_neighbors = mesh.moore_neighbors( n , moore ); 
+            checksum += center[0] + center[1] + center[2] + mesh.voxel_volume( n ); 
+            for( int k=0; k < number_of_neighbors ; k++ )
+            { checksum += moore[k]; }
+        }
+        auto end = std::chrono::steady_clock::now();
+        checksums[m] = checksum; 
+        
+        std::cout << names[m] << ": " << n_voxels << " voxels set up in " 
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(start - setup).count() * 1e-9 << " seconds (" 
+            << mesh.memory_footprint_megabytes() << " MB), visited in " 
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9 << " seconds" << std::endl; 
+    }
+    std::cout << "same centers and neighbors: " << ( checksums[0] == checksums[1] ) << std::endl; 
+    return 1;
+}
+
+// draw 10^7 uniform and normal numbers from the mt19937, and from the 
+// counter-based streams one at a time and in batches 
+int time_random_streams()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    int n = 10000000; 
+    std::vector<double> values( n ); 
+    bool counter_based = PhysiCell::counter_based_random_numbers; 
+    const char* names[3] = { "mt19937" , "counter-based" , "counter-based, batched" }; 
+    for( int m=0; m < 3 ; m++ )
+    {
+        PhysiCell::counter_based_random_numbers = ( m > 0 ); 
+        PhysiCell::SeedRandom( 0 ); 
+        auto start = std::chrono::steady_clock::now();
+        if( m < 2 )
+        {
+            for( int i=0; i < n ; i++ )
+            { values[i] = PhysiCell::UniformRandom(); }
+        }
+        else
+        { PhysiCell::UniformRandom( values.data() , n ); }
+        auto middle = std::chrono::steady_clock::now();
+        if( m < 2 )
+        {
+            for( int i=0; i < n ; i++ )
+            { values[i] = PhysiCell::NormalRandom( 0.0 , 1.0 ); }
+        }
+        else
+        { PhysiCell::NormalRandom( values.data() , n , 0.0 , 1.0 ); }
+        auto end = std::chrono::steady_clock::now();
+        
+        double mean = 0.0; 
+        for( int i=0; i < n ; i++ )
+        { mean += values[i]; }
+        std::cout << names[m] << ": uniform in " 
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(middle - start).count() * 1e-9 << " seconds, normal in " 
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(end - middle).count() * 1e-9 << " seconds (mean " 
+            << mean / n << ")" << std::endl; 
+    }
+    PhysiCell::counter_based_random_numbers = counter_based; 
+    return 1;
+}
+
+// advance the cycle and death models of 20000 slowly cycling phenotypes for 
+// 1000 steps, drawing a random number for every link every step and with 
+// event-driven transitions 
+int time_event_driven_transitions()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    int n = 20000; 
+    int steps = 1000; 
+    double dt = 6.0; 
+    double rate = 1e-4; 
+    double death_rate = 1e-6; 
+    
+    static PhysiCell::Cycle_Model model; 
+    model.name = "slow two-phase cycle"; 
+    model.add_phase( 0 , "A" ); 
+    model.add_phase( 1 , "B" ); 
+    model.add_phase_link( 0 , 1 , NULL ); 
+    model.add_phase_link( 1 , 0 , NULL ); 
+    model.transition_rate( 0 , 1 ) = rate; 
+    model.transition_rate( 1 , 0 ) = rate; 
+    
+    bool event_driven = PhysiCell::event_driven_transitions; 
+    const char* names[2] = { "every step" , "event-driven" }; 
+    double seconds[2]; 
+    for( int m=0; m <= 1 ; m++ )
+    {
+        PhysiCell::event_driven_transitions = ( m == 1 ); 
+        PhysiCell::SeedRandom( 0 ); 
+        std::vector<PhysiCell::Phenotype> phenotypes( n ); 
+        for( int i=0; i < n ; i++ )
+        {
+            phenotypes[i].cycle.sync_to_cycle_model( model ); 
+            phenotypes[i].death.add_death_model( death_rate , &model ); 
+        }
+        
+        int transitions = 0; 
+        int deaths = 0; 
+        auto start = std::chrono::steady_clock::now();
+        for( int s=0; s < steps ; s++ )
+        {
+            for( int i=0; i < n ; i++ )
+            {
+                PhysiCell::Phenotype& phenotype = phenotypes[i]; 
+                if( phenotype.death.dead )
+                { continue; }
+                if( phenotype.death.check_for_death( dt ) )
+                { deaths++; continue; }
+                int phase = phenotype.cycle.data.current_phase_index; 
+                phenotype.cycle.advance_cycle( NULL , phenotype , dt ); 
+                if( phenotype.cycle.data.current_phase_index != phase )
+                { transitions++; }
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        seconds[m] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9; 
+        
+        std::cout << names[m] << ": " << transitions << " transitions and " << deaths << " deaths in " 
+            << seconds[m] << " seconds" << std::endl; 
+    }
+    PhysiCell::event_driven_transitions = event_driven; 
+    
+    std::cout << "speedup: " << seconds[0] / seconds[1] << std::endl;
+    return 1;
+}
+
+// copy a Ki67 (advanced) cell's functions and cycle data, as create_cell and 
+// divide do, 10 times into 100000 cells 
+int time_cycle_model_copies()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+
+    PhysiCell::create_standard_cycle_and_death_models(); 
+    PhysiCell::Cell_Functions functions; 
+    functions.cycle_model = PhysiCell::Ki67_advanced; 
+    PhysiCell::Cycle cycle; 
+    cycle.sync_to_cycle_model( functions.cycle_model ); 
+    
+    int n = 100000; 
+    int rounds = 10; 
+    std::vector<PhysiCell::Cell_Functions> cell_functions( n ); 
+    std::vector<PhysiCell::Cycle> cycles( n ); 
+    auto start = std::chrono::steady_clock::now();
+    for( int r=0; r < rounds ; r++ )
+    {
+        for( int i=0; i < n ; i++ )
+        {
+            cell_functions[i] = functions; 
+            cycles[i] = cycle; 
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    
+    double checksum = 0.0; 
+    for( int i=0; i < n ; i++ )
+    { checksum += cycles[i].data.transition_rate( 0 , 1 ) + cycles[i].model().phases.size(); }
+    std::cout << rounds << " rounds of " << n << " copies in " 
+        << std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9 << " seconds (" 
+        << "sizeof Cell_Functions " << sizeof( PhysiCell::Cell_Functions ) << ", sizeof Cycle " << sizeof( PhysiCell::Cycle ) 
+        << ", checksum " << checksum << ")" << std::endl; 
+    return 1;
+}
+
 int main()
 {
     std::cout << ">>>>>>>>>  Timing tests" << std::endl;
+    time_diffusion_sweeps();
+    time_variable_coefficient_diffusion();
+    time_multirate_diffusion();
+    time_active_region_diffusion();
+    time_dct_diffusion();
+    time_packed_mechanics();
+    time_verlet_lists();
+    time_agent_grid_rebuild();
+    time_space_filling_curve_order();
+    time_symmetric_forces();
+    time_adaptive_mechanics_dt();
+    time_batched_divisions();
+    time_cell_pool();
+    time_hashed_cell_container();
+    time_implicit_mesh();
+    time_random_streams();
+    time_event_driven_transitions();
+    time_cycle_model_copies();
     time_custom_vars1();
 
     return 1;
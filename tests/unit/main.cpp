@@ -67,8 +67,11 @@
 
 #include <iostream>
 #include <string>
+#include <algorithm>
+#include <omp.h>
 #include "PhysiCell_standard_models.h" 
 #include "PhysiCell_cell.h" 
+#include "PhysiCell_scheduler.h" 
 
 //using namespace PhysiCell;   // bad practice
 
@@ -96,10 +99,265 @@ int custom_vars1()
     return 1;
 }
 
+// step a long simulation in diffusion steps: the scheduled stages should run on 
+// exact multiples of their periods, however far the summed time drifts 
+int step_scheduler1()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+    PhysiCell::Step_Scheduler scheduler; 
+    scheduler.set_tick_length( 0.01 ); 
+    int mechanics = scheduler.register_stage( "mechanics" , 0.1 ); 
+    int phenotype = scheduler.register_stage( "phenotype" , 6.0 , 0.05 ); 
+    
+    int steps = 1000000; 
+    int mechanics_runs = 0; 
+    int phenotype_runs = 0; 
+    int tolerance_runs = 0; 
+    int wrong_dt = 0; 
+    double t = 0.0; 
+    double last_tolerance_run = 0.0; 
+    for( int n=0; n < steps ; n++ )
+    {
+        if( scheduler.is_due( mechanics , t ) )
+        {
+            wrong_dt += ( fabs( scheduler.start( mechanics , t ) - 0.1 ) > 1e-12 ); 
+            mechanics_runs++; 
+        }
+        if( scheduler.is_due( phenotype , t ) )
+        {
+            wrong_dt += ( fabs( scheduler.start( phenotype , t ) - 6.0 ) > 1e-12 ); 
+            phenotype_runs++; 
+        }
+        // the old test, with the same drift in t 
+        if( n == 0 || fabs( t - last_tolerance_run - 0.1 ) < 0.001 * 0.1 )
+        {
+            tolerance_runs++; 
+            last_tolerance_run = t; 
+        }
+        t += 0.01; 
+    }
+    std::cout << "mechanics ran " << mechanics_runs << " times (expected " << steps / 10 
+        << "; with tolerances " << tolerance_runs << "), phenotype " << phenotype_runs 
+        << " times (expected " << ( steps - 5 + 599 ) / 600 << "), " << wrong_dt << " wrong step sizes" << std::endl; 
+
+    return 1;
+}
+
+// handles and IDs of cells that are deleted (and whose memory is reused) 
+int cell_handles1()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+    static BioFVM::Microenvironment M; 
+    M.resize_space_uniform( -100, 100, -100, 100, -100, 100, 20.0 ); 
+    BioFVM::set_default_microenvironment( &M ); 
+    PhysiCell::create_cell_container_for_microenvironment( M, 30.0 ); 
+    
+    std::vector<PhysiCell::Cell*> cells; 
+    std::vector<PhysiCell::Cell_Handle> handles; 
+    std::vector<int> IDs; 
+    for( int i=0; i < 3 ; i++ )
+    {
+        cells.push_back( PhysiCell::create_cell() ); 
+        cells[i]->assign_position( 10.0 * i , 0.0 , 0.0 ); 
+        handles.push_back( cells[i]->get_handle() ); 
+        IDs.push_back( cells[i]->ID ); 
+    }
+    
+    // delete the first cell: the last one takes its index, and a new cell takes its memory 
+    PhysiCell::delete_cell( cells[0] ); 
+    PhysiCell::Cell* pNew = PhysiCell::create_cell(); 
+    pNew->assign_position( 0.0 , 10.0 , 0.0 ); 
+    
+    int errors = 0; 
+    errors += ( handles[0].is_stale() == false ); 
+    errors += ( PhysiCell::find_cell_by_ID( IDs[0] ) != NULL ); 
+    errors += ( pNew->get_handle() == handles[0] ); 
+    for( int i=1; i < 3 ; i++ )
+    {
+        errors += ( handles[i].get() != cells[i] ); 
+        errors += ( PhysiCell::find_cell_by_ID( IDs[i] ) != cells[i] ); 
+    }
+    errors += ( PhysiCell::find_cell_by_ID( pNew->ID ) != pNew ); 
+    errors += ( PhysiCell::Cell_Handle().get() != NULL ); 
+    std::cout << "reused the deleted cell's memory: " << ( pNew == cells[0] ) << ", " << errors << " errors" << std::endl; 
+    
+    while( PhysiCell::all_cells->size() > 0 )
+    { PhysiCell::delete_cell( PhysiCell::all_cells->back() ); }
+    BioFVM::set_default_microenvironment( NULL ); 
+    
+    return 1;
+}
+
+// an implicit mesh must match a stored one: centers, volumes, and neighbor order 
+int implicit_mesh1()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+    BioFVM::Cartesian_Mesh stored; 
+    BioFVM::Cartesian_Mesh implicit; 
+    implicit.implicit_voxels = true; 
+    stored.resize( -50, 50, 0, 80, 0, 30, 20, 20, 10 ); 
+    implicit.resize( -50, 50, 0, 80, 0, 30, 20, 20, 10 ); 
+    
+    int errors = ( stored.number_of_voxels() != implicit.number_of_voxels() ) + ( implicit.voxels.size() != 0 ); 
+    int stored_neighbors[26]; 
+    int implicit_neighbors[26]; 
+    for( unsigned int n=0; n < stored.number_of_voxels() ; n++ )
+    {
+        errors += ( stored.voxel_center( n ) != implicit.voxel_center( n ) ); 
+        errors += ( stored.voxel_volume( n ) != implicit.voxel_volume( n ) ); 
+        
+        int count = stored.face_neighbors( n , stored_neighbors ); 
+        errors += ( count != implicit.face_neighbors( n , implicit_neighbors ) ); 
+        errors += !std::equal( stored_neighbors , stored_neighbors + count , implicit_neighbors ); 
+        
+        count = stored.moore_neighbors( n , stored_neighbors ); 
+        errors += ( count != implicit.moore_neighbors( n , implicit_neighbors ) ); 
+        errors += !std::equal( stored_neighbors , stored_neighbors + count , implicit_neighbors ); 
+    }
+    std::cout << stored.number_of_voxels() << " voxels, " << errors << " errors" << std::endl; 
+    
+    return 1;
+}
+
+// Philox4x32-10 known answers (from Random123), batched draws matching single 
+// ones, and per-key streams that do not depend on the number of threads 
+int random_streams1()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+    unsigned int counters[3][4] = { { 0,0,0,0 } , { 0xffffffff,0xffffffff,0xffffffff,0xffffffff } , 
+        { 0x243f6a88,0x85a308d3,0x13198a2e,0x03707344 } }; 
+    unsigned int keys[3][2] = { { 0,0 } , { 0xffffffff,0xffffffff } , { 0xa4093822,0x299f31d0 } }; 
+    unsigned int known[3][4] = { { 0x6627e8d5,0xe169c58d,0xbc57ac4c,0x9b00dbd8 } , 
+        { 0x408f276d,0x41c83b0e,0xa20bc7c6,0x6d5451fd } , { 0xd16cfe09,0x94fdcceb,0x5001e420,0x24126ea1 } }; 
+    int errors = 0; 
+    for( int t=0; t < 3 ; t++ )
+    {
+        unsigned int output[4]; 
+        PhysiCell::philox4x32( counters[t] , keys[t] , output ); 
+        errors += !std::equal( output , output + 4 , known[t] ); 
+    }
+    
+    PhysiCell::Random_Stream single; 
+    PhysiCell::Random_Stream batched; 
+    single.set( 42 , 7 , 3 ); 
+    batched.set( 42 , 7 , 3 ); 
+    std::vector<double> values( 101 ); 
+    batched.uniform(); 
+    batched.uniform( values.data() , 100 ); 
+    batched.normal( values.data() + 100 , 1 , 0.0 , 1.0 ); 
+    single.uniform(); 
+    for( int i=0; i < 100 ; i++ )
+    { errors += ( single.uniform() != values[i] ); }
+    errors += ( single.normal( 0.0 , 1.0 ) != values[100] ); 
+    
+    // each key's draws, with 1 and with 4 threads 
+    bool counter_based = PhysiCell::counter_based_random_numbers; 
+    PhysiCell::counter_based_random_numbers = true; 
+    int threads = omp_get_max_threads(); 
+    std::vector<double> draws[2]; 
+    for( int r=0; r < 2 ; r++ )
+    {
+        omp_set_num_threads( r == 0 ? 1 : 4 ); 
+        PhysiCell::SeedRandom( 0 ); 
+        PhysiCell::advance_random_step(); 
+        draws[r].resize( 3000 ); 
+        #pragma omp parallel for schedule(dynamic) 
+        for( int i=0; i < 1000 ; i++ )
+        {
+            PhysiCell::key_random_stream( i ); 
+            draws[r][3*i] = PhysiCell::UniformRandom(); 
+            PhysiCell::NormalRandom( &draws[r][3*i+1] , 2 , 0.0 , 1.0 ); 
+        }
+    }
+    errors += ( draws[0] != draws[1] ); 
+    omp_set_num_threads( threads ); 
+    PhysiCell::counter_based_random_numbers = counter_based; 
+    std::cout << errors << " errors" << std::endl; 
+    
+    return 1;
+}
+
+bool always_arrested( PhysiCell::Cell* pCell, PhysiCell::Phenotype& phenotype, double dt )
+{ return true; }
+
+// leave a phase with links of rates 2r and r (the latter also arrested) with 
+// event-driven transitions, and check which links were followed, and when 
+int event_driven_transitions1()
+{
+    std::cout << "--------------  " << __FUNCTION__ << " -------------- " << std::endl;
+    double r = 0.01; 
+    double dt = 1.0; 
+    int n = 20000; 
+    
+    static PhysiCell::Cycle_Model models[3]; 
+    bool event_driven = PhysiCell::event_driven_transitions; 
+    PhysiCell::event_driven_transitions = true; 
+    PhysiCell::SeedRandom( 0 ); 
+    int errors = 0; 
+    // model 2: as model 0, but with the rates raised 4-fold at t = t_change, 
+    // which the clocks must pick up mid-phase 
+    double t_change = 50.0; 
+    for( int m=0; m < 3 ; m++ )
+    {
+        PhysiCell::Cycle_Model& model = models[m]; 
+        model.add_phase( 0 , "A" ); 
+        model.add_phase( 1 , "B" ); 
+        model.add_phase( 2 , "C" ); 
+        model.add_phase_link( 0 , 1 , NULL ); 
+        model.add_phase_link( 0 , 2 , m == 1 ? always_arrested : NULL ); 
+        model.transition_rate( 0 , 1 ) = 2.0*r; 
+        model.transition_rate( 0 , 2 ) = r; 
+        
+        int to_B = 0; 
+        double mean_time = 0.0; 
+        for( int i=0; i < n ; i++ )
+        {
+            PhysiCell::Phenotype phenotype; 
+            phenotype.cycle.sync_to_cycle_model( model ); 
+            int steps = 0; 
+            while( phenotype.cycle.data.current_phase_index == 0 )
+            {
+                if( m == 2 && steps == (int) ( t_change / dt ) )
+                {
+                    phenotype.cycle.data.transition_rate( 0 , 1 ) = 8.0*r; 
+                    phenotype.cycle.data.transition_rate( 0 , 2 ) = 4.0*r; 
+                }
+                phenotype.cycle.advance_cycle( NULL , phenotype , dt ); 
+                steps++; 
+            }
+            to_B += ( phenotype.cycle.data.current_phase_index == 1 ); 
+            mean_time += ( steps - 0.5 ) * dt / n; 
+        }
+        // expect 2/3 of the cells to go to B after 1/(3r), or all after 1/(2r), 
+        // or (with the 4-fold rates after t_change) 2/3 of them after 
+        // ( 1 - exp(-3r t_change) )/(3r) + exp(-3r t_change)/(12r) 
+        double expected_fraction = ( m == 1 ) ? 1.0 : 2.0/3.0; 
+        double expected_time = ( m == 1 ) ? 1.0/(2.0*r) : 1.0/(3.0*r); 
+        if( m == 2 )
+        {
+            double survival = exp( -3.0*r*t_change ); 
+            expected_time = ( 1.0 - survival )/(3.0*r) + survival/(12.0*r); 
+        }
+        std::cout << "fraction to B: " << to_B / (double) n << " (expected " << expected_fraction 
+            << "), mean time: " << mean_time << " (expected " << expected_time << ")" << std::endl; 
+        errors += ( fabs( to_B / (double) n - expected_fraction ) > 0.02 ); 
+        errors += ( fabs( mean_time - expected_time ) > 0.05 * expected_time ); 
+    }
+    PhysiCell::event_driven_transitions = event_driven; 
+    std::cout << errors << " errors" << std::endl; 
+    
+    return 1;
+}
+
 int main()
 {
     std::cout << ">>>>>>>>>  Unit tests" << std::endl;
     custom_vars1();
+    step_scheduler1();
+    cell_handles1();
+    implicit_mesh1();
+    random_streams1();
+    event_driven_transitions1();
 
     return 1;
 }
\ No newline at end of file